@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include "arena.h"
+
+// every allocation starts at a multiple of this, enough for any Value or record field
+#define ARENA_ALIGN 8
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define BLOCK_DATA(block) ((char *)(block) + ARENA_ROUND(sizeof(ArenaBlock)))
+
+RC initArena(Arena *arena, size_t blockSize) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->blockSize = blockSize > 0 ? blockSize : ARENA_BLOCK_SIZE;
+    return RC_OK;
+}
+
+static ArenaBlock *newBlock(size_t size) {
+    ArenaBlock *block = (ArenaBlock *)malloc(ARENA_ROUND(sizeof(ArenaBlock)) + size);
+    if (block == NULL) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+// Memory for size bytes that stays valid until the next reset, NULL if out of memory
+void *arenaAlloc(Arena *arena, size_t size) {
+    ArenaBlock *block = arena->current;
+
+    size = ARENA_ROUND(size > 0 ? size : 1);
+    if (block != NULL && block->size - block->used >= size) {
+        void *result = BLOCK_DATA(block) + block->used;
+        block->used += size;
+        return result;
+    }
+
+    // move on to the next block kept from before a reset, or put a new one after the current
+    ArenaBlock *next = block != NULL ? block->next : arena->first;
+    if (next == NULL || next->size < size) {
+        ArenaBlock *fresh = newBlock(size > arena->blockSize ? size : arena->blockSize);
+        if (fresh == NULL) return NULL;
+        fresh->next = next;
+        if (block != NULL) block->next = fresh;
+        else arena->first = fresh;
+        next = fresh;
+    }
+
+    next->used = size;
+    arena->current = next;
+    return BLOCK_DATA(next);
+}
+
+// Release everything allocated so far; the blocks are reused, so this does not depend on
+// how much was allocated
+void resetArena(Arena *arena) {
+    arena->current = arena->first;
+    if (arena->first != NULL) arena->first->used = 0;
+}
+
+void freeArena(Arena *arena) {
+    ArenaBlock *block = arena->first;
+
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
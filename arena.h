@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "dberror.h"
+
+// Bump allocator for short-lived objects. Allocations are carved out of a chain of blocks
+// and are never freed one by one: resetArena makes all of them available again at once,
+// keeping the blocks for the next round, and freeArena gives the blocks back.
+typedef struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size;		// bytes of data after the block header
+	size_t used;
+} ArenaBlock;
+
+typedef struct Arena {
+	ArenaBlock *first;
+	ArenaBlock *current;	// block allocations are served from
+	size_t blockSize;
+} Arena;
+
+#define ARENA_BLOCK_SIZE 4096
+
+// blockSize 0 uses ARENA_BLOCK_SIZE; no memory is taken before the first allocation
+extern RC initArena (Arena *arena, size_t blockSize);
+extern void *arenaAlloc (Arena *arena, size_t size);
+extern void resetArena (Arena *arena);
+extern void freeArena (Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,29 @@
+#ifndef BM_TRACE_H
+#define BM_TRACE_H
+
+#include <stdint.h>
+
+/************************************************************
+ *            page access trace file format                 *
+ ************************************************************/
+/* A trace file starts with one BM_TraceHeader followed by one
+ * BM_TraceRecord per pinPage call, in call order. All fields are
+ * written in the byte order of the machine that recorded them. */
+
+#define BM_TRACE_MAGIC "BMTRACE1"
+#define BM_TRACE_HIT_BIT 0x80000000u  // set in timeDelta when the pin was a hit
+#define BM_TRACE_MAX_DELTA 0x7FFFFFFFu // larger gaps are saturated
+
+typedef struct BM_TraceHeader {
+	char magic[8];
+	int32_t pageSize;
+	int32_t numFrames; // size of the pool that recorded the trace
+	int32_t strategy;  // ReplacementStrategy of that pool
+} BM_TraceHeader;
+
+typedef struct BM_TraceRecord {
+	int32_t pageNum;
+	uint32_t timeDelta; // microseconds since the previous record, plus BM_TRACE_HIT_BIT
+} BM_TraceRecord;
+
+#endif // BM_TRACE_H
@@ -0,0 +1,966 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btree_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+
+/*
+ * Disk-based B+-tree on top of the buffer pool.
+ *
+ * Page 0 of the index file holds BT_Meta, every other page is one node. Leaves hold
+ * sorted entries [key][RID] and are chained left to right; inner nodes hold
+ * num_keys separators and num_keys + 1 children, child i covering the entries in
+ * [separator i-1, separator i). Separators are whole entries, so equal keys of a
+ * non-unique tree can be split over several leaves.
+ * Deletes leave underfull nodes in place; pages are only reused by a bulk build.
+ * The meta page is rewritten whenever the root or the node count changes, and after
+ * every BT_META_FLUSH_CHANGES changes to the entry count.
+ */
+
+#define BT_MAGIC "BTR1"
+#define BT_MAX_KEY_ATTRS 16
+#define BT_MAX_HEIGHT 32
+#define BT_POOL_PAGES 32             // operations pin a few pages at once, the rest caches hot pages
+#define BT_BULK_FILL 90              // percent of a node filled by bulkBuildBtree, leaves room for inserts
+#define BT_META_FLUSH_CHANGES 1024   // entry count changes kept in memory before the meta page is rewritten
+
+typedef struct BT_Meta {
+    char magic[4];
+    int root;                        // page of the root node, -1 for an empty tree
+    int num_nodes;                   // nodes, they occupy pages 1..num_nodes
+    int num_entries;
+    int unique;                      // reject a second entry with an equal key
+    int leaf_capacity;               // entries per leaf
+    int inner_capacity;              // separators per inner node
+    int num_key_attrs;
+    int num_included_attrs;          // stored after the key attributes, not compared
+    DataType key_types[BT_MAX_KEY_ATTRS];
+    int key_lengths[BT_MAX_KEY_ATTRS];
+} BT_Meta;
+
+typedef struct BT_NodeHeader {
+    int is_leaf;
+    int num_keys;                    // entries of a leaf, separators of an inner node
+    int next_leaf;                   // right sibling of a leaf, -1 for the last one
+    int reserved;
+} BT_NodeHeader;
+
+// Open tree
+typedef struct BT_Tree {
+    BM_BufferPool pool;
+    BT_Meta meta;
+    int key_size;                    // bytes of a packed key
+    int entry_size;                  // packed key and RID
+    int key_offsets[BT_MAX_KEY_ATTRS];
+    int key_widths[BT_MAX_KEY_ATTRS];
+    int meta_changes;                // entry count changes since the meta page was written
+} BT_Tree;
+
+// Position of an open cursor, the leaf stays pinned between calls to nextEntry
+typedef struct BT_ScanMgmt {
+    BM_PageHandle leaf;
+    bool leaf_pinned;
+    int index;                       // next entry in leaf
+    char *high;                      // upper bound, NULL if open
+    bool high_inclusive;
+    bool done;
+} BT_ScanMgmt;
+
+#define TREE(handle) ((BT_Tree *)(handle)->mgmtData)
+#define NODE_HEADER(data) ((BT_NodeHeader *)(data))
+#define LEAF_ENTRY(t, data, i) ((data) + sizeof(BT_NodeHeader) + (size_t)(i) * (t)->entry_size)
+#define INNER_CHILDREN(data) ((int *)((data) + sizeof(BT_NodeHeader)))
+#define INNER_SEPARATOR(t, data, i) ((data) + sizeof(BT_NodeHeader) + ((t)->meta.inner_capacity + 1) * sizeof(int) + (size_t)(i) * (t)->entry_size)
+#define ENTRY_RID(t, entry) ((entry) + (t)->key_size)      // unaligned after the key, copied with memcpy
+
+/******************************** Helpers *********************************************/
+
+static int keyAttrWidth(DataType type, int length) {
+    switch (type) {
+        case DT_INT:   return sizeof(int);
+        case DT_FLOAT: return sizeof(float);
+        case DT_STRING: return length;
+        case DT_BOOL:  return sizeof(bool);
+    }
+    return 0;
+}
+
+// Derive key offsets and entry sizes from the meta page
+static void initTreeLayout(BT_Tree *t) {
+    t->key_size = 0;
+    for (int i = 0; i < t->meta.num_key_attrs + t->meta.num_included_attrs; i++) {
+        t->key_offsets[i] = t->key_size;
+        t->key_widths[i] = keyAttrWidth(t->meta.key_types[i], t->meta.key_lengths[i]);
+        t->key_size += t->key_widths[i];
+    }
+    t->entry_size = t->key_size + sizeof(RID);
+}
+
+static int compareRids(RID *left, RID *right) {
+    if (left->page != right->page) return (left->page > right->page) - (left->page < right->page);
+    return (left->slot > right->slot) - (left->slot < right->slot);
+}
+
+// Compare two packed keys attribute by attribute, with the ordering of valueSmaller
+static int comparePackedKeys(BT_Tree *t, char *left, char *right) {
+    for (int i = 0; i < t->meta.num_key_attrs; i++) {
+        char *l = left + t->key_offsets[i], *r = right + t->key_offsets[i];
+        int result = 0;
+
+        switch (t->meta.key_types[i]) {
+            case DT_INT: {
+                int a, b;
+                memcpy(&a, l, sizeof(int));
+                memcpy(&b, r, sizeof(int));
+                result = (a > b) - (a < b);
+                break;
+            }
+            case DT_FLOAT: {
+                float a, b;
+                memcpy(&a, l, sizeof(float));
+                memcpy(&b, r, sizeof(float));
+                result = (a > b) - (a < b);
+                break;
+            }
+            case DT_STRING:
+                result = strncmp(l, r, t->key_widths[i]);
+                break;
+            case DT_BOOL: {
+                bool a, b;
+                memcpy(&a, l, sizeof(bool));
+                memcpy(&b, r, sizeof(bool));
+                result = (a > b) - (a < b);
+                break;
+            }
+        }
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
+// Compare entries by key, then by RID
+static int compareEntries(BT_Tree *t, char *left, char *right) {
+    int result = comparePackedKeys(t, left, right);
+    if (result != 0) return result;
+    RID left_rid, right_rid;
+    memcpy(&left_rid, ENTRY_RID(t, left), sizeof(RID));
+    memcpy(&right_rid, ENTRY_RID(t, right), sizeof(RID));
+    return compareRids(&left_rid, &right_rid);
+}
+
+static void makeEntry(BT_Tree *t, char *entry, char *key, RID rid) {
+    memcpy(entry, key, t->key_size);
+    memcpy(ENTRY_RID(t, entry), &rid, sizeof(RID));
+}
+
+// Child of an inner node to follow. With an entry: the child that holds it. With a key only:
+// the leftmost child that can hold an entry with that key.
+static int chooseChild(BT_Tree *t, char *data, char *entry, bool keyOnly) {
+    int low = 0, high = NODE_HEADER(data)->num_keys;
+
+    // number of separators before the target
+    while (low < high) {
+        int mid = (low + high) / 2;
+        char *separator = INNER_SEPARATOR(t, data, mid);
+        bool before = keyOnly ? comparePackedKeys(t, separator, entry) < 0 : compareEntries(t, separator, entry) <= 0;
+
+        if (before) low = mid + 1;
+        else high = mid;
+    }
+    return INNER_CHILDREN(data)[low];
+}
+
+// Position of the first leaf entry not smaller than entry (or not smaller than its key)
+static int leafLowerBound(BT_Tree *t, char *data, char *entry, bool keyOnly) {
+    int low = 0, high = NODE_HEADER(data)->num_keys;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        char *current = LEAF_ENTRY(t, data, mid);
+        int result = keyOnly ? comparePackedKeys(t, current, entry) : compareEntries(t, current, entry);
+
+        if (result < 0) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Append a new, empty node and leave it pinned
+static RC allocNode(BT_Tree *t, bool leaf, BM_PageHandle *node) {
+    int page = ++t->meta.num_nodes;
+
+    RC status = pinPage(&t->pool, node, page);
+    if (status != RC_OK) return status;
+
+    memset(node->data, 0, PAGE_SIZE);
+    NODE_HEADER(node->data)->is_leaf = leaf;
+    NODE_HEADER(node->data)->next_leaf = -1;
+    return markDirty(&t->pool, node);
+}
+
+static RC writeMeta(BT_Tree *t) {
+    BM_PageHandle pH;
+
+    RC status = pinPage(&t->pool, &pH, 0);
+    if (status != RC_OK) return status;
+
+    memcpy(pH.data, &t->meta, sizeof(BT_Meta));
+    status = markDirty(&t->pool, &pH);
+    if (status != RC_OK) {
+        unpinPage(&t->pool, &pH);
+        return status;
+    }
+    t->meta_changes = 0;
+    return unpinPage(&t->pool, &pH);
+}
+
+// Write the meta page after a change to the tree's shape, or once enough entry count changes piled up
+static RC metaChanged(BT_Tree *t, bool reshaped) {
+    if (!reshaped && ++t->meta_changes < BT_META_FLUSH_CHANGES) return RC_OK;
+    return writeMeta(t);
+}
+
+// Walk from the root to the leaf for entry, remembering the inner nodes passed
+static RC descend(BT_Tree *t, char *entry, bool keyOnly, int *path, int *depth, int *leafPage) {
+    BM_PageHandle pH;
+    int page = t->meta.root;
+
+    *depth = 0;
+    while (TRUE) {
+        RC status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) return status;
+
+        if (NODE_HEADER(pH.data)->is_leaf) {
+            *leafPage = page;
+            return unpinPage(&t->pool, &pH);
+        }
+        if (*depth == BT_MAX_HEIGHT) {
+            unpinPage(&t->pool, &pH);
+            return RC_ERROR;
+        }
+
+        path[(*depth)++] = page;
+        int child = chooseChild(t, pH.data, entry, keyOnly);
+
+        status = unpinPage(&t->pool, &pH);
+        if (status != RC_OK) return status;
+        page = child;
+    }
+}
+
+// Pin the leaf holding the first entry whose key is >= key (> key if !inclusive), or the
+// leftmost leaf for a NULL key. Empty leaves are skipped; *index is -1 past the last entry.
+static RC seekLowerBound(BT_Tree *t, char *key, bool inclusive, BM_PageHandle *leaf, int *index) {
+    int path[BT_MAX_HEIGHT], depth, page;
+    char *entry = NULL;
+    RC status;
+
+    *index = -1;
+    if (t->meta.root == -1) return RC_OK;
+
+    if (key != NULL) {
+        entry = (char *)calloc(1, t->entry_size);
+        if (entry == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+        memcpy(entry, key, t->key_size);
+        status = descend(t, entry, TRUE, path, &depth, &page);
+    } else {
+        // leftmost leaf
+        page = t->meta.root;
+        while (TRUE) {
+            status = pinPage(&t->pool, leaf, page);
+            if (status != RC_OK) break;
+            bool is_leaf = NODE_HEADER(leaf->data)->is_leaf;
+            int child = INNER_CHILDREN(leaf->data)[0];
+            status = unpinPage(&t->pool, leaf);
+            if (status != RC_OK || is_leaf) break;
+            page = child;
+        }
+    }
+
+    while (status == RC_OK && page != -1) {
+        status = pinPage(&t->pool, leaf, page);
+        if (status != RC_OK) break;
+
+        int num_keys = NODE_HEADER(leaf->data)->num_keys;
+        int position = 0;
+        if (entry != NULL) {
+            position = leafLowerBound(t, leaf->data, entry, TRUE);
+            while (!inclusive && position < num_keys && comparePackedKeys(t, LEAF_ENTRY(t, leaf->data, position), key) == 0)
+                position++;
+        }
+        if (position < num_keys) {
+            *index = position;
+            break;
+        }
+
+        // nothing left in this leaf, the bound is in a later one
+        page = NODE_HEADER(leaf->data)->next_leaf;
+        status = unpinPage(&t->pool, leaf);
+    }
+
+    free(entry);
+    return status;
+}
+
+/******************************** Index Manager ***************************************/
+
+extern RC initIndexManager(void *mgmtData) {
+    initStorageManager();
+    return RC_OK;
+}
+
+extern RC shutdownIndexManager() {
+    return RC_OK;
+}
+
+/******************************** Create, Open, Close *********************************/
+
+extern RC createBtree(char *idxId, int numKeyAttrs, int numIncludedAttrs, DataType *keyTypes, int *keyLengths, bool unique, int n) {
+    BT_Tree t;
+    SM_FileHandle fh;
+
+    if (idxId == NULL || numKeyAttrs <= 0 || numIncludedAttrs < 0 || numKeyAttrs + numIncludedAttrs > BT_MAX_KEY_ATTRS)
+        return RC_ERROR;
+
+    memset(&t.meta, 0, sizeof(BT_Meta));
+    memcpy(t.meta.magic, BT_MAGIC, sizeof(t.meta.magic));
+    t.meta.root = -1;
+    t.meta.unique = unique;
+    t.meta.num_key_attrs = numKeyAttrs;
+    t.meta.num_included_attrs = numIncludedAttrs;
+    for (int i = 0; i < numKeyAttrs + numIncludedAttrs; i++) {
+        t.meta.key_types[i] = keyTypes[i];
+        t.meta.key_lengths[i] = keyTypes[i] == DT_STRING ? keyLengths[i] : 0;
+    }
+    initTreeLayout(&t);
+
+    t.meta.leaf_capacity = (PAGE_SIZE - (int)sizeof(BT_NodeHeader)) / t.entry_size;
+    t.meta.inner_capacity = (PAGE_SIZE - (int)sizeof(BT_NodeHeader) - (int)sizeof(int)) / (t.entry_size + (int)sizeof(int));
+    if (n > 0) {
+        if (n > t.meta.leaf_capacity || n > t.meta.inner_capacity) return RC_IM_N_TO_LAGE;
+        t.meta.leaf_capacity = t.meta.inner_capacity = n;
+    }
+    if (t.meta.leaf_capacity < 2 || t.meta.inner_capacity < 2) return RC_IM_N_TO_LAGE;
+
+    RC status = createPageFile(idxId);
+    if (status != RC_OK) return status;
+
+    status = openPageFile(idxId, &fh);
+    if (status != RC_OK) return status;
+
+    char *page = (char *)calloc(PAGE_SIZE, 1);
+    if (page == NULL) {
+        closePageFile(&fh);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    memcpy(page, &t.meta, sizeof(BT_Meta));
+    status = writeBlock(0, &fh, page);
+
+    free(page);
+    closePageFile(&fh);
+    return status;
+}
+
+extern RC openBtree(BTreeHandle **tree, char *idxId) {
+    BM_PageHandle pH;
+
+    BTreeHandle *handle = (BTreeHandle *)malloc(sizeof(BTreeHandle));
+    BT_Tree *t = (BT_Tree *)malloc(sizeof(BT_Tree));
+    char *name = (char *)malloc(strlen(idxId) + 1);
+    if (handle == NULL || t == NULL || name == NULL) {
+        free(handle);
+        free(t);
+        free(name);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    strcpy(name, idxId);
+
+    // the pool reads pages past the end of a missing file as new ones, so check first
+    FILE *file = fopen(name, "rb");
+    if (file == NULL) {
+        free(handle);
+        free(t);
+        free(name);
+        return RC_FILE_NOT_FOUND;
+    }
+    fclose(file);
+
+    RC status = initBufferPool(&t->pool, name, BT_POOL_PAGES, RS_LRU, NULL);
+    if (status == RC_OK) status = pinPage(&t->pool, &pH, 0);
+    if (status != RC_OK) {
+        free(handle);
+        free(t);
+        free(name);
+        return status;
+    }
+
+    memcpy(&t->meta, pH.data, sizeof(BT_Meta));
+    unpinPage(&t->pool, &pH);
+    if (memcmp(t->meta.magic, BT_MAGIC, sizeof(t->meta.magic)) != 0) {
+        shutdownBufferPool(&t->pool);
+        free(handle);
+        free(t);
+        free(name);
+        return RC_ERROR;
+    }
+    initTreeLayout(t);
+    t->meta_changes = 0;
+
+    handle->idxId = name;
+    handle->keySize = t->key_size;
+    handle->mgmtData = t;
+    *tree = handle;
+    return RC_OK;
+}
+
+extern RC closeBtree(BTreeHandle *tree) {
+    BT_Tree *t = TREE(tree);
+
+    RC status = writeMeta(t);
+    RC shutdown_status = shutdownBufferPool(&t->pool);
+    if (status == RC_OK) status = shutdown_status;
+
+    free(tree->idxId);
+    free(t);
+    free(tree);
+    return status;
+}
+
+extern RC deleteBtree(char *idxId) {
+    return destroyPageFile(idxId);
+}
+
+/******************************** Information *****************************************/
+
+extern RC getNumNodes(BTreeHandle *tree, int *result) {
+    *result = TREE(tree)->meta.num_nodes;
+    return RC_OK;
+}
+
+extern RC getNumEntries(BTreeHandle *tree, int *result) {
+    *result = TREE(tree)->meta.num_entries;
+    return RC_OK;
+}
+
+extern int compareKeys(BTreeHandle *tree, char *left, char *right) {
+    return comparePackedKeys(TREE(tree), left, right);
+}
+
+/******************************** Index Access ****************************************/
+
+// Pack one value per key attribute into key
+extern RC packKey(BTreeHandle *tree, Value **values, char *key) {
+    BT_Tree *t = TREE(tree);
+
+    for (int i = 0; i < t->meta.num_key_attrs; i++) {
+        Value *value = values[i];
+        char *dest = key + t->key_offsets[i];
+
+        if (value->dt != t->meta.key_types[i]) return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+        switch (value->dt) {
+            case DT_INT:   memcpy(dest, &value->v.intV, sizeof(int)); break;
+            case DT_FLOAT: memcpy(dest, &value->v.floatV, sizeof(float)); break;
+            case DT_STRING: strncpy(dest, value->v.stringV, t->key_widths[i]); break;
+            case DT_BOOL:  memcpy(dest, &value->v.boolV, sizeof(bool)); break;
+        }
+    }
+    return RC_OK;
+}
+
+// RID of the first entry with key
+extern RC findKey(BTreeHandle *tree, char *key, RID *result) {
+    BT_Tree *t = TREE(tree);
+    BM_PageHandle leaf;
+    int index;
+
+    RC status = seekLowerBound(t, key, TRUE, &leaf, &index);
+    if (status != RC_OK) return status;
+    if (index == -1) return RC_IM_KEY_NOT_FOUND;
+
+    char *entry = LEAF_ENTRY(t, leaf.data, index);
+    bool found = comparePackedKeys(t, entry, key) == 0;
+    if (found) memcpy(result, ENTRY_RID(t, entry), sizeof(RID));
+
+    status = unpinPage(&t->pool, &leaf);
+    if (status != RC_OK) return status;
+    return found ? RC_OK : RC_IM_KEY_NOT_FOUND;
+}
+
+// Insert separator/right child into the inner node at path[level], splitting upwards as needed
+static RC insertIntoParent(BT_Tree *t, int *path, int level, char *separator, int rightChild) {
+    BM_PageHandle pH, sibling;
+
+    // the root was split: grow the tree by one level
+    if (level < 0) {
+        int old_root = t->meta.root;
+        RC status = allocNode(t, FALSE, &pH);
+        if (status != RC_OK) return status;
+
+        NODE_HEADER(pH.data)->num_keys = 1;
+        INNER_CHILDREN(pH.data)[0] = old_root;
+        INNER_CHILDREN(pH.data)[1] = rightChild;
+        memcpy(INNER_SEPARATOR(t, pH.data, 0), separator, t->entry_size);
+        t->meta.root = pH.pageNum;
+        return unpinPage(&t->pool, &pH);
+    }
+
+    RC status = pinPage(&t->pool, &pH, path[level]);
+    if (status != RC_OK) return status;
+
+    char *data = pH.data;
+    int num_keys = NODE_HEADER(data)->num_keys;
+    int position = 0;
+    while (position < num_keys && compareEntries(t, INNER_SEPARATOR(t, data, position), separator) <= 0) position++;
+
+    if (num_keys < t->meta.inner_capacity) {
+        memmove(INNER_SEPARATOR(t, data, position + 1), INNER_SEPARATOR(t, data, position), (size_t)(num_keys - position) * t->entry_size);
+        memmove(&INNER_CHILDREN(data)[position + 2], &INNER_CHILDREN(data)[position + 1], (num_keys - position) * sizeof(int));
+        memcpy(INNER_SEPARATOR(t, data, position), separator, t->entry_size);
+        INNER_CHILDREN(data)[position + 1] = rightChild;
+        NODE_HEADER(data)->num_keys++;
+
+        status = markDirty(&t->pool, &pH);
+        if (status != RC_OK) {
+            unpinPage(&t->pool, &pH);
+            return status;
+        }
+        return unpinPage(&t->pool, &pH);
+    }
+
+    // full: merge into temporary arrays, keep the lower half, move the middle separator up
+    int total = num_keys + 1;
+    char *separators = (char *)malloc((size_t)total * t->entry_size);
+    int *children = (int *)malloc(sizeof(int) * (total + 1));
+    char *middle = (char *)malloc(t->entry_size);
+    if (separators == NULL || children == NULL || middle == NULL) {
+        free(separators);
+        free(children);
+        free(middle);
+        unpinPage(&t->pool, &pH);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    memcpy(separators, INNER_SEPARATOR(t, data, 0), (size_t)position * t->entry_size);
+    memcpy(separators + (size_t)position * t->entry_size, separator, t->entry_size);
+    memcpy(separators + (size_t)(position + 1) * t->entry_size, INNER_SEPARATOR(t, data, position), (size_t)(num_keys - position) * t->entry_size);
+    memcpy(children, INNER_CHILDREN(data), (position + 1) * sizeof(int));
+    children[position + 1] = rightChild;
+    memcpy(&children[position + 2], &INNER_CHILDREN(data)[position + 1], (num_keys - position) * sizeof(int));
+
+    int left_keys = total / 2;
+    int right_keys = total - left_keys - 1;
+    memcpy(middle, separators + (size_t)left_keys * t->entry_size, t->entry_size);
+
+    status = allocNode(t, FALSE, &sibling);
+    if (status == RC_OK) {
+        NODE_HEADER(data)->num_keys = left_keys;
+        memcpy(INNER_SEPARATOR(t, data, 0), separators, (size_t)left_keys * t->entry_size);
+        memcpy(INNER_CHILDREN(data), children, (left_keys + 1) * sizeof(int));
+
+        NODE_HEADER(sibling.data)->num_keys = right_keys;
+        memcpy(INNER_SEPARATOR(t, sibling.data, 0), separators + (size_t)(left_keys + 1) * t->entry_size, (size_t)right_keys * t->entry_size);
+        memcpy(INNER_CHILDREN(sibling.data), &children[left_keys + 1], (right_keys + 1) * sizeof(int));
+
+        status = markDirty(&t->pool, &pH);
+        RC unpin_status = unpinPage(&t->pool, &sibling);
+        if (status == RC_OK) status = unpin_status;
+    }
+    RC unpin_status = unpinPage(&t->pool, &pH);
+    if (status == RC_OK) status = unpin_status;
+
+    if (status == RC_OK) status = insertIntoParent(t, path, level - 1, middle, sibling.pageNum);
+
+    free(separators);
+    free(children);
+    free(middle);
+    return status;
+}
+
+// Add one entry, splitting the nodes it does not fit in
+static RC insertEntry(BTreeHandle *tree, char *key, RID rid) {
+    BT_Tree *t = TREE(tree);
+    BM_PageHandle pH, sibling;
+    int path[BT_MAX_HEIGHT], depth, page;
+    RID existing;
+    RC status;
+
+    if (t->meta.unique) {
+        status = findKey(tree, key, &existing);
+        if (status == RC_OK) return RC_IM_KEY_ALREADY_EXISTS;
+        if (status != RC_IM_KEY_NOT_FOUND) return status;
+    }
+
+    // first entry: the root starts out as a leaf
+    if (t->meta.root == -1) {
+        status = allocNode(t, TRUE, &pH);
+        if (status != RC_OK) return status;
+        t->meta.root = pH.pageNum;
+        status = unpinPage(&t->pool, &pH);
+        if (status != RC_OK) return status;
+    }
+
+    char *entry = (char *)malloc(t->entry_size);
+    if (entry == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    makeEntry(t, entry, key, rid);
+
+    status = descend(t, entry, FALSE, path, &depth, &page);
+    if (status == RC_OK) status = pinPage(&t->pool, &pH, page);
+    if (status != RC_OK) {
+        free(entry);
+        return status;
+    }
+
+    char *data = pH.data;
+    int num_keys = NODE_HEADER(data)->num_keys;
+    int position = leafLowerBound(t, data, entry, FALSE);
+
+    if (position < num_keys && compareEntries(t, LEAF_ENTRY(t, data, position), entry) == 0) {
+        unpinPage(&t->pool, &pH);
+        free(entry);
+        return RC_IM_KEY_ALREADY_EXISTS;
+    }
+
+    if (num_keys < t->meta.leaf_capacity) {
+        memmove(LEAF_ENTRY(t, data, position + 1), LEAF_ENTRY(t, data, position), (size_t)(num_keys - position) * t->entry_size);
+        memcpy(LEAF_ENTRY(t, data, position), entry, t->entry_size);
+        NODE_HEADER(data)->num_keys++;
+        t->meta.num_entries++;
+
+        status = markDirty(&t->pool, &pH);
+        RC unpin_status = unpinPage(&t->pool, &pH);
+        free(entry);
+        return status == RC_OK ? unpin_status : status;
+    }
+
+    // full leaf: split it in half, the first entry of the new right leaf becomes the separator
+    int total = num_keys + 1;
+    char *entries = (char *)malloc((size_t)total * t->entry_size);
+    if (entries == NULL) {
+        unpinPage(&t->pool, &pH);
+        free(entry);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    memcpy(entries, LEAF_ENTRY(t, data, 0), (size_t)position * t->entry_size);
+    memcpy(entries + (size_t)position * t->entry_size, entry, t->entry_size);
+    memcpy(entries + (size_t)(position + 1) * t->entry_size, LEAF_ENTRY(t, data, position), (size_t)(num_keys - position) * t->entry_size);
+
+    int left_keys = total / 2;
+    status = allocNode(t, TRUE, &sibling);
+    if (status == RC_OK) {
+        NODE_HEADER(sibling.data)->num_keys = total - left_keys;
+        NODE_HEADER(sibling.data)->next_leaf = NODE_HEADER(data)->next_leaf;
+        memcpy(LEAF_ENTRY(t, sibling.data, 0), entries + (size_t)left_keys * t->entry_size, (size_t)(total - left_keys) * t->entry_size);
+
+        NODE_HEADER(data)->num_keys = left_keys;
+        NODE_HEADER(data)->next_leaf = sibling.pageNum;
+        memcpy(LEAF_ENTRY(t, data, 0), entries, (size_t)left_keys * t->entry_size);
+        t->meta.num_entries++;
+
+        status = markDirty(&t->pool, &pH);
+        RC unpin_status = unpinPage(&t->pool, &sibling);
+        if (status == RC_OK) status = unpin_status;
+    }
+    RC unpin_status = unpinPage(&t->pool, &pH);
+    if (status == RC_OK) status = unpin_status;
+
+    if (status == RC_OK) status = insertIntoParent(t, path, depth - 1, entries + (size_t)left_keys * t->entry_size, sibling.pageNum);
+
+    free(entries);
+    free(entry);
+    return status;
+}
+
+extern RC insertKey(BTreeHandle *tree, char *key, RID rid) {
+    BT_Tree *t = TREE(tree);
+    int root = t->meta.root, num_nodes = t->meta.num_nodes;
+
+    RC status = insertEntry(tree, key, rid);
+    bool reshaped = t->meta.root != root || t->meta.num_nodes != num_nodes;
+    if (status != RC_OK && !reshaped) return status;
+
+    // a split that failed half way still allocated nodes, the meta page has to cover them
+    RC meta_status = metaChanged(t, reshaped);
+    return status == RC_OK ? meta_status : status;
+}
+
+extern RC deleteKey(BTreeHandle *tree, char *key, RID rid) {
+    BT_Tree *t = TREE(tree);
+    BM_PageHandle pH;
+    int path[BT_MAX_HEIGHT], depth, page;
+
+    if (t->meta.root == -1) return RC_IM_KEY_NOT_FOUND;
+
+    char *entry = (char *)malloc(t->entry_size);
+    if (entry == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    makeEntry(t, entry, key, rid);
+
+    RC status = descend(t, entry, FALSE, path, &depth, &page);
+    if (status == RC_OK) status = pinPage(&t->pool, &pH, page);
+    if (status != RC_OK) {
+        free(entry);
+        return status;
+    }
+
+    char *data = pH.data;
+    int num_keys = NODE_HEADER(data)->num_keys;
+    int position = leafLowerBound(t, data, entry, FALSE);
+    bool found = position < num_keys && compareEntries(t, LEAF_ENTRY(t, data, position), entry) == 0;
+    free(entry);
+
+    if (!found) {
+        unpinPage(&t->pool, &pH);
+        return RC_IM_KEY_NOT_FOUND;
+    }
+
+    // underfull leaves are left as they are
+    memmove(LEAF_ENTRY(t, data, position), LEAF_ENTRY(t, data, position + 1), (size_t)(num_keys - position - 1) * t->entry_size);
+    NODE_HEADER(data)->num_keys--;
+    t->meta.num_entries--;
+
+    status = markDirty(&t->pool, &pH);
+    RC unpin_status = unpinPage(&t->pool, &pH);
+    if (status == RC_OK) status = unpin_status;
+    return status == RC_OK ? metaChanged(t, FALSE) : status;
+}
+
+/******************************** Bulk Build ******************************************/
+
+// Merge sort of entry positions, qsort has no way to pass the tree to the comparator
+static void sortPositions(BT_Tree *t, char *entries, int *positions, int *scratch, int count) {
+    if (count < 2) return;
+
+    int half = count / 2;
+    sortPositions(t, entries, positions, scratch, half);
+    sortPositions(t, entries, positions + half, scratch, count - half);
+
+    int left = 0, right = half, out = 0;
+    while (left < half && right < count) {
+        char *l = entries + (size_t)positions[left] * t->entry_size;
+        char *r = entries + (size_t)positions[right] * t->entry_size;
+        scratch[out++] = compareEntries(t, l, r) <= 0 ? positions[left++] : positions[right++];
+    }
+    while (left < half) scratch[out++] = positions[left++];
+    while (right < count) scratch[out++] = positions[right++];
+    memcpy(positions, scratch, sizeof(int) * count);
+}
+
+// Build the levels above children: nodes get an even share of the children, up to the fill factor
+static RC buildInnerLevels(BT_Tree *t, int *children, char *lowest, int count) {
+    int per_node = (t->meta.inner_capacity + 1) * BT_BULK_FILL / 100;
+    if (per_node < 2) per_node = 2;
+
+    while (count > 1) {
+        int num_nodes = (count + per_node - 1) / per_node;
+        RC status = RC_OK;
+
+        for (int n = 0; n < num_nodes && status == RC_OK; n++) {
+            BM_PageHandle pH;
+            int first = (int)((long)count * n / num_nodes);
+            int last = (int)((long)count * (n + 1) / num_nodes);
+
+            status = allocNode(t, FALSE, &pH);
+            if (status != RC_OK) break;
+
+            NODE_HEADER(pH.data)->num_keys = last - first - 1;
+            for (int i = first; i < last; i++) {
+                INNER_CHILDREN(pH.data)[i - first] = children[i];
+                if (i > first) memcpy(INNER_SEPARATOR(t, pH.data, i - first - 1), lowest + (size_t)i * t->entry_size, t->entry_size);
+            }
+
+            // the node is known by its page and its lowest entry on the next level up
+            children[n] = pH.pageNum;
+            memmove(lowest + (size_t)n * t->entry_size, lowest + (size_t)first * t->entry_size, t->entry_size);
+            status = unpinPage(&t->pool, &pH);
+        }
+        if (status != RC_OK) return status;
+        count = num_nodes;
+    }
+
+    t->meta.root = children[0];
+    return RC_OK;
+}
+
+// Build the tree bottom up from unsorted entries; leaves are written left to right on
+// consecutive pages. The tree has to be empty.
+extern RC bulkBuildBtree(BTreeHandle *tree, char *keys, RID *rids, int numEntries) {
+    BT_Tree *t = TREE(tree);
+
+    if (t->meta.num_entries != 0) return RC_ERROR;
+    t->meta.root = -1;
+    t->meta.num_nodes = 0;
+    if (numEntries <= 0) return RC_OK;
+
+    int per_leaf = t->meta.leaf_capacity * BT_BULK_FILL / 100;
+    if (per_leaf < 1) per_leaf = 1;
+    int num_leaves = (numEntries + per_leaf - 1) / per_leaf;
+
+    char *entries = (char *)malloc((size_t)numEntries * t->entry_size);
+    int *positions = (int *)malloc(sizeof(int) * numEntries);
+    int *scratch = (int *)malloc(sizeof(int) * numEntries);
+    int *children = (int *)malloc(sizeof(int) * num_leaves);
+    char *lowest = (char *)malloc((size_t)num_leaves * t->entry_size);
+    RC status = RC_OK;
+
+    if (entries == NULL || positions == NULL || scratch == NULL || children == NULL || lowest == NULL) {
+        status = RC_MEMORY_ALLOCATION_FAILED;
+        goto cleanup;
+    }
+
+    for (int i = 0; i < numEntries; i++) {
+        makeEntry(t, entries + (size_t)i * t->entry_size, keys + (size_t)i * t->key_size, rids[i]);
+        positions[i] = i;
+    }
+    sortPositions(t, entries, positions, scratch, numEntries);
+
+    for (int i = 1; i < numEntries; i++) {
+        char *previous = entries + (size_t)positions[i - 1] * t->entry_size;
+        char *current = entries + (size_t)positions[i] * t->entry_size;
+        int result = t->meta.unique ? comparePackedKeys(t, previous, current) : compareEntries(t, previous, current);
+        if (result == 0) {
+            status = RC_IM_KEY_ALREADY_EXISTS;
+            goto cleanup;
+        }
+    }
+
+    BM_PageHandle pH;
+    for (int n = 0; n < num_leaves && status == RC_OK; n++) {
+        int first = (int)((long)numEntries * n / num_leaves);
+        int last = (int)((long)numEntries * (n + 1) / num_leaves);
+
+        status = allocNode(t, TRUE, &pH);
+        if (status != RC_OK) break;
+
+        NODE_HEADER(pH.data)->num_keys = last - first;
+        NODE_HEADER(pH.data)->next_leaf = (n + 1 < num_leaves) ? pH.pageNum + 1 : -1;
+        for (int i = first; i < last; i++)
+            memcpy(LEAF_ENTRY(t, pH.data, i - first), entries + (size_t)positions[i] * t->entry_size, t->entry_size);
+
+        children[n] = pH.pageNum;
+        memcpy(lowest + (size_t)n * t->entry_size, LEAF_ENTRY(t, pH.data, 0), t->entry_size);
+        status = unpinPage(&t->pool, &pH);
+    }
+
+    if (status == RC_OK) {
+        t->meta.num_entries = numEntries;
+        status = buildInnerLevels(t, children, lowest, num_leaves);
+    }
+    if (t->meta.num_nodes != 0) {
+        RC meta_status = writeMeta(t);
+        if (status == RC_OK) status = meta_status;
+    }
+
+cleanup:
+    free(entries);
+    free(positions);
+    free(scratch);
+    free(children);
+    free(lowest);
+    return status;
+}
+
+/******************************** Cursors *********************************************/
+
+extern RC openTreeScan(BTreeHandle *tree, BT_ScanHandle **handle) {
+    return openTreeRangeScan(tree, NULL, TRUE, NULL, TRUE, handle);
+}
+
+extern RC openTreeRangeScan(BTreeHandle *tree, char *low, bool lowInclusive, char *high, bool highInclusive, BT_ScanHandle **handle) {
+    BT_Tree *t = TREE(tree);
+
+    BT_ScanHandle *scan = (BT_ScanHandle *)malloc(sizeof(BT_ScanHandle));
+    BT_ScanMgmt *mgmt = (BT_ScanMgmt *)malloc(sizeof(BT_ScanMgmt));
+    if (scan == NULL || mgmt == NULL) {
+        free(scan);
+        free(mgmt);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    mgmt->high = NULL;
+    mgmt->high_inclusive = highInclusive;
+    if (high != NULL) {
+        mgmt->high = (char *)malloc(t->key_size);
+        if (mgmt->high == NULL) {
+            free(scan);
+            free(mgmt);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+        memcpy(mgmt->high, high, t->key_size);
+    }
+
+    RC status = seekLowerBound(t, low, lowInclusive, &mgmt->leaf, &mgmt->index);
+    if (status != RC_OK) {
+        free(mgmt->high);
+        free(mgmt);
+        free(scan);
+        return status;
+    }
+    mgmt->leaf_pinned = (mgmt->index != -1);
+    mgmt->done = !mgmt->leaf_pinned;
+
+    scan->tree = tree;
+    scan->mgmtData = mgmt;
+    *handle = scan;
+    return RC_OK;
+}
+
+extern RC nextEntry(BT_ScanHandle *handle, RID *result) {
+    return nextKeyEntry(handle, NULL, result);
+}
+
+// Next entry of a cursor with its packed key and included attributes, key may be NULL
+extern RC nextKeyEntry(BT_ScanHandle *handle, char *key, RID *result) {
+    BT_Tree *t = TREE(handle->tree);
+    BT_ScanMgmt *mgmt = (BT_ScanMgmt *)handle->mgmtData;
+    RC status;
+
+    while (!mgmt->done) {
+        char *data = mgmt->leaf.data;
+
+        if (mgmt->index < NODE_HEADER(data)->num_keys) {
+            char *entry = LEAF_ENTRY(t, data, mgmt->index);
+
+            if (mgmt->high != NULL) {
+                int compare = comparePackedKeys(t, entry, mgmt->high);
+                if (compare > 0 || (compare == 0 && !mgmt->high_inclusive)) {
+                    mgmt->done = TRUE;
+                    break;
+                }
+            }
+            memcpy(result, ENTRY_RID(t, entry), sizeof(RID));
+            if (key != NULL) memcpy(key, entry, t->key_size);
+            mgmt->index++;
+            return RC_OK;
+        }
+
+        // leaf done, follow the chain
+        int next_leaf = NODE_HEADER(data)->next_leaf;
+        status = unpinPage(&t->pool, &mgmt->leaf);
+        mgmt->leaf_pinned = FALSE;
+        if (status != RC_OK) return status;
+
+        if (next_leaf == -1) {
+            mgmt->done = TRUE;
+            break;
+        }
+        status = pinPage(&t->pool, &mgmt->leaf, next_leaf);
+        if (status != RC_OK) return status;
+        mgmt->leaf_pinned = TRUE;
+        mgmt->index = 0;
+    }
+
+    return RC_IM_NO_MORE_ENTRIES;
+}
+
+extern RC closeTreeScan(BT_ScanHandle *handle) {
+    BT_Tree *t = TREE(handle->tree);
+    BT_ScanMgmt *mgmt = (BT_ScanMgmt *)handle->mgmtData;
+    RC status = RC_OK;
+
+    if (mgmt->leaf_pinned) status = unpinPage(&t->pool, &mgmt->leaf);
+
+    free(mgmt->high);
+    free(mgmt);
+    free(handle);
+    return status;
+}
@@ -0,0 +1,55 @@
+#ifndef BTREE_MGR_H
+#define BTREE_MGR_H
+
+#include "dberror.h"
+#include "tables.h"
+
+// structure for accessing btrees
+typedef struct BTreeHandle {
+	char *idxId;
+	int keySize;		// bytes of a packed key
+	void *mgmtData;
+} BTreeHandle;
+
+typedef struct BT_ScanHandle {
+	BTreeHandle *tree;
+	void *mgmtData;
+} BT_ScanHandle;
+
+// Keys are packed: the key attributes one after the other, each stored the way a record
+// stores it, followed by the included attributes. Only the key attributes are compared.
+// Entries are ordered by key and then by RID, so a non-unique tree keeps the RIDs of
+// equal keys in page order.
+
+// init and shutdown index manager
+extern RC initIndexManager (void *mgmtData);
+extern RC shutdownIndexManager ();
+
+// create, destroy, open, and close an btree index
+// keyTypes and keyLengths describe the key attributes, then the included ones
+// n is the maximum number of entries per node, 0 to fill the pages
+extern RC createBtree (char *idxId, int numKeyAttrs, int numIncludedAttrs, DataType *keyTypes, int *keyLengths, bool unique, int n);
+extern RC openBtree (BTreeHandle **tree, char *idxId);
+extern RC closeBtree (BTreeHandle *tree);
+extern RC deleteBtree (char *idxId);
+
+// access information about a b-tree
+extern RC getNumNodes (BTreeHandle *tree, int *result);
+extern RC getNumEntries (BTreeHandle *tree, int *result);
+extern int compareKeys (BTreeHandle *tree, char *left, char *right);
+
+// index access
+extern RC packKey (BTreeHandle *tree, Value **values, char *key);
+extern RC findKey (BTreeHandle *tree, char *key, RID *result);
+extern RC insertKey (BTreeHandle *tree, char *key, RID rid);
+extern RC deleteKey (BTreeHandle *tree, char *key, RID rid);
+extern RC bulkBuildBtree (BTreeHandle *tree, char *keys, RID *rids, int numEntries);
+
+// ordered cursors, a NULL bound leaves that end of the range open
+extern RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle);
+extern RC openTreeRangeScan (BTreeHandle *tree, char *low, bool lowInclusive, char *high, bool highInclusive, BT_ScanHandle **handle);
+extern RC nextEntry (BT_ScanHandle *handle, RID *result);
+extern RC nextKeyEntry (BT_ScanHandle *handle, char *key, RID *result);
+extern RC closeTreeScan (BT_ScanHandle *handle);
+
+#endif // BTREE_MGR_H
@@ -1,7 +1,11 @@
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
+#include<fcntl.h>
+#include<time.h>
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
+#include "bm_trace.h"
 
 typedef struct PgFrame // Data of a frame
 {
@@ -14,14 +18,153 @@ typedef struct PgFrame // Data of a frame
 
 } PgFrame;
 
-int bufferSize=0; // global buffer size
-int diskWritten=0; // number times the disk is written
-int diskRead=0; // number of pages read from disk
-int lastPageInClock=0; // last page used in clock
-int lastPageInLFU=0; // last page used in LFU
-int cache=0; // to track cache hits
+#define READ_AHEAD_SLOTS 64 // pages remembered from prefetchPages to detect read-ahead use
 
-SM_FileHandle fh; // global file handler
+typedef struct PoolMgmt // bookkeeping of one buffer pool
+{
+    PgFrame *frames; // page frames of the pool
+    BM_PoolStats stats; // counters and latency histograms
+    PageNumber readAhead[READ_AHEAD_SLOTS]; // pages recently handed out for read-ahead
+    int readAheadPos; // next slot to overwrite in readAhead
+    FILE *trace; // page access trace, NULL when not tracing
+    long long traceLastMicros; // time of the last traced pin
+    int bufferSize; // number of frames in the pool
+    int diskWritten; // number times the disk is written
+    int diskRead; // number of pages read from disk
+    int lastPageInClock; // last page used in clock
+    int lastPageInLFU; // last page used in LFU
+    int cache; // to track cache hits
+    SM_FileHandle fh; // file handler of the pool
+
+} PoolMgmt;
+
+#define POOL(bm) ((PoolMgmt *)(bm)->mgmtData)
+#define FRAMES(bm) (POOL(bm)->frames)
+
+/*=================================================================disk access helpers=======================================================================*/
+
+// monotonic clock in nanoseconds for the latency histograms
+static long long nowNanos(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// adds one sample to a log-scale histogram, bucket i holds [2^i, 2^(i+1)) nanoseconds
+static void recordLatency(BM_LatencyHistogram *hist, long long nanos){
+    int bucket = 0;
+
+    if(nanos < 0) nanos = 0;
+    while(bucket < BM_HIST_BUCKETS - 1 && (nanos >> (bucket + 1)) != 0) bucket++;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->totalNanos += nanos;
+}
+
+// writes the content of a frame back to the page file and marks it clean
+static RC writeFrameToDisk(BM_BufferPool *const bm, PgFrame *frame){
+    PoolMgmt *pool = POOL(bm);
+    long long start = nowNanos();
+
+    RC status = openPageFile(bm->pageFile, &pool->fh);
+    if(status != RC_OK) return status;
+    status = writeBlock(frame->pgNumber, &pool->fh, frame->pageData);
+    closePageFile(&pool->fh);
+
+    recordLatency(&pool->stats.writeLatency, nowNanos() - start);
+    if(status != RC_OK) return status;
+
+    frame->isDirty = FALSE;
+    pool->diskWritten++;
+    pool->stats.pagesWritten++;
+    return RC_OK;
+}
+
+// reads a page from the page file, pages past the end of the file are created empty
+static RC readPageFromDisk(BM_BufferPool *const bm, const PageNumber pageNum, SM_PageHandle memPage){
+    PoolMgmt *pool = POOL(bm);
+    long long start = nowNanos();
+
+    RC status = openPageFile(bm->pageFile, &pool->fh);
+    if(status != RC_OK) return status;
+    if(pageNum >= pool->fh.totalNumPages) status = ensureCapacity(pageNum + 1, &pool->fh);
+    if(status == RC_OK) status = readBlock(pageNum, &pool->fh, memPage);
+    closePageFile(&pool->fh);
+
+    recordLatency(&pool->stats.readLatency, nowNanos() - start);
+    if(status != RC_OK) return status;
+    pool->stats.pagesRead++;
+
+    // a miss on a page that prefetchPages hinted means the read-ahead was used
+    for(int i = 0; i < READ_AHEAD_SLOTS; i++){
+        if(pool->readAhead[i] == pageNum){
+            pool->readAhead[i] = NO_PAGE;
+            pool->stats.readAheadUsed++;
+            break;
+        }
+    }
+    return RC_OK;
+}
+
+// takes a page whose read failed back out of the pool, moving the last used frame into
+// its place because pinPage stops at the first empty frame
+static void dropFrame(BM_BufferPool *const bm, const PageNumber pageNum){
+    PoolMgmt *pool = POOL(bm);
+    PgFrame *ptr = FRAMES(bm);
+    int index = -1, last = -1;
+
+    for(int i = 0; i < pool->bufferSize && ptr[i].pgNumber != NO_PAGE; i++){
+        if(ptr[i].pgNumber == pageNum) index = i;
+        last = i;
+    }
+    if(index == -1) return;
+
+    free(ptr[index].pageData);
+    ptr[index] = ptr[last];
+    ptr[last].pgNumber = NO_PAGE;
+    ptr[last].pageData = NULL;
+    ptr[last].isDirty = FALSE;
+    ptr[last].pageCounter = 0;
+    ptr[last].leastrecentlyUsedPage = 0;
+    ptr[last].leastFrequentlyUsedPage = 0;
+}
+
+// appends one pinPage call to the access trace
+static void tracePin(BM_BufferPool *const bm, const PageNumber pageNum, bool hit){
+    PoolMgmt *pool = POOL(bm);
+    BM_TraceRecord record;
+
+    if(pool->trace == NULL) return;
+
+    long long micros = nowNanos() / 1000;
+    long long delta = micros - pool->traceLastMicros;
+    if(delta > BM_TRACE_MAX_DELTA) delta = BM_TRACE_MAX_DELTA;
+    pool->traceLastMicros = micros;
+
+    record.pageNum = pageNum;
+    record.timeDelta = (uint32_t) delta | (hit ? BM_TRACE_HIT_BIT : 0);
+    fwrite(&record, sizeof(BM_TraceRecord), 1, pool->trace);
+}
+
+// empties a victim frame chosen by a replacement strategy, writing it back if dirty;
+// a frame whose page cannot be written keeps it
+static RC evictFrame(BM_BufferPool *const bm, PgFrame *victim){
+    PoolMgmt *pool = POOL(bm);
+
+    if(victim->pgNumber == NO_PAGE) return RC_OK; // nothing to evict
+
+    if(victim->isDirty == TRUE){
+        RC status = writeFrameToDisk(bm, victim);
+        if(status != RC_OK) return status;
+        pool->stats.dirtyEvictions++;
+    }
+    else pool->stats.cleanEvictions++;
+
+    free(victim->pageData);
+    victim->pageData = NULL;
+    return RC_OK;
+}
 
 /*=================================================================buffer pool functions=======================================================================*/
 
@@ -35,12 +178,13 @@ extern RC initBufferPool(BM_BufferPool *const bm,
     bm->pageFile=(char *) pageFileName;
     bm->strategy=strategy;
 
+    PoolMgmt *pool=calloc(1, sizeof(PoolMgmt)); // creating the pool bookkeeping
     PgFrame *pageFrames=malloc(sizeof(PgFrame)*numPages); // creating the memory frames
-    bufferSize=numPages; // initalizing the buffer size
+    pool->bufferSize=numPages; // initalizing the buffer size
 
     int index=0;
 
-    while(index < bufferSize ){ // for each frame setting the default value
+    while(index < pool->bufferSize ){ // for each frame setting the default value
         pageFrames[index].pageCounter=0;
         pageFrames[index].isDirty=FALSE;
         pageFrames[index].leastrecentlyUsedPage=0;
@@ -50,12 +194,15 @@ extern RC initBufferPool(BM_BufferPool *const bm,
         index++;
     }
 
-    bm->mgmtData= pageFrames; // setting the frames to management data
+    for(index = 0; index < READ_AHEAD_SLOTS; index++) pool->readAhead[index] = NO_PAGE;
+
+    pool->frames = pageFrames;
+    bm->mgmtData= pool; // setting the frames and statistics to management data
 
     // counters for replacement algorithms
-    diskWritten = 0;
-    lastPageInClock = 0;
-    lastPageInLFU = 0;
+    pool->diskWritten = 0;
+    pool->lastPageInClock = 0;
+    pool->lastPageInLFU = 0;
     
     return RC_OK;
 
@@ -63,19 +210,19 @@ extern RC initBufferPool(BM_BufferPool *const bm,
 
 // to flush out all the pages from the buffer pool
 extern RC forceFlushPool(BM_BufferPool *const bm){
+    PoolMgmt *pool = POOL(bm);
     
-    PgFrame *pageFrames=(PgFrame*) bm->mgmtData; // gettting pageframes from buffer pool
+    PgFrame *pageFrames=FRAMES(bm); // gettting pageframes from buffer pool
 
     int index=0;
+
+    pool->stats.flushes++;
     
-    while(index<bufferSize){
+    while(index<pool->bufferSize){
         if(pageFrames[index].isDirty==TRUE && pageFrames[index].pageCounter==0){ // checking whether the page is dirty and not in use
             // if page is dirty, it must be written in the disk
-            //SM_FileHandle fh;
-            openPageFile(bm->pageFile,&fh); // opening the page file
-            writeBlock(pageFrames[index].pgNumber,&fh,pageFrames[index].pageData); // writing the content into the disk
-            pageFrames[index].isDirty=FALSE; // setting the frame as not dirty
-            diskWritten++; // incrementing disk written count
+            writeFrameToDisk(bm, &pageFrames[index]); // writing the content into the disk and setting the frame as not dirty
+            pool->stats.flushedPages++;
         }
         index++;
     }
@@ -84,14 +231,15 @@ extern RC forceFlushPool(BM_BufferPool *const bm){
 
 // to shutdown buffer pool
 RC shutdownBufferPool(BM_BufferPool *const bm){
+    PoolMgmt *pool = POOL(bm);
     
-    PgFrame *pageFrames=(PgFrame *) bm->mgmtData; // getting the page frames from the buffer pool
+    PgFrame *pageFrames=FRAMES(bm); // getting the page frames from the buffer pool
     //printf("start force flush");
     forceFlushPool(bm); // flushing the buffer before shutting it down.
     //printf("done force flush");
     int index=0;
 
-    while(index < bufferSize){
+    while(index < pool->bufferSize){
         //printf("%d\n",pageFrames[index].pageCounter);
         if(pageFrames[index].pageCounter!=0){ // checking whether page is in use or not
             return RC_ERROR;
@@ -100,7 +248,10 @@ RC shutdownBufferPool(BM_BufferPool *const bm){
     }
     //printf("done shutdown");
 
+    stopPageTrace(bm);
+    for(index = 0; index < pool->bufferSize; index++) free(pageFrames[index].pageData);
     free(pageFrames); // freeing the memory
+    free(bm->mgmtData);
 
     bm->mgmtData = NULL; // removing the data from mgmtData
 
@@ -110,74 +261,71 @@ RC shutdownBufferPool(BM_BufferPool *const bm){
 
 /*====================================================================Page Replacement Strategy=================================================================*/
 
-// First In First Out replacement algorithm 
-void FIFO(BM_BufferPool *const bm, PgFrame * page){
-    PgFrame *pageFrames=(PgFrame*)bm->mgmtData; // getting the page frames from buffer pool
+// First In First Out replacement algorithm, fails when every frame is fixed or the victim cannot be written
+RC FIFO(BM_BufferPool *const bm, PgFrame * page){
+    PoolMgmt *pool = POOL(bm);
+    PgFrame *pageFrames=FRAMES(bm); // getting the page frames from buffer pool
 
     int index=0, startIndex;
 
-    startIndex= diskRead % bufferSize; // finding the initial index
+    startIndex= (pool->diskRead + 1) % pool->bufferSize; // the frame after the one the last read filled
 
-    while(index < bufferSize){
+    while(index < pool->bufferSize){
         if(pageFrames[startIndex].pageCounter==0){
-            if(pageFrames[startIndex].isDirty==TRUE){ // if the page is dirty, writting it in the disk
-                //SM_FileHandle fh;
-                openPageFile(bm->pageFile,&fh);
-                writeBlock(pageFrames[startIndex].pgNumber,&fh,pageFrames[startIndex].pageData);
-                diskWritten++;
-            }
+            RC status = evictFrame(bm, &pageFrames[startIndex]); // if the page is dirty, writting it in the disk
+            if(status != RC_OK) return status;
             // changing frame with new frame in the buffer
             pageFrames[startIndex].pageData=page->pageData;
             pageFrames[startIndex].isDirty=page->isDirty;
             pageFrames[startIndex].pgNumber=page->pgNumber;
             pageFrames[startIndex].pageCounter=page->pageCounter;
-            break;
+            return RC_OK;
         }
         else{
             startIndex++;
-            if(startIndex % bufferSize==0) startIndex=0; // restarting the loop if we are at end of the buffer
+            if(startIndex % pool->bufferSize==0) startIndex=0; // restarting the loop if we are at end of the buffer
         }
         //free(pageFrames);
         index++;
     }
+    return RC_Pinned_page_in_buffer; // no frame could be replaced
 }
 
-// LFU (Least Frequently Used) page replacement srategy
-extern void LFU(BM_BufferPool *const bm, PgFrame *poolFrame) {
+// LFU (Least Frequently Used) page replacement srategy, fails when every frame is fixed or the victim cannot be written
+extern RC LFU(BM_BufferPool *const bm, PgFrame *poolFrame) {
+    PoolMgmt *pool = POOL(bm);
    
     int index1=0, index2=0; // for loops
-    int leastFreqIndex = lastPageInLFU, minFreqCount; // storing the value of LFU index
-    PgFrame *f = (PgFrame*) bm -> mgmtData; // Retrieve the array of frames from the buffer pool management data.
+    int leastFreqIndex = -1, minFreqCount; // storing the value of LFU index
+    PgFrame *f = FRAMES(bm); // Retrieve the array of frames from the buffer pool management data.
 
-    while(index1 < bufferSize) {
+    while(index1 < pool->bufferSize) {
         // Check if the page in the current frame is not fixed
-        if(f[leastFreqIndex].pageCounter == 0) {
+        if(f[(pool->lastPageInLFU + index1) % pool->bufferSize].pageCounter == 0) {
             // Find the frame with least frequent usage (LFU)
-            leastFreqIndex = (leastFreqIndex + index1) % bufferSize;
+            leastFreqIndex = (pool->lastPageInLFU + index1) % pool->bufferSize;
             minFreqCount = f[leastFreqIndex].leastFrequentlyUsedPage;
             break;
         }
         index1++;
     }
+    if(leastFreqIndex == -1) return RC_Pinned_page_in_buffer; // every frame is fixed
     // Pointer traversal across the buffer frame
-    index1 = (leastFreqIndex + 1) % bufferSize;
+    index1 = (leastFreqIndex + 1) % pool->bufferSize;
     
-    while(index2 < bufferSize) {
-        if(f[index1].leastFrequentlyUsedPage < minFreqCount) {
+    while(index2 < pool->bufferSize) {
+        if(f[index1].pageCounter == 0 && f[index1].leastFrequentlyUsedPage < minFreqCount) {
             // Update the LFU index if a frame with lower LFU count is found
             leastFreqIndex = index1;
             minFreqCount = f[index1].leastFrequentlyUsedPage;
         }
-        index1 = (index1 + 1) % bufferSize;
+        index1 = (index1 + 1) % pool->bufferSize;
         index2++;
     }
     
-    if(f[leastFreqIndex].isDirty == 1) {
-        // If it's dirty, write the page to the disk before replacing it
-        openPageFile(bm->pageFile, &fh);
-        writeBlock(f[leastFreqIndex].pgNumber, &fh, f[leastFreqIndex].pageData);
-        diskWritten++;
-    }
+    // If it's dirty, write the page to the disk before replacing it
+    RC status = evictFrame(bm, &f[leastFreqIndex]);
+    if(status != RC_OK) return status;
     
     // Update the page information with the new page frame
     f[leastFreqIndex].isDirty = poolFrame -> isDirty;
@@ -186,18 +334,20 @@ extern void LFU(BM_BufferPool *const bm, PgFrame *poolFrame) {
     f[leastFreqIndex].pgNumber = poolFrame -> pgNumber;
     
     // Update the LFU pointer to the next frame
-    lastPageInLFU = leastFreqIndex + 1;
+    pool->lastPageInLFU = leastFreqIndex + 1;
+    return RC_OK;
 }
 
-// LRU (Least Recently Used) page replacement strategy
-extern void LRU(BM_BufferPool *const bm, PgFrame *poolFrame) {
+// LRU (Least Recently Used) page replacement strategy, fails when every frame is fixed or the victim cannot be written
+extern RC LRU(BM_BufferPool *const bm, PgFrame *poolFrame) {
+    PoolMgmt *pool = POOL(bm);
     // Retrieve the array of frames from the buffer pool management data.
-    PgFrame *f = (PgFrame*) bm -> mgmtData;
-    int lastHitIndex, minCacheCount;
+    PgFrame *f = FRAMES(bm);
+    int lastHitIndex = -1, minCacheCount;
     int index=0;
 
     // Get the first frame with the least recently used (LRU) count
-    while(index < bufferSize) {
+    while(index < pool->bufferSize) {
         // Check if the page in the current frame is not fixed
         if(f[index].pageCounter == 0) {
             lastHitIndex = index;
@@ -206,12 +356,13 @@ extern void LRU(BM_BufferPool *const bm, PgFrame *poolFrame) {
         }
         index++;
     }    
+    if(lastHitIndex == -1) return RC_Pinned_page_in_buffer; // every frame is fixed
 
     index= lastHitIndex+1;
 
     // Go through the frames to find the frame with the lowest LRU count
-    while(index < bufferSize) {
-        if(f[index].leastrecentlyUsedPage < minCacheCount) 
+    while(index < pool->bufferSize) {
+        if(f[index].pageCounter == 0 && f[index].leastrecentlyUsedPage < minCacheCount) 
         {
             lastHitIndex = index;
             minCacheCount = f[index].leastrecentlyUsedPage;
@@ -219,13 +370,9 @@ extern void LRU(BM_BufferPool *const bm, PgFrame *poolFrame) {
         index++;
     }
 
-    if(f[lastHitIndex].isDirty == TRUE) {
-        // If it's dirty, write the page to the disk before replacing it
-        SM_FileHandle fh;
-        openPageFile(bm -> pageFile, &fh);
-        writeBlock(f[lastHitIndex].pgNumber, &fh, f[lastHitIndex].pageData);
-        diskWritten++;
-    }
+    // If it's dirty, write the page to the disk before replacing it
+    RC status = evictFrame(bm, &f[lastHitIndex]);
+    if(status != RC_OK) return status;
     
     // Update the page information with the new page frame
     f[lastHitIndex].pgNumber = poolFrame -> pgNumber;
@@ -233,41 +380,41 @@ extern void LRU(BM_BufferPool *const bm, PgFrame *poolFrame) {
     f[lastHitIndex].pageCounter = poolFrame -> pageCounter;
     f[lastHitIndex].pageData = poolFrame -> pageData;
     f[lastHitIndex].leastrecentlyUsedPage = poolFrame -> leastrecentlyUsedPage;
+    return RC_OK;
 }
 
-// CLOCK page replacement strategy
-extern void CLOCK(BM_BufferPool *const bm, PgFrame *poolFrame) {
+// CLOCK page replacement strategy, fails when every frame is fixed or the victim cannot be written
+extern RC CLOCK(BM_BufferPool *const bm, PgFrame *poolFrame) {
+    PoolMgmt *pool = POOL(bm);
     
     // Retrieve the array of frames from the buffer pool management data.
-    PgFrame *f = (PgFrame*) bm -> mgmtData;
+    PgFrame *f = FRAMES(bm);
 
-    // Infinite loop for CLOCK replacement.
-    while(1) {
+    // After two sweeps every reference bit is cleared, a frame still not chosen is fixed.
+    for(int sweep = 0; sweep < 2 * pool->bufferSize + 1; sweep++) {
         // Ensure circular traversal of frames for CLOCK algorithm.
         // If clkIndex reaches the end of the array, wrap it around to 0.
-        if(lastPageInClock % bufferSize == 0) lastPageInClock=0;    
+        pool->lastPageInClock = pool->lastPageInClock % pool->bufferSize;
    
-        if(f[lastPageInClock].leastrecentlyUsedPage == 0) {
-            if(f[lastPageInClock].isDirty == TRUE) {
-                // If it's dirty write the page to the disk before replacing it.
-                openPageFile(bm -> pageFile, &fh);
-                writeBlock(f[lastPageInClock].pgNumber, &fh, f[lastPageInClock].pageData);
-                diskWritten++;
-            }
+        if(f[pool->lastPageInClock].leastrecentlyUsedPage == 0 && f[pool->lastPageInClock].pageCounter == 0) {
+            // If it's dirty write the page to the disk before replacing it.
+            RC status = evictFrame(bm, &f[pool->lastPageInClock]);
+            if(status != RC_OK) return status;
             
             // Update the page infomation with the new page frame.
-            f[lastPageInClock].pageData = poolFrame -> pageData;
-            f[lastPageInClock].isDirty = poolFrame -> isDirty;
-            f[lastPageInClock].pageCounter = poolFrame -> pageCounter;
-            f[lastPageInClock].pgNumber = poolFrame -> pgNumber;
-            f[lastPageInClock].leastrecentlyUsedPage = poolFrame -> leastrecentlyUsedPage;
+            f[pool->lastPageInClock].pageData = poolFrame -> pageData;
+            f[pool->lastPageInClock].isDirty = poolFrame -> isDirty;
+            f[pool->lastPageInClock].pageCounter = poolFrame -> pageCounter;
+            f[pool->lastPageInClock].pgNumber = poolFrame -> pgNumber;
+            f[pool->lastPageInClock].leastrecentlyUsedPage = poolFrame -> leastrecentlyUsedPage;
             
-            lastPageInClock++;
-            break;    
+            pool->lastPageInClock++;
+            return RC_OK;
         }
         else 
-            poolFrame[lastPageInClock++].leastrecentlyUsedPage = 0;     // Reset the LRU count for the current frame.
+            f[pool->lastPageInClock++].leastrecentlyUsedPage = 0;     // Reset the LRU count for the current frame.
     }
+    return RC_Pinned_page_in_buffer; // no frame could be replaced
 }
 
 
@@ -276,10 +423,11 @@ extern void CLOCK(BM_BufferPool *const bm, PgFrame *poolFrame) {
 // to make a page as dirty
 extern RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
+    PoolMgmt *pool = POOL(bm);
     //the page handler has modified the contents of frame
 
-    PgFrame* ptr =(PgFrame*) bm -> mgmtData;
-    for(int i = 0; i < bufferSize; i++)
+    PgFrame* ptr =FRAMES(bm);
+    for(int i = 0; i < pool->bufferSize; i++)
     {
         if(ptr[i].pgNumber == page -> pageNum) // check for the page
         {
@@ -294,8 +442,9 @@ extern RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
 // to unpin the page
 extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    PgFrame* ptr = (PgFrame*)bm -> mgmtData;
-    for(int i = 0; i < bufferSize; i++)
+    PoolMgmt *pool = POOL(bm);
+    PgFrame* ptr = FRAMES(bm);
+    for(int i = 0; i < pool->bufferSize; i++)
     {
         //look through the page table to find pageNum because page numbers and page frames may not be the same
         if(ptr[i].pgNumber == page -> pageNum)
@@ -313,37 +462,75 @@ extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 //  forcing a page to write in the disk
 extern RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
+    PoolMgmt *pool = POOL(bm);
    
     //find the row in the pagetable
-    PgFrame *ptr = (PgFrame*)bm -> mgmtData;
-    for(int i = 0; i < bufferSize; i++)
+    PgFrame *ptr = FRAMES(bm);
+    for(int i = 0; i < pool->bufferSize; i++)
     {
         if(ptr[i].pgNumber == page -> pageNum)
         {
-            //SM_FileHandle fh;
-            openPageFile(bm -> pageFile, &fh);
-
-            //write data to fhandler
-            writeBlock(ptr[i].pgNumber, &fh, ptr[i].pageData);
-            
-            //mark page as clean
-            ptr[i].isDirty = FALSE;
-            
-            diskWritten++;
+            //write data to the disk and mark page as clean
+            RC status = writeFrameToDisk(bm, &ptr[i]);
+            if(status != RC_OK) return status;
+            POOL(bm) -> stats.flushedPages++;
         }
     }
     //page number not found in buffer pool!!!
     return RC_OK;
 }
 
+// drops the frames of every page from firstPage on without writing them, so the page file can be cut there
+extern RC discardPages(BM_BufferPool *const bm, const PageNumber firstPage)
+{
+    PoolMgmt *pool = POOL(bm);
+    PgFrame *ptr = FRAMES(bm);
+    int kept = 0;
+
+    for(int i = 0; i < pool->bufferSize; i++)
+    {
+        if(ptr[i].pgNumber >= firstPage && ptr[i].pageCounter != 0) return RC_ERROR; // page still in use
+    }
+
+    // pinPage stops at the first empty frame, so the frames that stay are moved to the front
+    for(int i = 0; i < pool->bufferSize; i++)
+    {
+        if(ptr[i].pgNumber == NO_PAGE) continue;
+        if(ptr[i].pgNumber >= firstPage)
+        {
+            free(ptr[i].pageData);
+            continue;
+        }
+        if(kept != i) ptr[kept] = ptr[i];
+        kept++;
+    }
+    for(int i = kept; i < pool->bufferSize; i++)
+    {
+        ptr[i].pgNumber = NO_PAGE;
+        ptr[i].pageData = NULL;
+        ptr[i].isDirty = FALSE;
+        ptr[i].pageCounter = 0;
+        ptr[i].leastrecentlyUsedPage = 0;
+        ptr[i].leastFrequentlyUsedPage = 0;
+    }
+    return RC_OK;
+}
+
 // to pin a page in the buffer pool
 extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
 {
+    PoolMgmt *pool = POOL(bm);
     //update pin counter in page table
-    PgFrame* ptr = (PgFrame*)bm -> mgmtData;
+    PgFrame* ptr = FRAMES(bm);
+    BM_PoolStats *stats = &pool->stats;
+    long long pinStart = nowNanos();
+    bool hit = FALSE;
+    RC status;
+
+    stats->pins++;
     if(ptr[0].pgNumber != -1){ // first page is available
        bool bufferOverflow = true;
-        for(int i = 0; i < bufferSize; i++)
+        for(int i = 0; i < pool->bufferSize; i++)
         {
             if(ptr[i].pgNumber!=-1){ // if page exist
                
@@ -351,10 +538,10 @@ extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const Page
                 {
                     ptr[i].pageCounter++; // increasing the page counter
                     bufferOverflow = false; // setting the buffer as not full
-                    cache++; // increasing cache hits
+                    pool->cache++; // increasing cache hits
                 
                     // updating flags of page replacement algorithms
-                    if(bm->strategy==RS_LRU) ptr[i].leastrecentlyUsedPage= cache;
+                    if(bm->strategy==RS_LRU) ptr[i].leastrecentlyUsedPage= pool->cache;
                     else if(bm->strategy==RS_CLOCK) ptr[i].leastrecentlyUsedPage=1;
                     else if(bm->strategy==RS_LFU) ptr[i].leastFrequentlyUsedPage++;
 
@@ -362,28 +549,34 @@ extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const Page
                     page->pageNum= pageNum; // setting the page number
                     page->data = ptr[i].pageData; // setting the page handler data
 
-                    lastPageInClock++; // move the clock pointer
+                    pool->lastPageInClock++; // move the clock pointer
+                    stats->hits++;
+                    hit = TRUE;
 
                     break;
                 }
             }
             else{
-                //SM_FileHandle fh;
-                openPageFile(bm->pageFile, &fh);
-
                 ptr[i].pageData = (SM_PageHandle) malloc(PAGE_SIZE); // allocation of page data
 
-                readBlock(pageNum,&fh,ptr[i].pageData); // reading the page data
+                status = readPageFromDisk(bm,pageNum,ptr[i].pageData); // reading the page data
+                if(status != RC_OK){ // the frame stays empty
+                    free(ptr[i].pageData);
+                    ptr[i].pageData = NULL;
+                    page->data = NULL;
+                    return status;
+                }
+                stats->misses++;
                 
                 ptr[i].pgNumber = pageNum; // updating the page number
                 ptr[i].pageCounter =1; // setting the page counter
                 ptr[i].leastFrequentlyUsedPage=0; // for LFU
-                diskRead++;
-                cache++;
+                pool->diskRead++;
+                pool->cache++;
 
                 //updating based on the strategy
                 if(bm->strategy==RS_CLOCK) ptr[i].leastrecentlyUsedPage=1;
-                else if(bm->strategy==RS_LRU) ptr[i].leastrecentlyUsedPage=cache;
+                else if(bm->strategy==RS_LRU) ptr[i].leastrecentlyUsedPage=pool->cache;
 
                 
                 bufferOverflow=false; 
@@ -400,82 +593,206 @@ extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const Page
         if(bufferOverflow==true){ // if buffer is full
             
         PgFrame *pageFrame=(PgFrame*)malloc(sizeof(PgFrame)); // allocation page frame memory
-        //SM_FileHandle fh;
-        openPageFile(bm->pageFile,&fh); // open the page file
         pageFrame->pageData = (SM_PageHandle) malloc(PAGE_SIZE); // allocate memory for page data
-        readBlock(pageNum,&fh,pageFrame->pageData); // reading the data into buffer
         pageFrame->leastFrequentlyUsedPage=0; // for LFU
         pageFrame->pgNumber=pageNum; // setting page number
         pageFrame->isDirty=FALSE; // marking page as not dirty
         pageFrame->pageCounter=1; // setting the page counter
-        diskRead++; // increasing the disk read count
-        cache++; // increasing cache hits
+        pool->cache++; // increasing cache hits
 
         // for page replacement 
         if(bm->strategy==RS_CLOCK) pageFrame->leastrecentlyUsedPage=1;
-        else if(bm->strategy==RS_LRU) pageFrame->leastrecentlyUsedPage=cache;
-
-        // output data
-        page->pageNum=pageNum;
-        page->data= pageFrame->pageData;
+        else if(bm->strategy==RS_LRU) pageFrame->leastrecentlyUsedPage=pool->cache;
 
         // selecting the strategy
         switch(bm->strategy){
             case RS_FIFO:
-                FIFO(bm,pageFrame);
+                status = FIFO(bm,pageFrame);
                 break;
             case RS_CLOCK:
-                CLOCK(bm,pageFrame);
+                status = CLOCK(bm,pageFrame);
                 break;
             case RS_LRU:
-                LRU(bm,pageFrame);
+                status = LRU(bm,pageFrame);
                 break;
             case RS_LFU:
-                LFU(bm,pageFrame);
+                status = LFU(bm,pageFrame);
                 break;
             default:
                 printf("Strategy not found");
+                status = RC_ERROR;
                 break;
             }
+        if(status != RC_OK){ // every frame is fixed or the victim could not be written, the page stays out of the pool
+            free(pageFrame->pageData);
+            free(pageFrame);
+            page->data = NULL;
+            return status;
+        }
+
+        // the page is read only once a victim made room for it, so a pin that fails does no I/O
+        SM_PageHandle pageData = pageFrame->pageData;
+        free(pageFrame); // the strategy copied the frame into the pool
+        status = readPageFromDisk(bm,pageNum,pageData); // reading the data into buffer
+        if(status != RC_OK){
+            dropFrame(bm, pageNum);
+            page->data = NULL;
+            return status;
+        }
+        stats->misses++;
+        pool->diskRead++; // increasing the disk read count
+
+        // output data
+        page->pageNum=pageNum;
+        page->data= pageData;
         }
+        recordLatency(&stats->pinLatency, nowNanos() - pinStart);
+        tracePin(bm, pageNum, hit);
         return RC_OK;
     }
     else{ // if first page is empty
-     //SM_FileHandle fh;
-        SM_FileHandle fh;
-        openPageFile(bm->pageFile,&fh);
-
         ptr[0].pageData = (SM_PageHandle) malloc(PAGE_SIZE); // providing memory for page data
-        ensureCapacity(pageNum,&fh); // ensuring the capacity
-        readBlock(pageNum,&fh,ptr[0].pageData); // reading the page data into buffer
+        status = readPageFromDisk(bm,pageNum,ptr[0].pageData); // reading the page data into buffer, ensuring the capacity
+        if(status != RC_OK){
+            free(ptr[0].pageData);
+            ptr[0].pageData = NULL;
+            page->data = NULL;
+            return status;
+        }
+        stats->misses++;
         
         // setting the meta data
         ptr[0].pageCounter++;
         ptr[0].pgNumber=pageNum;
-        diskRead = cache = 0;
-        ptr[0].leastrecentlyUsedPage = cache;
+        pool->diskRead = pool->cache = 0;
+        ptr[0].leastrecentlyUsedPage = pool->cache;
         
         page->pageNum=pageNum; // setting the output page number
         page->data=ptr[0].pageData; // setting the output data
         
+        recordLatency(&stats->pinLatency, nowNanos() - pinStart);
+        tracePin(bm, pageNum, hit);
         return RC_OK;
     }
 }
 
+/*====================================================================Tracing Functions==========================================================================*/
+
+// starts recording every pinPage call of the pool into a binary trace file
+extern RC startPageTrace(BM_BufferPool *const bm, const char *const traceFile){
+    if(bm == NULL || bm->mgmtData == NULL) return RC_FILE_HANDLE_NOT_INIT;
+
+    PoolMgmt *pool = POOL(bm);
+    BM_TraceHeader header;
+
+    stopPageTrace(bm); // a pool records into one trace at a time
+
+    pool->trace = fopen(traceFile, "wb");
+    if(pool->trace == NULL) return RC_WRITE_FAILED;
+
+    memcpy(header.magic, BM_TRACE_MAGIC, sizeof(header.magic));
+    header.pageSize = PAGE_SIZE;
+    header.numFrames = bm->numPages;
+    header.strategy = bm->strategy;
+    if(fwrite(&header, sizeof(BM_TraceHeader), 1, pool->trace) != 1){
+        fclose(pool->trace);
+        pool->trace = NULL;
+        return RC_WRITE_FAILED;
+    }
+
+    pool->traceLastMicros = nowNanos() / 1000;
+    return RC_OK;
+}
+
+// stops recording and closes the trace file
+extern RC stopPageTrace(BM_BufferPool *const bm){
+    if(bm == NULL || bm->mgmtData == NULL) return RC_FILE_HANDLE_NOT_INIT;
+
+    PoolMgmt *pool = POOL(bm);
+    if(pool->trace != NULL){
+        fclose(pool->trace);
+        pool->trace = NULL;
+    }
+    return RC_OK;
+}
+
+
 
+/*====================================================================Prefetch Functions=========================================================================*/
+
+// checks whether a page is already held by one of the frames
+static bool isPageResident(BM_BufferPool *const bm, const PageNumber pageNum){
+    PoolMgmt *pool = POOL(bm);
+    PgFrame *pageFrames=FRAMES(bm);
+
+    for(int i = 0; i < pool->bufferSize; i++){
+        if(pageFrames[i].pgNumber == pageNum) return TRUE;
+    }
+    return FALSE;
+}
+
+// starts loading the given pages without pinning them and without waiting for the disk
+// the pages are handed to the kernel as read-ahead hints, so a later pinPage finds them
+// in the page cache instead of blocking on the device
+extern RC prefetchPages(BM_BufferPool *const bm, const PageNumber *pageNumbers, const int numPages){
+    if(bm == NULL || bm->mgmtData == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    if(pageNumbers == NULL || numPages <= 0) return RC_OK;
+
+    SM_FileHandle prefetchHandle;
+    RC status = openPageFile(bm->pageFile, &prefetchHandle);
+    if(status != RC_OK) return status;
+
+#ifdef POSIX_FADV_WILLNEED
+    int fd = fileno((FILE *)prefetchHandle.mgmtInfo);
+#endif
+    PoolMgmt *pool = POOL(bm);
+    int runStart = NO_PAGE, runLength = 0; // contiguous pages are hinted with one call
+
+    for(int i = 0; i <= numPages; i++){
+        PageNumber pageNum = NO_PAGE;
+
+        if(i < numPages){
+            pageNum = pageNumbers[i];
+            if(isPageResident(bm, pageNum)){ // nothing to load, the frame already has it
+                pool->stats.readAheadResident++;
+                continue;
+            }
+            if(pageNum < 0 || pageNum >= prefetchHandle.totalNumPages) continue; // page not on disk yet
+            pool->readAhead[pool->readAheadPos] = pageNum; // remembered to detect its later use
+            pool->readAheadPos = (pool->readAheadPos + 1) % READ_AHEAD_SLOTS;
+            if(runLength > 0 && pageNum == runStart + runLength){ // extends the current run
+                runLength++;
+                continue;
+            }
+        }
+
+        if(runLength > 0){ // hand the finished run to the kernel
+#ifdef POSIX_FADV_WILLNEED
+            posix_fadvise(fd, (off_t)runStart * PAGE_SIZE, (off_t)runLength * PAGE_SIZE, POSIX_FADV_WILLNEED);
+#endif
+            pool->stats.readAheadIssued += runLength;
+        }
+        runStart = pageNum;
+        runLength = (pageNum == NO_PAGE) ? 0 : 1;
+    }
+
+    closePageFile(&prefetchHandle);
+    return RC_OK;
+}
 
 /*====================================================================Statistics Functions=======================================================================*/
 
 // to get content of each frame
 extern PageNumber *getFrameContents(BM_BufferPool *const bm){
+    PoolMgmt *pool = POOL(bm);
     // creating memory for frame
-    PageNumber *frames= malloc(sizeof(PageNumber) * bufferSize);
+    PageNumber *frames= malloc(sizeof(PageNumber) * pool->bufferSize);
 
-    PgFrame *existingFrames=(PgFrame*)bm->mgmtData; // getting the frames from buffer pool
+    PgFrame *existingFrames=FRAMES(bm); // getting the frames from buffer pool
 
     int index=0;
 
-    while(index <bufferSize){
+    while(index <pool->bufferSize){
         // checking whether if the frame have page
         if(existingFrames[index].pgNumber!=-1) frames[index]=existingFrames[index].pgNumber; // store the page number
         else frames[index]=NO_PAGE; // store it as no page
@@ -487,14 +804,15 @@ extern PageNumber *getFrameContents(BM_BufferPool *const bm){
 
 // get data on dirty flags
 extern bool *getDirtyFlags(BM_BufferPool *const bm){
+    PoolMgmt *pool = POOL(bm);
      // creating memory for frame
-    bool *flags= malloc(sizeof(bool) * bufferSize);
+    bool *flags= malloc(sizeof(bool) * pool->bufferSize);
 
-    PgFrame *existingFrames=(PgFrame*)bm->mgmtData; // getting the frames from buffer pool
+    PgFrame *existingFrames=FRAMES(bm); // getting the frames from buffer pool
 
     int index=0;
 
-    while(index <bufferSize){
+    while(index <pool->bufferSize){
         // checking whether if the page is dirty
         if(existingFrames[index].isDirty==TRUE) flags[index]=TRUE; // if dirty store it as true
         else flags[index]=FALSE; // if not dirty store it as false
@@ -506,15 +824,16 @@ extern bool *getDirtyFlags(BM_BufferPool *const bm){
 
 // count of frames that are fixed for use
 extern int *getFixCounts(BM_BufferPool *const bm){
+    PoolMgmt *pool = POOL(bm);
     //to store the fixed frames count
-    int *fixedFrames= malloc(sizeof(int) * bufferSize);
+    int *fixedFrames= malloc(sizeof(int) * pool->bufferSize);
 
     // getting the frames from pool
-    PgFrame *pageFrames=(PgFrame*) bm->mgmtData;
+    PgFrame *pageFrames=FRAMES(bm);
 
     int index =0;
 
-    while(index<bufferSize){
+    while(index<pool->bufferSize){
         if(pageFrames[index].pageCounter!=-1){ // checking if the frame is fixed
             fixedFrames[index]=pageFrames[index].pageCounter; // if so, storing the count
         }
@@ -530,11 +849,35 @@ extern int *getFixCounts(BM_BufferPool *const bm){
 
 // to get number of read opeations
 extern int getNumReadIO(BM_BufferPool *const bm){
-    // the number of read operation is stored in diskread
-    return diskRead+1; // diskread +1 is the number time data is read from disk into buffer
+    // the number of pages read from disk into the buffer
+    return (int) POOL(bm)->stats.pagesRead;
 }
 
 // to get number of disk write operations
 extern int getNumWriteIO(BM_BufferPool *const bm){
-    return diskWritten; // diskWritten has the number of time data is written from buffer into disk
-}
\ No newline at end of file
+    return (int) POOL(bm)->stats.pagesWritten; // number of time data is written from buffer into disk
+}
+
+// to get number of prefetched pages that were already in the buffer pool
+extern int getNumPrefetchResident(BM_BufferPool *const bm){
+    return (int) POOL(bm)->stats.readAheadResident;
+}
+
+// to get number of pages handed to the disk for read-ahead
+extern int getNumPrefetchIssued(BM_BufferPool *const bm){
+    return (int) POOL(bm)->stats.readAheadIssued;
+}
+
+// to take a snapshot of the pool statistics
+extern RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *stats){
+    if(bm == NULL || bm->mgmtData == NULL || stats == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    memcpy(stats, &POOL(bm)->stats, sizeof(BM_PoolStats));
+    return RC_OK;
+}
+
+// to start counting the pool statistics from zero
+extern RC resetPoolStats(BM_BufferPool *const bm){
+    if(bm == NULL || bm->mgmtData == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    memset(&POOL(bm)->stats, 0, sizeof(BM_PoolStats));
+    return RC_OK;
+}
@@ -33,6 +33,33 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// Statistics of a buffer pool
+#define BM_HIST_BUCKETS 32 // bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds
+
+typedef struct BM_LatencyHistogram {
+	long long count;
+	long long totalNanos;
+	long long buckets[BM_HIST_BUCKETS];
+} BM_LatencyHistogram;
+
+typedef struct BM_PoolStats {
+	long long pins;              // calls to pinPage
+	long long hits;              // pins served from a frame
+	long long misses;            // pins that had to read the page
+	long long cleanEvictions;    // victims dropped without a write
+	long long dirtyEvictions;    // victims written back before reuse
+	long long readAheadIssued;   // pages hinted by prefetchPages
+	long long readAheadResident; // prefetch requests already in a frame
+	long long readAheadUsed;     // misses on a page that was hinted before
+	long long flushes;           // calls to forceFlushPool
+	long long flushedPages;      // pages written by forceFlushPool and forcePage
+	long long pagesRead;
+	long long pagesWritten;
+	BM_LatencyHistogram pinLatency;
+	BM_LatencyHistogram readLatency;
+	BM_LatencyHistogram writeLatency;
+} BM_PoolStats;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -53,6 +80,15 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC discardPages (BM_BufferPool *const bm, const PageNumber firstPage);
+
+// Buffer Manager Interface Prefetching
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber *pageNumbers,
+		const int numPages);
+
+// Buffer Manager Interface Access Tracing
+RC startPageTrace (BM_BufferPool *const bm, const char *const traceFile);
+RC stopPageTrace (BM_BufferPool *const bm);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +96,9 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumPrefetchResident (BM_BufferPool *const bm);
+int getNumPrefetchIssued (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats);
+RC resetPoolStats (BM_BufferPool *const bm);
 
 #endif
@@ -1,11 +1,14 @@
 #include "buffer_mgr_stat.h"
 #include "buffer_mgr.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static int appendMessage (char *message, int size, int pos, const char *format, ...);
+static int sprintHistogram (char *message, int size, int pos, char *name, BM_LatencyHistogram *hist);
 
 // external functions
 void 
@@ -51,6 +54,79 @@ sprintPoolContent (BM_BufferPool *const bm)
 }
 
 
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	char *message = sprintPoolStats(bm);
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: %s", bm->numPages, message);
+	free(message);
+}
+
+char *
+sprintPoolStats (BM_BufferPool *const bm)
+{
+	BM_PoolStats stats;
+	char *message;
+	int size = 1024 + 3 * (BM_HIST_BUCKETS * 32);
+	int pos = 0;
+
+	message = (char *) malloc(size);
+	message[0] = '\0';
+	getPoolStats(bm, &stats);
+
+	pos = appendMessage(message, size, pos, "pins %lld, hits %lld, misses %lld, hit ratio %.4f\n",
+			stats.pins, stats.hits, stats.misses,
+			(stats.pins == 0) ? 0.0 : (double) stats.hits / stats.pins);
+	pos = appendMessage(message, size, pos, "evictions clean %lld, dirty %lld\n",
+			stats.cleanEvictions, stats.dirtyEvictions);
+	pos = appendMessage(message, size, pos, "read-ahead issued %lld, resident %lld, used %lld\n",
+			stats.readAheadIssued, stats.readAheadResident, stats.readAheadUsed);
+	pos = appendMessage(message, size, pos, "flushes %lld, flushed pages %lld, pages read %lld, pages written %lld\n",
+			stats.flushes, stats.flushedPages, stats.pagesRead, stats.pagesWritten);
+	pos = sprintHistogram(message, size, pos, "pin", &stats.pinLatency);
+	pos = sprintHistogram(message, size, pos, "read", &stats.readLatency);
+	pos = sprintHistogram(message, size, pos, "write", &stats.writeLatency);
+
+	return message;
+}
+
+// appends formatted text at pos without writing past size, returns the new end of the message
+static int
+appendMessage (char *message, int size, int pos, const char *format, ...)
+{
+	va_list args;
+	int written;
+
+	if (pos >= size - 1)
+		return pos;
+
+	va_start(args, format);
+	written = vsnprintf(message + pos, size - pos, format, args);
+	va_end(args);
+
+	if (written < 0)
+		return pos;
+	return (written >= size - pos) ? size - 1 : pos + written;
+}
+
+static int
+sprintHistogram (char *message, int size, int pos, char *name, BM_LatencyHistogram *hist)
+{
+	int i;
+
+	pos = appendMessage(message, size, pos, "%s latency: %lld samples, avg %lldns", name, hist->count,
+			(hist->count == 0) ? 0 : hist->totalNanos / hist->count);
+	for (i = 0; i < BM_HIST_BUCKETS; i++)
+		if (hist->buckets[i] != 0)
+			pos = appendMessage(message, size, pos, " [<%lldns:%lld]", 1LL << (i + 1), hist->buckets[i]);
+	pos = appendMessage(message, size, pos, "\n");
+
+	return pos;
+}
+
 void
 printPageContent (BM_PageHandle *const page)
 {
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dberror.h"
+#include "record_mgr.h"
+
+/*
+ * Command line front end for bulkLoadTable.
+ *
+ * usage: bulk_load <table> [input file|-] [delimiter]
+ * Rows are read from the input file, or stdin when it is missing or "-",
+ * and appended to an existing table. The delimiter defaults to ','.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <table> [input file|-] [delimiter]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *input = stdin;
+    if (argc > 2 && strcmp(argv[2], "-") != 0) {
+        input = fopen(argv[2], "r");
+        if (input == NULL) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+    char delimiter = (argc > 3 && argv[3][0] != '\0') ? argv[3][0] : ',';
+
+    RM_TableData table;
+    int loaded = 0;
+
+    CHECK(initRecordManager(NULL));
+    CHECK(openTable(&table, argv[1]));
+
+    RC status = bulkLoadTable(&table, input, delimiter, &loaded);
+    if (status == RC_BULK_LOAD_PARSE_ERROR)
+        fprintf(stderr, "%s: stopped after %d rows, row %d could not be parsed\n", argv[1], loaded, loaded + 1);
+    else if (status != RC_OK) {
+        char *message = errorMessage(status);
+        fprintf(stderr, "%s: stopped after %d rows at row %d: %s", argv[1], loaded, loaded + 1, message);
+        free(message);
+    }
+
+    CHECK(closeTable(&table));
+    CHECK(shutdownRecordManager());
+    if (input != stdin) fclose(input);
+
+    printf("%d rows loaded into %s\n", loaded, argv[1]);
+    return status == RC_OK ? 0 : 1;
+}
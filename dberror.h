@@ -30,6 +30,10 @@ typedef int RC;
 // Added new definitions for Record Manager
 #define RC_NO_TUPLE_RID 600
 #define RC_CONDITION_NOT_FOUND 601
+#define RC_BULK_LOAD_PARSE_ERROR 602
+#define RC_RM_INDEX_NOT_FOUND 603
+#define RC_RM_STATS_DO_NOT_FIT 604
+#define RC_RM_RECORD_DOES_NOT_FIT 605
 #define RC_CREATE_RECORD_FAILED 403
 #define RC_ERROR 404
 #define RC_Pinned_page_in_buffer 143
@@ -50,6 +50,7 @@ valueSmaller (Value *left, Value *right, Value *result)
 		break;
 	case DT_BOOL:
 		result->v.boolV = (left->v.boolV < right->v.boolV);
+		break;
 	case DT_STRING:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
 		break;
@@ -74,6 +75,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV && right->v.boolV);
 
 	return RC_OK;
@@ -84,6 +86,7 @@ boolOr (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV || right->v.boolV);
 
 	return RC_OK;
@@ -148,6 +151,70 @@ evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 	return RC_OK;
 }
 
+RC
+evalExprInArena (Record *record, Schema *schema, Expr *expr, Arena *arena, Value **result)
+{
+	Value *lIn;
+	Value *rIn = NULL;
+	Value *val;
+	RC rc;
+
+	switch(expr->type)
+	{
+	case EXPR_OP:
+	{
+		Operator *op = expr->expr.op;
+
+		val = (Value *) arenaAlloc(arena, sizeof(Value));
+		if (val == NULL)
+			return RC_MEMORY_ALLOCATION_FAILED;
+
+		if ((rc = evalExprInArena(record, schema, op->args[0], arena, &lIn)) != RC_OK)
+			return rc;
+		if (op->type != OP_BOOL_NOT && (rc = evalExprInArena(record, schema, op->args[1], arena, &rIn)) != RC_OK)
+			return rc;
+
+		switch(op->type)
+		{
+		case OP_BOOL_NOT:
+			rc = boolNot(lIn, val);
+			break;
+		case OP_BOOL_AND:
+			rc = boolAnd(lIn, rIn, val);
+			break;
+		case OP_BOOL_OR:
+			rc = boolOr(lIn, rIn, val);
+			break;
+		case OP_COMP_EQUAL:
+			rc = valueEquals(lIn, rIn, val);
+			break;
+		case OP_COMP_SMALLER:
+			rc = valueSmaller(lIn, rIn, val);
+			break;
+		default:
+			rc = RC_OK;
+			break;
+		}
+		if (rc != RC_OK)
+			return rc;
+	}
+	break;
+	case EXPR_CONST:
+		// the constant is only read, so it is handed out as it is
+		val = expr->expr.cons;
+		break;
+	case EXPR_ATTRREF:
+		if ((rc = getAttrInArena(record, schema, expr->expr.attrRef, arena, &val)) != RC_OK)
+			return rc;
+		break;
+	default:
+		return RC_ERROR;
+	}
+
+	*result = val;
+	return RC_OK;
+}
+
 RC
 freeExpr (Expr *expr)
 {
@@ -167,6 +234,7 @@ freeExpr (Expr *expr)
 			break;
 		}
 		free(op->args);
+		free(op);
 	}
 	break;
 	case EXPR_CONST:
@@ -1,6 +1,7 @@
 #ifndef EXPR_H
 #define EXPR_H
 
+#include "arena.h"
 #include "dberror.h"
 #include "tables.h"
 
@@ -41,6 +42,9 @@ extern RC boolNot (Value *input, Value *result);
 extern RC boolAnd (Value *left, Value *right, Value *result);
 extern RC boolOr (Value *left, Value *right, Value *result);
 extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
+// like evalExpr, but every value comes from the arena and lives until it is reset; the
+// result must not be passed to freeVal. Constants and strings are shared, not copied.
+extern RC evalExprInArena (Record *record, Schema *schema, Expr *expr, Arena *arena, Value **result);
 extern RC freeExpr (Expr *expr);
 extern void freeVal(Value *val);
 
@@ -0,0 +1,799 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+
+/*
+ * Extendible hash index on top of the buffer pool.
+ *
+ * Page 0 of the index file holds HT_Meta. The directory maps the low global_depth bits of
+ * a key's hash to a bucket page; it is kept in memory while the index is open and written
+ * to a chain of directory pages, together with the meta page, after every split or added
+ * overflow page. Entry count changes reach the meta page after HT_META_FLUSH_CHANGES of
+ * them, and on close. A full bucket is split on its own, doubling the
+ * directory when its local depth reaches the global depth, so no insert ever rehashes the
+ * whole index. Entries whose hashes cannot be told apart (duplicates of one key) go to
+ * overflow pages chained behind the bucket. Deletes leave buckets in place.
+ */
+
+#define HT_MAGIC "HSH1"
+#define HT_MAX_KEY_ATTRS 16
+#define HT_MAX_DEPTH 20              // directory of at most 2^20 buckets, deeper chains overflow
+#define HT_POOL_PAGES 32             // operations pin a few pages at once, the rest caches hot pages
+#define HT_META_FLUSH_CHANGES 1024   // entry count changes kept in memory before the meta page is rewritten
+
+typedef struct HT_Meta {
+    char magic[4];
+    int global_depth;
+    int num_buckets;
+    int num_pages;                   // pages after the meta page: buckets, overflow and directory pages
+    int num_entries;
+    int unique;                      // reject a second entry with an equal key
+    int dir_page;                    // first directory page, -1 before the first split
+    int free_page;                   // first free page, chained through next
+    int num_key_attrs;
+    int num_included_attrs;          // stored after the key attributes, not hashed
+    DataType key_types[HT_MAX_KEY_ATTRS];
+    int key_lengths[HT_MAX_KEY_ATTRS];
+} HT_Meta;
+
+// Header of every page after the meta page
+typedef struct HT_PageHeader {
+    int local_depth;                 // hash bits shared by the entries of a bucket
+    int num_entries;                 // entries of a bucket page, directory slots of a directory page
+    int next;                        // overflow, directory or free chain, -1 at the end
+    int reserved;
+} HT_PageHeader;
+
+// Open index
+typedef struct HT_Index {
+    BM_BufferPool pool;
+    HT_Meta meta;
+    int *directory;                  // bucket page of every hash prefix
+    int key_size;                    // bytes of a packed key
+    int entry_size;                  // packed key and RID
+    int capacity;                    // entries per page
+    int key_offsets[HT_MAX_KEY_ATTRS];
+    int key_widths[HT_MAX_KEY_ATTRS];
+    int meta_changes;                // entry count changes since the meta page was written
+} HT_Index;
+
+// Entry matched by a scan; the RID comes first so matches sort with compareRids
+typedef struct HT_Match {
+    RID rid;
+    int position;                    // Of its key in the scan's keys
+} HT_Match;
+
+// Matches of an open scan, collected when it is opened
+typedef struct HT_ScanMgmt {
+    HT_Match *matches;
+    char *keys;                      // Packed keys of the matches, in the order they were found
+    int key_size;
+    int count;
+    int next;
+} HT_ScanMgmt;
+
+#define INDEX(handle) ((HT_Index *)(handle)->mgmtData)
+#define HT_HEADER(data) ((HT_PageHeader *)(data))
+#define HT_ENTRY(t, data, i) ((data) + sizeof(HT_PageHeader) + (size_t)(i) * (t)->entry_size)
+#define HT_ENTRY_RID(t, entry) ((entry) + (t)->key_size)   // unaligned after the key, copied with memcpy
+#define HT_DIR_SLOTS ((int)((PAGE_SIZE - sizeof(HT_PageHeader)) / sizeof(int)))
+#define HT_DIR_ENTRIES(data) ((int *)((data) + sizeof(HT_PageHeader)))
+#define DIRECTORY_SIZE(t) (1 << (t)->meta.global_depth)
+
+/******************************** Helpers *********************************************/
+
+static int keyAttrWidth(DataType type, int length) {
+    switch (type) {
+        case DT_INT:   return sizeof(int);
+        case DT_FLOAT: return sizeof(float);
+        case DT_STRING: return length;
+        case DT_BOOL:  return sizeof(bool);
+    }
+    return 0;
+}
+
+// Derive key offsets and entry sizes from the meta page
+static void initIndexLayout(HT_Index *t) {
+    t->key_size = 0;
+    for (int i = 0; i < t->meta.num_key_attrs + t->meta.num_included_attrs; i++) {
+        t->key_offsets[i] = t->key_size;
+        t->key_widths[i] = keyAttrWidth(t->meta.key_types[i], t->meta.key_lengths[i]);
+        t->key_size += t->key_widths[i];
+    }
+    t->entry_size = t->key_size + sizeof(RID);
+    t->capacity = (PAGE_SIZE - (int)sizeof(HT_PageHeader)) / t->entry_size;
+}
+
+// FNV-1a over the key, keys that compare equal hash equally
+static unsigned int hashKey(HT_Index *t, char *key) {
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < t->meta.num_key_attrs; i++) {
+        char *value = key + t->key_offsets[i];
+        int width = t->key_widths[i];
+        float zero = 0.0f;
+
+        if (t->meta.key_types[i] == DT_STRING) width = strnlen(value, width);
+        if (t->meta.key_types[i] == DT_FLOAT) {
+            float f;
+            memcpy(&f, value, sizeof(float));
+            if (f == 0.0f) value = (char *)&zero;    // -0.0 equals 0.0
+        }
+        for (int b = 0; b < width; b++) {
+            hash ^= (unsigned char)value[b];
+            hash *= 16777619u;
+        }
+    }
+
+    // spread the bits, the directory uses the low ones
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static bool keysEqual(HT_Index *t, char *left, char *right) {
+    for (int i = 0; i < t->meta.num_key_attrs; i++) {
+        char *l = left + t->key_offsets[i], *r = right + t->key_offsets[i];
+
+        if (t->meta.key_types[i] == DT_STRING) {
+            if (strncmp(l, r, t->key_widths[i]) != 0) return FALSE;
+        } else if (t->meta.key_types[i] == DT_FLOAT) {
+            float a, b;
+            memcpy(&a, l, sizeof(float));
+            memcpy(&b, r, sizeof(float));
+            if (a != b) return FALSE;
+        } else if (memcmp(l, r, t->key_widths[i]) != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static int compareRids(const void *a, const void *b) {
+    const RID *left = (const RID *)a, *right = (const RID *)b;
+
+    if (left->page != right->page) return (left->page > right->page) - (left->page < right->page);
+    return (left->slot > right->slot) - (left->slot < right->slot);
+}
+
+// Take a page from the free chain or append one, and leave it pinned and empty
+static RC allocPage(HT_Index *t, BM_PageHandle *pH) {
+    int page = t->meta.free_page;
+
+    RC status = pinPage(&t->pool, pH, page != -1 ? page : t->meta.num_pages + 1);
+    if (status != RC_OK) return status;
+
+    if (page != -1) t->meta.free_page = HT_HEADER(pH->data)->next;
+    else t->meta.num_pages++;
+
+    memset(pH->data, 0, PAGE_SIZE);
+    HT_HEADER(pH->data)->next = -1;
+    return markDirty(&t->pool, pH);
+}
+
+// Put a pinned page on the free chain, the caller unpins it
+static RC releasePage(HT_Index *t, BM_PageHandle *pH) {
+    HT_HEADER(pH->data)->num_entries = 0;
+    HT_HEADER(pH->data)->next = t->meta.free_page;
+    t->meta.free_page = pH->pageNum;
+    return markDirty(&t->pool, pH);
+}
+
+static RC writeMeta(HT_Index *t) {
+    BM_PageHandle pH;
+
+    RC status = pinPage(&t->pool, &pH, 0);
+    if (status != RC_OK) return status;
+
+    memcpy(pH.data, &t->meta, sizeof(HT_Meta));
+    status = markDirty(&t->pool, &pH);
+    RC unpin_status = unpinPage(&t->pool, &pH);
+    if (status == RC_OK) status = unpin_status;
+    if (status == RC_OK) t->meta_changes = 0;
+    return status;
+}
+
+// Write the meta page once enough entry count changes piled up
+static RC metaChanged(HT_Index *t) {
+    if (++t->meta_changes < HT_META_FLUSH_CHANGES) return RC_OK;
+    return writeMeta(t);
+}
+
+static RC loadDirectory(HT_Index *t) {
+    BM_PageHandle pH;
+    int size = DIRECTORY_SIZE(t), read = 0;
+
+    t->directory = (int *)malloc(sizeof(int) * size);
+    if (t->directory == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    // a new index has a single bucket on page 1
+    if (t->meta.dir_page == -1) {
+        t->directory[0] = 1;
+        return RC_OK;
+    }
+
+    for (int page = t->meta.dir_page; read < size; ) {
+        RC status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) return status;
+
+        int count = HT_HEADER(pH.data)->num_entries;
+        memcpy(t->directory + read, HT_DIR_ENTRIES(pH.data), sizeof(int) * count);
+        read += count;
+        page = HT_HEADER(pH.data)->next;
+
+        status = unpinPage(&t->pool, &pH);
+        if (status != RC_OK) return status;
+        if (page == -1 && read < size) return RC_ERROR;
+    }
+    return RC_OK;
+}
+
+// Write the directory over its pages, appending pages as it grows
+static RC saveDirectory(HT_Index *t) {
+    BM_PageHandle pH, previous;
+    bool previous_pinned = FALSE;
+    int size = DIRECTORY_SIZE(t), written = 0, page = t->meta.dir_page;
+    RC status = RC_OK;
+
+    while (written < size) {
+        if (page == -1) {
+            status = allocPage(t, &pH);
+            if (status != RC_OK) break;
+            if (previous_pinned) HT_HEADER(previous.data)->next = pH.pageNum;
+            else t->meta.dir_page = pH.pageNum;
+        } else {
+            status = pinPage(&t->pool, &pH, page);
+            if (status != RC_OK) break;
+        }
+
+        if (previous_pinned) {
+            markDirty(&t->pool, &previous);
+            unpinPage(&t->pool, &previous);
+        }
+
+        int count = (size - written < HT_DIR_SLOTS) ? size - written : HT_DIR_SLOTS;
+        memcpy(HT_DIR_ENTRIES(pH.data), t->directory + written, sizeof(int) * count);
+        HT_HEADER(pH.data)->num_entries = count;
+        written += count;
+
+        page = HT_HEADER(pH.data)->next;
+        previous = pH;
+        previous_pinned = TRUE;
+    }
+
+    if (previous_pinned) {
+        markDirty(&t->pool, &previous);
+        RC unpin_status = unpinPage(&t->pool, &previous);
+        if (status == RC_OK) status = unpin_status;
+    }
+    return status;
+}
+
+// First entry with key in the chain of a bucket
+static RC lookupEntry(HT_Index *t, char *key, unsigned int hash, RID *result) {
+    BM_PageHandle pH;
+    int page = t->directory[hash & (DIRECTORY_SIZE(t) - 1)];
+
+    while (page != -1) {
+        RC status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) return status;
+
+        for (int i = 0; i < HT_HEADER(pH.data)->num_entries; i++) {
+            char *entry = HT_ENTRY(t, pH.data, i);
+            if (keysEqual(t, entry, key)) {
+                memcpy(result, HT_ENTRY_RID(t, entry), sizeof(RID));
+                return unpinPage(&t->pool, &pH);
+            }
+        }
+        page = HT_HEADER(pH.data)->next;
+
+        status = unpinPage(&t->pool, &pH);
+        if (status != RC_OK) return status;
+    }
+    return RC_IM_KEY_NOT_FOUND;
+}
+
+// Write entries into a pinned, empty bucket, chaining overflow pages as it fills
+static RC fillChain(HT_Index *t, BM_PageHandle *head, char *entries, int *positions, int count) {
+    BM_PageHandle overflow;
+    BM_PageHandle *current = head;
+    RC status = RC_OK;
+
+    for (int i = 0; i < count && status == RC_OK; i++) {
+        if (HT_HEADER(current->data)->num_entries == t->capacity) {
+            status = allocPage(t, &overflow);
+            if (status != RC_OK) break;
+            HT_HEADER(current->data)->next = overflow.pageNum;
+
+            if (current != head) {
+                markDirty(&t->pool, current);
+                unpinPage(&t->pool, current);
+            }
+            current = &overflow;
+        }
+
+        char *entry = HT_ENTRY(t, current->data, HT_HEADER(current->data)->num_entries++);
+        memcpy(entry, entries + (size_t)positions[i] * t->entry_size, t->entry_size);
+    }
+
+    if (current != head) {
+        markDirty(&t->pool, current);
+        RC unpin_status = unpinPage(&t->pool, current);
+        if (status == RC_OK) status = unpin_status;
+    }
+    return status;
+}
+
+// Split a full bucket in two by the next hash bit. Leaves it alone when its entries and the
+// hash being inserted are all the same, a split could not make room for them.
+static RC splitBucket(HT_Index *t, int bucket, unsigned int hash, bool *split) {
+    BM_PageHandle head, pH, sibling;
+    char *entries = NULL;
+    unsigned int *hashes = NULL;
+    int *positions = NULL, count = 0, allocated = 0;
+    bool differ = FALSE;
+
+    *split = FALSE;
+    RC status = pinPage(&t->pool, &head, bucket);
+    if (status != RC_OK) return status;
+
+    int depth = HT_HEADER(head.data)->local_depth;
+    if (depth >= HT_MAX_DEPTH) return unpinPage(&t->pool, &head);
+
+    // collect the chain, giving its overflow pages back as they are read
+    for (int page = bucket; page != -1 && status == RC_OK; ) {
+        BM_PageHandle *current = (page == bucket) ? &head : &pH;
+        if (page != bucket) {
+            status = pinPage(&t->pool, &pH, page);
+            if (status != RC_OK) break;
+        }
+
+        int num = HT_HEADER(current->data)->num_entries;
+        if (count + num > allocated) {
+            allocated = (count + num) * 2;
+            char *more_entries = (char *)realloc(entries, (size_t)allocated * t->entry_size);
+            unsigned int *more_hashes = (unsigned int *)realloc(hashes, sizeof(unsigned int) * allocated);
+            if (more_entries != NULL) entries = more_entries;
+            if (more_hashes != NULL) hashes = more_hashes;
+            if (more_entries == NULL || more_hashes == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+        }
+        for (int i = 0; i < num && status == RC_OK; i++) {
+            memcpy(entries + (size_t)count * t->entry_size, HT_ENTRY(t, current->data, i), t->entry_size);
+            hashes[count] = hashKey(t, entries + (size_t)count * t->entry_size);
+            if (hashes[count] != hash) differ = TRUE;
+            count++;
+        }
+        page = HT_HEADER(current->data)->next;
+
+        if (current == &pH) unpinPage(&t->pool, &pH);
+    }
+
+    if (status != RC_OK || !differ) {
+        free(entries);
+        free(hashes);
+        RC unpin_status = unpinPage(&t->pool, &head);
+        return status == RC_OK ? unpin_status : status;
+    }
+
+    // release the overflow pages, the two halves get fresh chains
+    for (int page = HT_HEADER(head.data)->next; page != -1 && status == RC_OK; ) {
+        status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) break;
+        page = HT_HEADER(pH.data)->next;
+        releasePage(t, &pH);
+        unpinPage(&t->pool, &pH);
+    }
+
+    // the directory doubles when the bucket already uses every bit of it
+    if (status == RC_OK && depth == t->meta.global_depth) {
+        int size = DIRECTORY_SIZE(t);
+        int *directory = (int *)realloc(t->directory, sizeof(int) * size * 2);
+        if (directory == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+        else {
+            memcpy(directory + size, directory, sizeof(int) * size);
+            t->directory = directory;
+            t->meta.global_depth++;
+        }
+    }
+
+    if (status == RC_OK) status = allocPage(t, &sibling);
+    positions = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+    if (status == RC_OK && positions == NULL) {
+        unpinPage(&t->pool, &sibling);
+        status = RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    if (status == RC_OK) {
+        // prefixes with the new bit set move to the sibling
+        for (int i = 0; i < DIRECTORY_SIZE(t); i++)
+            if (t->directory[i] == bucket && ((i >> depth) & 1)) t->directory[i] = sibling.pageNum;
+
+        HT_HEADER(head.data)->local_depth = depth + 1;
+        HT_HEADER(head.data)->num_entries = 0;
+        HT_HEADER(head.data)->next = -1;
+        HT_HEADER(sibling.data)->local_depth = depth + 1;
+
+        // positions of the entries staying in front, then of the ones moving
+        int stay = 0, move = count;
+        for (int i = 0; i < count; i++) {
+            if ((hashes[i] >> depth) & 1) positions[--move] = i;
+            else positions[stay++] = i;
+        }
+        status = fillChain(t, &head, entries, positions, stay);
+        if (status == RC_OK) status = fillChain(t, &sibling, entries, positions + stay, count - stay);
+
+        markDirty(&t->pool, &sibling);
+        unpinPage(&t->pool, &sibling);
+        t->meta.num_buckets++;
+        *split = TRUE;
+    }
+
+    free(entries);
+    free(hashes);
+    free(positions);
+    markDirty(&t->pool, &head);
+    RC unpin_status = unpinPage(&t->pool, &head);
+    return status == RC_OK ? unpin_status : status;
+}
+
+// Chain an empty overflow page behind the last page of a bucket
+static RC addOverflow(HT_Index *t, int lastPage) {
+    BM_PageHandle last, overflow;
+
+    RC status = allocPage(t, &overflow);
+    if (status != RC_OK) return status;
+
+    status = pinPage(&t->pool, &last, lastPage);
+    if (status == RC_OK) {
+        HT_HEADER(last.data)->next = overflow.pageNum;
+        markDirty(&t->pool, &last);
+        status = unpinPage(&t->pool, &last);
+    }
+
+    RC unpin_status = unpinPage(&t->pool, &overflow);
+    return status == RC_OK ? unpin_status : status;
+}
+
+/******************************** Hash Index ******************************************/
+
+extern RC createHashIndex(char *idxId, int numKeyAttrs, int numIncludedAttrs, DataType *keyTypes, int *keyLengths, bool unique) {
+    HT_Index t;
+    SM_FileHandle fh;
+
+    if (idxId == NULL || numKeyAttrs <= 0 || numIncludedAttrs < 0 || numKeyAttrs + numIncludedAttrs > HT_MAX_KEY_ATTRS)
+        return RC_ERROR;
+
+    memset(&t.meta, 0, sizeof(HT_Meta));
+    memcpy(t.meta.magic, HT_MAGIC, sizeof(t.meta.magic));
+    t.meta.num_buckets = 1;
+    t.meta.num_pages = 1;
+    t.meta.unique = unique;
+    t.meta.dir_page = -1;
+    t.meta.free_page = -1;
+    t.meta.num_key_attrs = numKeyAttrs;
+    t.meta.num_included_attrs = numIncludedAttrs;
+    for (int i = 0; i < numKeyAttrs + numIncludedAttrs; i++) {
+        t.meta.key_types[i] = keyTypes[i];
+        t.meta.key_lengths[i] = keyTypes[i] == DT_STRING ? keyLengths[i] : 0;
+    }
+    initIndexLayout(&t);
+    if (t.capacity < 2) return RC_IM_N_TO_LAGE;
+
+    RC status = createPageFile(idxId);
+    if (status != RC_OK) return status;
+
+    status = openPageFile(idxId, &fh);
+    if (status != RC_OK) return status;
+
+    char *page = (char *)calloc(PAGE_SIZE, 1);
+    if (page == NULL) {
+        closePageFile(&fh);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    memcpy(page, &t.meta, sizeof(HT_Meta));
+    status = writeBlock(0, &fh, page);
+
+    // the first bucket
+    if (status == RC_OK) status = ensureCapacity(2, &fh);
+    if (status == RC_OK) {
+        memset(page, 0, PAGE_SIZE);
+        HT_HEADER(page)->next = -1;
+        status = writeBlock(1, &fh, page);
+    }
+
+    free(page);
+    closePageFile(&fh);
+    return status;
+}
+
+extern RC openHashIndex(HashHandle **index, char *idxId) {
+    BM_PageHandle pH;
+
+    HashHandle *handle = (HashHandle *)malloc(sizeof(HashHandle));
+    HT_Index *t = (HT_Index *)malloc(sizeof(HT_Index));
+    char *name = (char *)malloc(strlen(idxId) + 1);
+    if (handle == NULL || t == NULL || name == NULL) {
+        free(handle);
+        free(t);
+        free(name);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    strcpy(name, idxId);
+
+    // the pool reads pages past the end of a missing file as new ones, so check first
+    FILE *file = fopen(name, "rb");
+    if (file == NULL) {
+        free(handle);
+        free(t);
+        free(name);
+        return RC_FILE_NOT_FOUND;
+    }
+    fclose(file);
+
+    RC status = initBufferPool(&t->pool, name, HT_POOL_PAGES, RS_LRU, NULL);
+    if (status == RC_OK) status = pinPage(&t->pool, &pH, 0);
+    if (status != RC_OK) {
+        free(handle);
+        free(t);
+        free(name);
+        return status;
+    }
+
+    memcpy(&t->meta, pH.data, sizeof(HT_Meta));
+    unpinPage(&t->pool, &pH);
+    t->directory = NULL;
+    if (memcmp(t->meta.magic, HT_MAGIC, sizeof(t->meta.magic)) == 0) status = loadDirectory(t);
+    else status = RC_ERROR;
+    if (status != RC_OK) {
+        shutdownBufferPool(&t->pool);
+        free(t->directory);
+        free(handle);
+        free(t);
+        free(name);
+        return status;
+    }
+    initIndexLayout(t);
+    t->meta_changes = 0;
+
+    handle->idxId = name;
+    handle->keySize = t->key_size;
+    handle->mgmtData = t;
+    *index = handle;
+    return RC_OK;
+}
+
+extern RC closeHashIndex(HashHandle *index) {
+    HT_Index *t = INDEX(index);
+
+    RC status = saveDirectory(t);
+    RC meta_status = writeMeta(t);
+    if (status == RC_OK) status = meta_status;
+    RC shutdown_status = shutdownBufferPool(&t->pool);
+    if (status == RC_OK) status = shutdown_status;
+
+    free(t->directory);
+    free(index->idxId);
+    free(t);
+    free(index);
+    return status;
+}
+
+extern RC deleteHashIndex(char *idxId) {
+    return destroyPageFile(idxId);
+}
+
+/******************************** Information *****************************************/
+
+extern RC getNumBuckets(HashHandle *index, int *result) {
+    *result = INDEX(index)->meta.num_buckets;
+    return RC_OK;
+}
+
+extern RC getNumHashEntries(HashHandle *index, int *result) {
+    *result = INDEX(index)->meta.num_entries;
+    return RC_OK;
+}
+
+/******************************** Index Access ****************************************/
+
+extern RC packHashKey(HashHandle *index, Value **values, char *key) {
+    HT_Index *t = INDEX(index);
+
+    for (int i = 0; i < t->meta.num_key_attrs; i++) {
+        Value *value = values[i];
+        char *dest = key + t->key_offsets[i];
+
+        if (value->dt != t->meta.key_types[i]) return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+        switch (value->dt) {
+            case DT_INT:   memcpy(dest, &value->v.intV, sizeof(int)); break;
+            case DT_FLOAT: memcpy(dest, &value->v.floatV, sizeof(float)); break;
+            case DT_STRING: strncpy(dest, value->v.stringV, t->key_widths[i]); break;
+            case DT_BOOL:  memcpy(dest, &value->v.boolV, sizeof(bool)); break;
+        }
+    }
+    return RC_OK;
+}
+
+// RID of an entry with key
+extern RC findHashKey(HashHandle *index, char *key, RID *result) {
+    HT_Index *t = INDEX(index);
+    return lookupEntry(t, key, hashKey(t, key), result);
+}
+
+extern RC insertHashKey(HashHandle *index, char *key, RID rid) {
+    HT_Index *t = INDEX(index);
+    BM_PageHandle pH;
+    unsigned int hash = hashKey(t, key);
+    RID existing;
+
+    if (t->meta.unique) {
+        RC status = lookupEntry(t, key, hash, &existing);
+        if (status == RC_OK) return RC_IM_KEY_ALREADY_EXISTS;
+        if (status != RC_IM_KEY_NOT_FOUND) return status;
+    }
+
+    while (TRUE) {
+        int bucket = t->directory[hash & (DIRECTORY_SIZE(t) - 1)], last = bucket;
+        bool split;
+
+        // first page of the chain with room
+        for (int page = bucket; page != -1; ) {
+            RC status = pinPage(&t->pool, &pH, page);
+            if (status != RC_OK) return status;
+
+            if (HT_HEADER(pH.data)->num_entries < t->capacity) {
+                char *entry = HT_ENTRY(t, pH.data, HT_HEADER(pH.data)->num_entries++);
+                memcpy(entry, key, t->key_size);
+                memcpy(HT_ENTRY_RID(t, entry), &rid, sizeof(RID));
+                t->meta.num_entries++;
+
+                status = markDirty(&t->pool, &pH);
+                RC unpin_status = unpinPage(&t->pool, &pH);
+                if (status == RC_OK) status = unpin_status;
+                return status == RC_OK ? metaChanged(t) : status;
+            }
+            last = page;
+            page = HT_HEADER(pH.data)->next;
+
+            status = unpinPage(&t->pool, &pH);
+            if (status != RC_OK) return status;
+        }
+
+        // the bucket is full: split it, or chain a page when splitting cannot help
+        RC status = splitBucket(t, bucket, hash, &split);
+        if (status == RC_OK && !split) status = addOverflow(t, last);
+
+        // the directory and the page counts changed, their pages follow the buckets at once
+        RC save_status = split ? saveDirectory(t) : RC_OK;
+        if (save_status == RC_OK) save_status = writeMeta(t);
+        if (status == RC_OK) status = save_status;
+        if (status != RC_OK) return status;
+    }
+}
+
+extern RC deleteHashKey(HashHandle *index, char *key, RID rid) {
+    HT_Index *t = INDEX(index);
+    BM_PageHandle pH;
+    int page = t->directory[hashKey(t, key) & (DIRECTORY_SIZE(t) - 1)];
+
+    while (page != -1) {
+        RC status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) return status;
+
+        int num_entries = HT_HEADER(pH.data)->num_entries;
+        for (int i = 0; i < num_entries; i++) {
+            char *entry = HT_ENTRY(t, pH.data, i);
+            RID entry_rid;
+            memcpy(&entry_rid, HT_ENTRY_RID(t, entry), sizeof(RID));
+            if (!keysEqual(t, entry, key) || compareRids(&entry_rid, &rid) != 0) continue;
+
+            // the last entry of the page fills the gap
+            if (i != num_entries - 1) memcpy(entry, HT_ENTRY(t, pH.data, num_entries - 1), t->entry_size);
+            HT_HEADER(pH.data)->num_entries--;
+            t->meta.num_entries--;
+
+            status = markDirty(&t->pool, &pH);
+            RC unpin_status = unpinPage(&t->pool, &pH);
+            if (status == RC_OK) status = unpin_status;
+            return status == RC_OK ? metaChanged(t) : status;
+        }
+        page = HT_HEADER(pH.data)->next;
+
+        status = unpinPage(&t->pool, &pH);
+        if (status != RC_OK) return status;
+    }
+    return RC_IM_KEY_NOT_FOUND;
+}
+
+/******************************** Scan ************************************************/
+
+extern RC openHashScan(HashHandle *index, char *key, HT_ScanHandle **handle) {
+    HT_Index *t = INDEX(index);
+    BM_PageHandle pH;
+    RC status = RC_OK;
+
+    HT_ScanHandle *scan = (HT_ScanHandle *)malloc(sizeof(HT_ScanHandle));
+    HT_ScanMgmt *mgmt = (HT_ScanMgmt *)calloc(1, sizeof(HT_ScanMgmt));
+    if (scan == NULL || mgmt == NULL) {
+        free(scan);
+        free(mgmt);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    mgmt->key_size = t->key_size;
+
+    int allocated = 0;
+    for (int page = t->directory[hashKey(t, key) & (DIRECTORY_SIZE(t) - 1)]; page != -1 && status == RC_OK; ) {
+        status = pinPage(&t->pool, &pH, page);
+        if (status != RC_OK) break;
+
+        for (int i = 0; i < HT_HEADER(pH.data)->num_entries; i++) {
+            char *entry = HT_ENTRY(t, pH.data, i);
+            if (!keysEqual(t, entry, key)) continue;
+
+            if (mgmt->count == allocated) {
+                allocated = allocated ? allocated * 2 : 16;
+                HT_Match *matches = (HT_Match *)realloc(mgmt->matches, sizeof(HT_Match) * allocated);
+                char *keys = (char *)realloc(mgmt->keys, (size_t)allocated * t->key_size);
+                if (matches != NULL) mgmt->matches = matches;
+                if (keys != NULL) mgmt->keys = keys;
+                if (matches == NULL || keys == NULL) {
+                    status = RC_MEMORY_ALLOCATION_FAILED;
+                    break;
+                }
+            }
+            HT_Match *match = &mgmt->matches[mgmt->count];
+            memcpy(&match->rid, HT_ENTRY_RID(t, entry), sizeof(RID));
+            memcpy(mgmt->keys + (size_t)mgmt->count * t->key_size, entry, t->key_size);
+            match->position = mgmt->count++;
+        }
+        page = HT_HEADER(pH.data)->next;
+        unpinPage(&t->pool, &pH);
+    }
+
+    if (status != RC_OK) {
+        free(mgmt->matches);
+        free(mgmt->keys);
+        free(mgmt);
+        free(scan);
+        return status;
+    }
+
+    // page order, so fetching the records walks the table forward
+    if (mgmt->count > 1) qsort(mgmt->matches, mgmt->count, sizeof(HT_Match), compareRids);
+    scan->index = index;
+    scan->mgmtData = mgmt;
+    *handle = scan;
+    return RC_OK;
+}
+
+extern RC nextHashEntry(HT_ScanHandle *handle, RID *result) {
+    return nextHashKeyEntry(handle, NULL, result);
+}
+
+// Next match with its packed key and included attributes, key may be NULL
+extern RC nextHashKeyEntry(HT_ScanHandle *handle, char *key, RID *result) {
+    HT_ScanMgmt *mgmt = (HT_ScanMgmt *)handle->mgmtData;
+
+    if (mgmt->next >= mgmt->count) return RC_IM_NO_MORE_ENTRIES;
+
+    HT_Match *match = &mgmt->matches[mgmt->next++];
+    *result = match->rid;
+    if (key != NULL) memcpy(key, mgmt->keys + (size_t)match->position * mgmt->key_size, mgmt->key_size);
+    return RC_OK;
+}
+
+extern RC closeHashScan(HT_ScanHandle *handle) {
+    HT_ScanMgmt *mgmt = (HT_ScanMgmt *)handle->mgmtData;
+
+    free(mgmt->matches);
+    free(mgmt->keys);
+    free(mgmt);
+    free(handle);
+    return RC_OK;
+}
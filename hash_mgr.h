@@ -0,0 +1,45 @@
+#ifndef HASH_MGR_H
+#define HASH_MGR_H
+
+#include "dberror.h"
+#include "tables.h"
+
+// structure for accessing hash indexes
+typedef struct HashHandle {
+	char *idxId;
+	int keySize;		// bytes of a packed key
+	void *mgmtData;
+} HashHandle;
+
+typedef struct HT_ScanHandle {
+	HashHandle *index;
+	void *mgmtData;
+} HT_ScanHandle;
+
+// Keys are packed the same way as for the B+-tree: the key attributes one after the
+// other, each stored the way a record stores it, followed by the included attributes
+// that are carried along but not hashed. Only equality lookups are supported.
+
+// create, destroy, open, and close a hash index
+extern RC createHashIndex (char *idxId, int numKeyAttrs, int numIncludedAttrs, DataType *keyTypes, int *keyLengths, bool unique);
+extern RC openHashIndex (HashHandle **index, char *idxId);
+extern RC closeHashIndex (HashHandle *index);
+extern RC deleteHashIndex (char *idxId);
+
+// access information about a hash index
+extern RC getNumBuckets (HashHandle *index, int *result);
+extern RC getNumHashEntries (HashHandle *index, int *result);
+
+// index access
+extern RC packHashKey (HashHandle *index, Value **values, char *key);
+extern RC findHashKey (HashHandle *index, char *key, RID *result);
+extern RC insertHashKey (HashHandle *index, char *key, RID rid);
+extern RC deleteHashKey (HashHandle *index, char *key, RID rid);
+
+// all RIDs of a key, in page order
+extern RC openHashScan (HashHandle *index, char *key, HT_ScanHandle **handle);
+extern RC nextHashEntry (HT_ScanHandle *handle, RID *result);
+extern RC nextHashKeyEntry (HT_ScanHandle *handle, char *key, RID *result);
+extern RC closeHashScan (HT_ScanHandle *handle);
+
+#endif // HASH_MGR_H
@@ -1,10 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
 #include "record_mgr.h"
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "expr.h"
+#include "btree_mgr.h"
+#include "hash_mgr.h"
 
 // Structure of the record manager
 typedef struct RecordManager {
@@ -17,17 +22,235 @@ typedef struct RecordManager {
     int last_page;                   // Last page number
     int max_slots;                   // Maximum number of slots
     int num_scanned;                 // Number of scanned records
+    int fsm_hint;                    // Lowest data page that may have a free slot
+    RM_Layout layout;                // How records are laid out on data pages
+    int record_size;                 // Size of one record
+    int *attr_offsets;               // Offset of every attribute in a record
+    int *attr_sizes;                 // Bytes every attribute takes
+    Schema *stored;                  // Records as the data pages hold them, encoded attributes as DT_INT codes
+    struct RM_Dictionary *dictionary; // Strings of the dictionary-encoded attributes, NULL if the table has none
+    char *stored_row;                // A record converted to or from its stored form
+    char *zone_maps;                 // Zone map entry of every page, indexed by page number
+    int *zone_offsets;               // Offset of an attribute's min in a zone entry, -1 if not summarized
+    int zone_entry_size;             // Bytes per zone map entry
+    int zone_pages;                  // Pages covered by zone_maps
+    struct RM_Index *indexes;        // Indexes kept up to date by every write
+    int num_indexes;
+    char *row_buffer;                // Copy of a slot taken before it is changed
+    bool *var_attrs;                 // RM_LAYOUT_SLOTTED: attributes stored at their actual length
+    int *tuple_offsets;              // Offset of a fixed-width attribute, or of a string's length, in a stored tuple
+    int tuple_fixed_size;            // Bytes of a stored tuple before the string bytes, its shortest length
+    int max_tuple_size;              // Bytes of a stored tuple whose strings take their full length
+    int grow_reserve;                // Free bytes a slotted page keeps for its records to grow
+    char *tuple_buffer;              // Tuple being encoded for a slotted page
+    char *page_buffer;               // Scratch copy of a slotted page being compacted
+    bool header_dirty;               // Counts above differ from the header on page 0
+    int header_changes;              // Changes since the header was last written
+    struct RM_TableStats *stats;     // From the last analyzeTable, NULL if the table was never analyzed
 } RecordManager;
 
+// Index on some attributes of a table
+typedef struct RM_Index {
+    RM_IndexType type;
+    BTreeHandle *tree;               // RM_INDEX_BTREE
+    HashHandle *hash;                // RM_INDEX_HASH
+    char name[RM_MAX_INDEX_NAME];    // Empty for the primary key index
+    bool primary;                    // Unique index on the schema key
+    bool unique;
+    int key_size;                    // Bytes of a packed key with its included attributes
+    int key_part_size;               // Bytes of the key attributes alone, at the front
+    int num_key_attrs;
+    int num_included_attrs;          // Stored in the entries but not part of the key
+    int *key_attrs;                  // Attributes forming the key in key order, then the included ones
+    char *key;                       // Scratch space for a packed key
+    char *old_key;                   // Scratch space for the key a record had before an update
+} RM_Index;
+
+// Open cursor on a tree or hash index
+typedef struct RM_IndexCursor {
+    RM_Index *index;
+    BT_ScanHandle *tree_scan;
+    HT_ScanHandle *hash_scan;
+} RM_IndexCursor;
+
 // Structure for scan functions
 typedef struct RM_ScanManager {
     Expr *cond;                     // Condition for scanning
-    Record *current_record;         // Current record being scanned
+    Record *current_record;         // Points into the pinned page at the slot being evaluated
     int current_page;               // Current page number during scan
     int current_slot;               // Current slot in the page during scan
     int scanned_count;              // Count of records scanned so far
+    int record_size;                // Size of one slot
+    BM_PageHandle page;             // Current page, pinned while its slots are scanned
+    bool page_pinned;               // Whether page is pinned
+    Schema *projection;             // Schema of the returned records, NULL to return whole records
+    struct RM_CopyRun *runs;        // Byte ranges copied out of a matching slot for a projection
+    int num_runs;
+    char *row_buffer;               // Record gathered from a PAX page or decoded, NULL for row pages read in place
+    Expr *coded_cond;               // cond on the codes of encoded attributes, evaluated on stored records
+    char *stored_row;               // Stored record gathered for coded_cond from a PAX or slotted page
+    bool use_index;                 // Visit only the RIDs an index returned for cond
+    RID *index_rids;                // Those RIDs, in page order
+    int num_index_rids;
+    int next_rid;
+    bool covered;                   // Answered from the entries of an index alone
+    RM_IndexCursor cursor;          // Open on that index while the scan runs
+    char *covered_key;              // Entry read from the cursor
+    char *covered_row;              // Record rebuilt from it, attributes the scan does not read stay zero
+    Arena *arena;                   // Values of cond, reset after every record and at closeScan
+    Arena own_arena;                // Used when the caller did not pass an arena
 } RM_ScanManager;
 
+// Contiguous bytes copied from a slot into a projected record
+typedef struct RM_CopyRun {
+    int src;                        // Offset in the slot
+    int dst;                        // Offset in the projected record
+    int length;
+} RM_CopyRun;
+
+// Header at the start of every data page, followed by the occupancy bitmap and the slots:
+// [RM_PageHeader][bitmap, one bit per slot][slot 0][slot 1]...
+typedef struct RM_PageHeader {
+    int num_slots;                  // Slots on this page, 0 if the page was never formatted
+    int free_slots;                 // Slots not holding a record
+} RM_PageHeader;
+
+#define BITMAP_WORD_BITS 32
+#define BITMAP_WORDS(slots) (((slots) + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS)
+#define PAGE_HEADER(data) ((RM_PageHeader *)(data))
+#define PAGE_BITMAP(data) ((unsigned int *)((data) + sizeof(RM_PageHeader)))
+#define PAGE_SLOTS(data) ((data) + sizeof(RM_PageHeader) + BITMAP_WORDS(PAGE_HEADER(data)->num_slots) * sizeof(unsigned int))
+
+// With RM_LAYOUT_PAX the slot area holds one column per attribute instead of one row per slot:
+// [header][bitmap][attr 0 of every slot][attr 1 of every slot]...
+// Column a starts at num_slots * offset of a, so both layouts fit the same number of slots.
+#define PAX_COLUMN(data, offset) (PAGE_SLOTS(data) + PAGE_HEADER(data)->num_slots * (offset))
+
+// With RM_LAYOUT_SLOTTED records are stored at their actual length, strings without the '\0'
+// padding after their last character:
+// [RM_SlottedHeader][slot directory][free space][tuples, packed toward the end of the page]
+// A stored tuple is [fixed-width attributes][length of every string][string bytes], so the
+// fixed-width attributes keep fixed offsets. The directory grows by an entry whenever no entry
+// is free. Deletes and shrinking updates leave holes, which are squeezed out once a tuple does
+// not fit between the directory and the tuples.
+typedef struct RM_SlottedHeader {
+    RM_PageHeader slots;            // num_slots counts directory entries, free_slots those without a record
+    int data_start;                 // Tuples fill the page from here to its end, 0 if never formatted
+    int hole_bytes;                 // Bytes freed in the tuple area since the page was last compacted
+} RM_SlottedHeader;
+
+typedef struct RM_SlotEntry {
+    unsigned short offset;
+    unsigned short length;          // 0 for a free slot
+} RM_SlotEntry;
+
+#define SLOTTED_HEADER(data) ((RM_SlottedHeader *)(data))
+#define SLOT_DIRECTORY(data) ((RM_SlotEntry *)((data) + sizeof(RM_SlottedHeader)))
+#define SLOTTED_MAX_RESERVE (PAGE_SIZE / 8)  // Cap on the room a slotted page keeps for growing records
+
+// Zone maps: per data page, the min and max of every INT, FLOAT and STRING attribute,
+// kept in memory and saved to <table>.zm on close. A zone entry is
+// [state][pad][min attr 0][max attr 0][min attr 1]...; entries only ever widen while
+// records are written, deletes leave them loose until the page runs empty.
+#define ZONE_MAGIC "ZMP1"
+#define ZONE_EMPTY 0                // No record was written to the page
+#define ZONE_VALID 1                // Bounds cover every record on the page
+
+typedef struct RM_ZoneFileHeader {
+    char magic[4];
+    int clean;                      // 0 while the table is open, the file is rebuilt if a crash left it so
+    int entry_size;
+    int num_pages;
+} RM_ZoneFileHeader;
+
+// Dictionary encoding: data pages hold an int code in place of the string of an encoded
+// attribute, codes numbered per attribute in the order its strings first appear. The strings
+// are kept in <table>.dict, a page file: page 0 is [RM_DictFileHeader][1 if attribute 0 is
+// encoded][1 if attribute 1 is encoded]..., the pages after it hold entries
+// [attribute][length + 1][string without its '\0' padding] until a zero length. A new entry
+// is written to the file before any record holding its code can reach a data page.
+#define DICT_MAGIC "DIC1"
+#define DICT_ENTRY_HEADER (2 * (int)sizeof(unsigned short))
+
+typedef struct RM_DictFileHeader {
+    char magic[4];
+    int num_attrs;
+} RM_DictFileHeader;
+
+// Distinct strings of one encoded attribute
+typedef struct RM_DictColumn {
+    int width;                      // typeLength of the attribute
+    int num_codes;
+    int capacity;
+    char *strings;                  // String of code c at c * width, padded with '\0'
+    int *buckets;                   // Open addressing on the string hash: code + 1, 0 for an empty bucket
+    int num_buckets;                // Power of two, more than twice num_codes
+} RM_DictColumn;
+
+typedef struct RM_Dictionary {
+    int num_attrs;
+    bool *encoded;                  // Per attribute
+    RM_DictColumn *columns;         // Per attribute, left empty for those not encoded
+    char *file_name;
+    char *page;                     // Copy of the last page of the file, new entries are appended to it
+    int page_num;                   // 0 while the file has no entry page
+    int page_used;                  // Bytes of entries on that page
+} RM_Dictionary;
+
+// Table header on page 0, followed by the serialized schema. It is read once by openTable;
+// changes are kept in the RecordManager and written back on close, on checkpointTable and
+// after every HEADER_FLUSH_CHANGES changes.
+#define TABLE_MAGIC "TBL1"
+#define HEADER_FLUSH_CHANGES 1024
+
+typedef struct RM_TableHeader {
+    char magic[4];
+    int num_tuples;
+    int start_page;
+    int last_page;
+    int max_slots;
+    int layout;
+} RM_TableHeader;
+
+// Statistics written by analyzeTable on page 0 after the serialized schema:
+// [RM_StatsHeader][RM_AttrStats attr 0][num_buckets + 1 histogram bounds of attr 0][RM_AttrStats attr 1]...
+// Every value is kept as a double: numbers as they are, strings as their first STATS_STRING_PREFIX
+// bytes read as a base-256 number, which orders the same way strcmp does.
+#define STATS_MAGIC "STA1"
+#define STATS_MAX_BUCKETS 16         // Equi-depth buckets per attribute, fewer when page 0 lacks room
+#define STATS_SAMPLE_PAGES 64        // Data pages analyzeTable reads, spread over the table
+#define STATS_STRING_PREFIX 6
+#define HLL_BITS 10                  // 2^10 HyperLogLog registers, about 3% error
+
+typedef struct RM_StatsHeader {
+    char magic[4];
+    int num_attrs;
+    int num_buckets;
+    int num_tuples;                  // Tuples in the table when it was analyzed
+    int sampled_rows;
+} RM_StatsHeader;
+
+typedef struct RM_AttrStats {
+    double min;
+    double max;
+    double distinct;                 // Estimated number of distinct values
+    float null_fraction;             // Always 0 while records cannot hold NULLs
+    int reserved;
+} RM_AttrStats;
+
+typedef struct RM_TableStats {
+    RM_StatsHeader header;
+    RM_AttrStats *attrs;
+    double *bounds;                  // num_buckets + 1 per attribute, rows split evenly between them
+} RM_TableStats;
+
+// Free-space map: page 1 and every FSM_GROUP-th page after it hold the number of used
+// slots of the FSM_ENTRIES data pages that follow them
+// [0 table header][1 FSM][2 .. FSM_ENTRIES+1 data][FSM_ENTRIES+2 FSM][data] ...
+#define FSM_ENTRIES (PAGE_SIZE / (int)sizeof(unsigned short))
+#define FSM_GROUP (FSM_ENTRIES + 1)
+#define FIRST_DATA_PAGE 2
+
 // Max pages and attribute length constants
 const int maxPages = 100;
 const int max_Attr_length = 15;
@@ -35,263 +258,4035 @@ const int max_Attr_length = 15;
 // Pointer to record manager
 RecordManager *record_mgr;
 
-// Function to find free slot in a page
-int findFreeSlot(char *data, int recordSize) {
-    int slotindex = 0;
-    int total_slots_in_page = PAGE_SIZE / recordSize;
-
-    while (slotindex < total_slots_in_page) {
-        if (data[slotindex * recordSize] == '\0') return slotindex;
-        else slotindex++;
+// Bytes one attribute takes in a record
+static int attrSize(DataType type, int typeLength) {
+    switch (type) {
+        case DT_INT:   return sizeof(int);
+        case DT_FLOAT: return sizeof(float);
+        case DT_STRING: return typeLength;
+        case DT_BOOL:  return sizeof(bool);
     }
-    return -1;  // No free slots found
+    return 0;
 }
 
-/*************************** Record Manager *******************************************/
-// Initialize record manager
-extern RC initRecordManager(void *mgmtData) {
-    initStorageManager();
-    return RC_OK;
-}
+// Compute the offset and size of every attribute and the record size of a schema, once
+static RC initSchemaLayout(Schema *schema) {
+    schema->attrOffsets = (int *)malloc(sizeof(int) * schema->numAttr);
+    schema->attrSizes = (int *)malloc(sizeof(int) * schema->numAttr);
+    if (schema->attrOffsets == NULL || schema->attrSizes == NULL) {
+        free(schema->attrOffsets);
+        free(schema->attrSizes);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
 
-// Shut down record manager
-extern RC shutdownRecordManager() {
-    if (record_mgr != NULL) {
-        free(record_mgr);
-        record_mgr = NULL;
+    schema->recordSize = 0;
+    for (int i = 0; i < schema->numAttr; i++) {
+        schema->attrOffsets[i] = schema->recordSize;
+        schema->attrSizes[i] = attrSize(schema->dataTypes[i], schema->typeLength[i]);
+        schema->recordSize += schema->attrSizes[i];
     }
     return RC_OK;
 }
 
-/***************************** Table Functions *****************************************/
-// Create table
-extern RC createTable(char *name, Schema *schema) {
-    if (name == NULL || schema == NULL) return RC_FILE_NOT_FOUND;
+// Layout of a record on the data pages: schema with every encoded attribute turned into an
+// int code. The names and lengths are shared with schema.
+static Schema *storedSchema(Schema *schema, bool *encoded) {
+    Schema *stored = (Schema *)malloc(sizeof(Schema));
+    if (stored == NULL) return NULL;
 
-    record_mgr = (RecordManager *)malloc(sizeof(RecordManager));
-    RC status = initBufferPool(&record_mgr->poolconfig, name, maxPages, RS_LRU, NULL);
-    
-    if (status != RC_OK) {
-        free(record_mgr);
-        return status;
+    *stored = *schema;
+    stored->dataTypes = (DataType *)malloc(sizeof(DataType) * schema->numAttr);
+    if (stored->dataTypes == NULL) {
+        free(stored);
+        return NULL;
+    }
+    for (int i = 0; i < schema->numAttr; i++)
+        stored->dataTypes[i] = (encoded != NULL && encoded[i]) ? DT_INT : schema->dataTypes[i];
+
+    if (initSchemaLayout(stored) != RC_OK) {
+        free(stored->dataTypes);
+        free(stored);
+        return NULL;
     }
+    return stored;
+}
+
+static void freeStoredSchema(Schema *stored) {
+    if (stored == NULL) return;
+    free(stored->dataTypes);
+    free(stored->attrOffsets);
+    free(stored->attrSizes);
+    free(stored);
+}
 
-    int slotSize = 0;
+// Shortest and longest tuple a record of the schema is stored as on a slotted page
+static void tupleSizes(Schema *schema, int *minSize, int *maxSize) {
+    *minSize = 0;
+    *maxSize = 0;
     for (int i = 0; i < schema->numAttr; i++) {
-        switch (schema->dataTypes[i]) {
-            case DT_INT:   slotSize += sizeof(int); break;
-            case DT_FLOAT: slotSize += sizeof(float); break;
-            case DT_STRING: slotSize += schema->typeLength[i]; break;
-            case DT_BOOL:  slotSize += sizeof(bool); break;
-            default: return RC_ERROR;
+        if (schema->dataTypes[i] == DT_STRING) {
+            *minSize += sizeof(unsigned short);
+            *maxSize += sizeof(unsigned short) + schema->typeLength[i];
+        } else {
+            *minSize += schema->attrSizes[i];
+            *maxSize += schema->attrSizes[i];
         }
     }
-    
-    int maxSlots = PAGE_SIZE / slotSize;
-    record_mgr->num_tuples = 0;
-    record_mgr->start_page = 1;
-    record_mgr->last_page = 1;
-    record_mgr->max_slots = maxSlots;
+}
 
-    // Create page file for table
-    status = createPageFile(name);
-    if (status != RC_OK) {
-        shutdownBufferPool(&record_mgr->poolconfig);
-        free(record_mgr);
-        return status;
+// Free what initRecordLayout allocated
+static void freeRecordLayout(RecordManager *rm) {
+    free(rm->attr_offsets);
+    free(rm->attr_sizes);
+    free(rm->row_buffer);
+    freeStoredSchema(rm->stored);
+    free(rm->stored_row);
+    free(rm->var_attrs);
+    free(rm->tuple_offsets);
+    free(rm->tuple_buffer);
+    free(rm->page_buffer);
+    rm->attr_offsets = NULL;
+    rm->attr_sizes = NULL;
+    rm->row_buffer = NULL;
+    rm->stored = NULL;
+    rm->stored_row = NULL;
+    rm->var_attrs = NULL;
+    rm->tuple_offsets = NULL;
+    rm->tuple_buffer = NULL;
+    rm->page_buffer = NULL;
+}
+
+// Cache the record size and the attribute offsets and sizes of the table, how its records
+// are stored once encoded attributes are replaced by their codes, and for a slotted table
+// where every attribute sits in a stored tuple
+static RC initRecordLayout(RecordManager *rm, Schema *schema) {
+    rm->stored_row = NULL;
+    rm->var_attrs = NULL;
+    rm->tuple_offsets = NULL;
+    rm->tuple_buffer = NULL;
+    rm->page_buffer = NULL;
+    rm->attr_offsets = (int *)malloc(sizeof(int) * schema->numAttr);
+    rm->attr_sizes = (int *)malloc(sizeof(int) * schema->numAttr);
+    rm->record_size = schema->recordSize;
+    rm->row_buffer = (char *)malloc(rm->record_size);
+    rm->stored = storedSchema(schema, rm->dictionary != NULL ? rm->dictionary->encoded : NULL);
+    if (rm->attr_offsets == NULL || rm->attr_sizes == NULL || rm->row_buffer == NULL || rm->stored == NULL) {
+        freeRecordLayout(rm);
+        return RC_MEMORY_ALLOCATION_FAILED;
     }
 
-    SM_FileHandle fh;
-    status = openPageFile(name, &fh);
-    if (status != RC_OK) {
-        shutdownBufferPool(&record_mgr->poolconfig);
-        free(record_mgr);
-        return status;
+    memcpy(rm->attr_offsets, schema->attrOffsets, sizeof(int) * schema->numAttr);
+    memcpy(rm->attr_sizes, schema->attrSizes, sizeof(int) * schema->numAttr);
+    if (rm->dictionary != NULL) {
+        rm->stored_row = (char *)malloc(rm->stored->recordSize);
+        if (rm->stored_row == NULL) {
+            freeRecordLayout(rm);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
     }
+    if (rm->layout != RM_LAYOUT_SLOTTED) return RC_OK;
 
-    // Serialize schema and write to disk
-    char *serialized_data = serializeSchema(schema);
-    status = writeBlock(0, &fh, serialized_data);
+    Schema *stored = rm->stored;
+    tupleSizes(stored, &rm->tuple_fixed_size, &rm->max_tuple_size);
+    rm->grow_reserve = rm->max_tuple_size - rm->tuple_fixed_size;
+    if (rm->grow_reserve > SLOTTED_MAX_RESERVE) rm->grow_reserve = SLOTTED_MAX_RESERVE;
 
-    if (status != RC_OK) {
-        shutdownBufferPool(&record_mgr->poolconfig);
-        free(serialized_data);
-        closePageFile(&fh);
-        free(record_mgr);
-        return status;
+    rm->var_attrs = (bool *)malloc(sizeof(bool) * schema->numAttr);
+    rm->tuple_offsets = (int *)malloc(sizeof(int) * schema->numAttr);
+    rm->tuple_buffer = (char *)malloc(rm->max_tuple_size);
+    rm->page_buffer = (char *)malloc(PAGE_SIZE);
+    if (rm->var_attrs == NULL || rm->tuple_offsets == NULL || rm->tuple_buffer == NULL || rm->page_buffer == NULL) {
+        freeRecordLayout(rm);
+        return RC_MEMORY_ALLOCATION_FAILED;
     }
 
-    closePageFile(&fh);
-    free(serialized_data);
+    // fixed-width attributes first, then the string lengths, both in schema order
+    int offset = 0;
+    for (int i = 0; i < schema->numAttr; i++) {
+        rm->var_attrs[i] = (stored->dataTypes[i] == DT_STRING);
+        if (rm->var_attrs[i]) continue;
+        rm->tuple_offsets[i] = offset;
+        offset += stored->attrSizes[i];
+    }
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (!rm->var_attrs[i]) continue;
+        rm->tuple_offsets[i] = offset;
+        offset += sizeof(unsigned short);
+    }
     return RC_OK;
 }
 
-// Open table
-extern RC openTable(RM_TableData *rel, char *name) {
-    RecordManager *record_mgr = (RecordManager *)malloc(sizeof(RecordManager));
-    if (record_mgr == NULL) return RC_ERROR;
+// Hash of the first length bytes of a string, FNV-1a
+static unsigned int dictHash(char *value, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) hash = (hash ^ (unsigned char)value[i]) * 16777619u;
+    return hash;
+}
 
-    BM_BufferPool *bufferpool = (BM_BufferPool *)malloc(sizeof(BM_BufferPool));
-    rel->mgmtData = record_mgr;
-    rel->name = name;
+// Code of a string of an encoded attribute, -1 if the dictionary does not hold it. Like
+// strcmp, only the bytes before the first '\0' count.
+static int dictionaryCode(RM_DictColumn *column, char *value) {
+    int length = strnlen(value, column->width);
+    if (column->num_buckets == 0) return -1;
 
-    RC status = initBufferPool(&record_mgr->poolconfig, name, maxPages, RS_FIFO, NULL);
-    if (status != RC_OK) {
-        free(record_mgr);
-        return status;
+    unsigned int mask = column->num_buckets - 1;
+    for (unsigned int b = dictHash(value, length) & mask; column->buckets[b] != 0; b = (b + 1) & mask) {
+        char *candidate = column->strings + (size_t)(column->buckets[b] - 1) * column->width;
+        if (memcmp(candidate, value, length) == 0 && (length == column->width || candidate[length] == '\0'))
+            return column->buckets[b] - 1;
     }
+    return -1;
+}
 
-    SM_FileHandle fh;
-    status = openPageFile(name, &fh);
-    if (status != RC_OK) {
-        shutdownBufferPool(&record_mgr->poolconfig);
-        free(record_mgr);
-        return status;
+// Give the next code of an attribute to a string it does not hold yet
+static RC dictionaryRemember(RM_DictColumn *column, char *value, int length) {
+    if (column->num_codes == column->capacity) {
+        int capacity = column->capacity > 0 ? column->capacity * 2 : 16;
+        char *strings = (char *)realloc(column->strings, (size_t)capacity * column->width);
+        if (strings == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+        column->strings = strings;
+        column->capacity = capacity;
     }
 
-    BM_PageHandle pH;
-    status = pinPage(&record_mgr->poolconfig, &pH, 0); 
-    if (status != RC_OK) {
-        shutdownBufferPool(&record_mgr->poolconfig);
-        free(record_mgr);
-        return status;
+    // rehash into twice the buckets before they are half full
+    if ((column->num_codes + 1) * 2 > column->num_buckets) {
+        int num_buckets = column->num_buckets > 0 ? column->num_buckets * 2 : 32;
+        int *buckets = (int *)calloc(num_buckets, sizeof(int));
+        if (buckets == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+        for (int code = 0; code < column->num_codes; code++) {
+            char *string = column->strings + (size_t)code * column->width;
+            unsigned int b = dictHash(string, strnlen(string, column->width)) & (num_buckets - 1);
+            while (buckets[b] != 0) b = (b + 1) & (num_buckets - 1);
+            buckets[b] = code + 1;
+        }
+        free(column->buckets);
+        column->buckets = buckets;
+        column->num_buckets = num_buckets;
     }
 
-    char *page_data = pH.data;
-    int num_tuples, start_page, last_page, max_slots;
-    
-    memcpy(&num_tuples, page_data, sizeof(int));
-    page_data += sizeof(int);
-    memcpy(&start_page, page_data, sizeof(int));
-    page_data += sizeof(int);
-    memcpy(&last_page, page_data, sizeof(int));
-    page_data += sizeof(int);
-    memcpy(&max_slots, page_data, sizeof(int));
+    int code = column->num_codes++;
+    char *string = column->strings + (size_t)code * column->width;
+    memcpy(string, value, length);
+    memset(string + length, 0, column->width - length);
 
-    record_mgr->num_tuples = num_tuples;
-    record_mgr->start_page = start_page;
-    record_mgr->last_page = last_page;
-    record_mgr->max_slots = max_slots;
+    unsigned int b = dictHash(string, length) & (column->num_buckets - 1);
+    while (column->buckets[b] != 0) b = (b + 1) & (column->num_buckets - 1);
+    column->buckets[b] = code + 1;
+    return RC_OK;
+}
 
-    Schema *schema = deserializeSchema(page_data);
-    rel->schema = schema;
-    rel->name = name;
-    rel->mgmtData = (void *)record_mgr;
+// Convert a record into its stored form, the strings of encoded attributes replaced by
+// their codes, which must already exist
+static void encodeRow(RecordManager *rm, int numAttrs, char *src, char *stored) {
+    RM_Dictionary *dict = rm->dictionary;
 
-    status = unpinPage(bufferpool, &pH);
-    if (status != RC_OK) {
-        free(record_mgr);
-        free(schema);
-        shutdownBufferPool(bufferpool);
-        free(bufferpool);
-        return status;
+    for (int i = 0; i < numAttrs; i++) {
+        char *value = src + rm->attr_offsets[i], *dest = stored + rm->stored->attrOffsets[i];
+        if (dict->encoded[i]) {
+            int code = dictionaryCode(&dict->columns[i], value);
+            memcpy(dest, &code, sizeof(int));
+        } else {
+            memcpy(dest, value, rm->attr_sizes[i]);
+        }
+    }
+}
+
+// Convert a stored record back, looking up the string of every code
+static void decodeRow(RecordManager *rm, int numAttrs, char *stored, char *dest) {
+    RM_Dictionary *dict = rm->dictionary;
+
+    for (int i = 0; i < numAttrs; i++) {
+        char *value = stored + rm->stored->attrOffsets[i], *to = dest + rm->attr_offsets[i];
+        if (dict->encoded[i]) {
+            int code;
+            memcpy(&code, value, sizeof(int));
+            memcpy(to, dict->columns[i].strings + (size_t)code * dict->columns[i].width, rm->attr_sizes[i]);
+        } else {
+            memcpy(to, value, rm->attr_sizes[i]);
+        }
+    }
+}
+
+// The stored form of a record: the record itself, or its encoded copy in stored_row
+static char *storedRow(RecordManager *rm, int numAttrs, char *row) {
+    if (rm->dictionary == NULL) return row;
+    encodeRow(rm, numAttrs, row, rm->stored_row);
+    return rm->stored_row;
+}
+
+// Pack a stored record into its tuple, strings cut after their last non-'\0' byte; returns its length
+static int encodeTuple(RecordManager *rm, int numAttrs, char *src, char *tuple) {
+    char *var = tuple + rm->tuple_fixed_size;
+
+    for (int i = 0; i < numAttrs; i++) {
+        char *value = src + rm->stored->attrOffsets[i];
+        int size = rm->stored->attrSizes[i];
+        if (!rm->var_attrs[i]) {
+            memcpy(tuple + rm->tuple_offsets[i], value, size);
+            continue;
+        }
+        unsigned short length = size;
+        while (length > 0 && value[length - 1] == '\0') length--;
+        memcpy(tuple + rm->tuple_offsets[i], &length, sizeof(length));
+        memcpy(var, value, length);
+        var += length;
+    }
+    return (int)(var - tuple);
+}
+
+// Unpack a tuple into a stored record, padding its strings with '\0' again
+static void decodeTuple(RecordManager *rm, int numAttrs, char *tuple, char *dest) {
+    char *var = tuple + rm->tuple_fixed_size;
+
+    for (int i = 0; i < numAttrs; i++) {
+        char *value = dest + rm->stored->attrOffsets[i];
+        int size = rm->stored->attrSizes[i];
+        if (!rm->var_attrs[i]) {
+            memcpy(value, tuple + rm->tuple_offsets[i], size);
+            continue;
+        }
+        unsigned short length;
+        memcpy(&length, tuple + rm->tuple_offsets[i], sizeof(length));
+        memcpy(value, var, length);
+        memset(value + length, 0, size - length);
+        var += length;
+    }
+}
+
+// Move the tuples of a slotted page together at its end, leaving one free gap after the directory
+static void compactSlottedPage(RecordManager *rm, char *data) {
+    RM_SlottedHeader *header = SLOTTED_HEADER(data);
+    RM_SlotEntry *directory = SLOT_DIRECTORY(data);
+    int end = PAGE_SIZE;
+
+    for (int slot = 0; slot < header->slots.num_slots; slot++) {
+        if (directory[slot].length == 0) continue;
+        end -= directory[slot].length;
+        memcpy(rm->page_buffer + end, data + directory[slot].offset, directory[slot].length);
+        directory[slot].offset = end;
+    }
+    memcpy(data + end, rm->page_buffer + end, PAGE_SIZE - end);
+    header->data_start = end;
+    header->hole_bytes = 0;
+}
+
+// Bytes a slotted page has for tuples, in the gap and in its holes
+static int slottedFreeBytes(char *data) {
+    RM_SlottedHeader *header = SLOTTED_HEADER(data);
+    int directory_end = sizeof(RM_SlottedHeader) + header->slots.num_slots * sizeof(RM_SlotEntry);
+    return header->data_start - directory_end + header->hole_bytes;
+}
+
+// Copy the stored record in slot into dest, gathering it from the columns of a PAX page or
+// unpacking it from a slotted page
+static void readStored(RecordManager *rm, int numAttrs, char *data, int slot, char *dest) {
+    Schema *stored = rm->stored;
+
+    if (rm->layout == RM_LAYOUT_ROW) {
+        memcpy(dest, PAGE_SLOTS(data) + slot * stored->recordSize, stored->recordSize);
+        return;
+    }
+    if (rm->layout == RM_LAYOUT_SLOTTED) {
+        decodeTuple(rm, numAttrs, data + SLOT_DIRECTORY(data)[slot].offset, dest);
+        return;
+    }
+    for (int i = 0; i < numAttrs; i++)
+        memcpy(dest + stored->attrOffsets[i], PAX_COLUMN(data, stored->attrOffsets[i]) + slot * stored->attrSizes[i], stored->attrSizes[i]);
+}
+
+// Copy the record in slot into dest, with the strings of its codes
+static void readSlot(RecordManager *rm, int numAttrs, char *data, int slot, char *dest) {
+    if (rm->dictionary == NULL) {
+        readStored(rm, numAttrs, data, slot, dest);
+        return;
+    }
+    readStored(rm, numAttrs, data, slot, rm->stored_row);
+    decodeRow(rm, numAttrs, rm->stored_row, dest);
+}
+
+// Store a stored record as the tuple of a slotted page slot, which may be free, in use, or
+// the entry right after the directory. The tuple is rewritten in place when it does not grow.
+static RC writeTuple(RecordManager *rm, int numAttrs, char *data, int slot, char *src) {
+    RM_SlottedHeader *header = SLOTTED_HEADER(data);
+    RM_SlotEntry *directory = SLOT_DIRECTORY(data);
+    int length = encodeTuple(rm, numAttrs, src, rm->tuple_buffer);
+    bool new_entry = (slot == header->slots.num_slots);
+    int old_length = new_entry ? 0 : directory[slot].length;
+
+    if (length <= old_length) {
+        memcpy(data + directory[slot].offset, rm->tuple_buffer, length);
+        header->hole_bytes += old_length - length;
+        directory[slot].length = length;
+        return RC_OK;
+    }
+
+    int needed = length + (new_entry ? (int)sizeof(RM_SlotEntry) : 0);
+    if (slottedFreeBytes(data) + old_length < needed) return RC_RM_RECORD_DOES_NOT_FIT;
+
+    // the old tuple becomes a hole, squeezed out with the others when the gap is too small
+    if (old_length > 0) {
+        header->hole_bytes += old_length;
+        directory[slot].length = 0;
     }
+    int directory_end = sizeof(RM_SlottedHeader) + header->slots.num_slots * sizeof(RM_SlotEntry);
+    if (header->data_start - directory_end < needed) compactSlottedPage(rm, data);
+
+    if (new_entry) {
+        header->slots.num_slots++;
+        header->slots.free_slots++;
+    }
+    if (old_length == 0) header->slots.free_slots--;
+    header->data_start -= length;
+    memcpy(data + header->data_start, rm->tuple_buffer, length);
+    directory[slot].offset = header->data_start;
+    directory[slot].length = length;
     return RC_OK;
 }
 
-// Close table
-extern RC closeTable(RM_TableData *rel) {
-    RecordManager *record_mgr = rel->mgmtData;
-    shutdownBufferPool(&record_mgr->poolconfig);
-    free(record_mgr);
+// Checks whether src can replace the record in slot without leaving the page
+static bool slotHasRoom(RecordManager *rm, int numAttrs, char *data, int slot, char *src) {
+    if (rm->layout != RM_LAYOUT_SLOTTED) return TRUE;
+
+    int length = encodeTuple(rm, numAttrs, storedRow(rm, numAttrs, src), rm->tuple_buffer);
+    return length <= SLOT_DIRECTORY(data)[slot].length + slottedFreeBytes(data);
+}
+
+// Copy src into slot, scattering it over the columns of a PAX page or packing it into a
+// slotted page, where it marks the slot used; only a slotted page can run out of room.
+// The strings of encoded attributes must already have codes.
+static RC writeSlot(RecordManager *rm, int numAttrs, char *data, int slot, char *src) {
+    Schema *stored = rm->stored;
+
+    src = storedRow(rm, numAttrs, src);
+    if (rm->layout == RM_LAYOUT_ROW) {
+        memcpy(PAGE_SLOTS(data) + slot * stored->recordSize, src, stored->recordSize);
+        return RC_OK;
+    }
+    if (rm->layout == RM_LAYOUT_SLOTTED) return writeTuple(rm, numAttrs, data, slot, src);
+
+    for (int i = 0; i < numAttrs; i++)
+        memcpy(PAX_COLUMN(data, stored->attrOffsets[i]) + slot * stored->attrSizes[i], src + stored->attrOffsets[i], stored->attrSizes[i]);
     return RC_OK;
 }
 
-// Delete table
-extern RC deleteTable(char *name) {
-    return destroyPageFile(name) == RC_OK ? RC_OK : RC_FILE_NOT_FOUND;
+// Number of slots that fit on a page next to the header and the bitmap
+static int slotsPerPage(int recordSize) {
+    int slots = ((PAGE_SIZE - (int)sizeof(RM_PageHeader)) * 8) / (recordSize * 8 + 1);
+
+    while (slots > 0 && sizeof(RM_PageHeader) + BITMAP_WORDS(slots) * sizeof(unsigned int) + slots * recordSize > PAGE_SIZE)
+        slots--;
+    return slots;
 }
 
-// Get number of tuples in the table
-extern int getNumTuples(RM_TableData *rel) {
-    return ((RecordManager *)rel->mgmtData)->num_tuples;
+// Checks whether a page of the table file belongs to the free-space map
+static bool isFsmPage(int page) {
+    return page >= 1 && (page - 1) % FSM_GROUP == 0;
 }
 
-/******************************** Record Functions ************************************/
-// Insert record into table
-extern RC insertRecord(RM_TableData *rel, Record *record) {
-    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
-    BM_PageHandle pH;
+// FSM page and entry that describe a data page
+static int fsmPageFor(int dataPage) {
+    return 1 + ((dataPage - 1) / FSM_GROUP) * FSM_GROUP;
+}
+
+static int fsmEntryFor(int dataPage) {
+    return (dataPage - 1) % FSM_GROUP - 1;
+}
+
+// Data page that follows a page, skipping FSM pages
+static int nextDataPage(int page) {
+    page++;
+    if (isFsmPage(page)) page++;
+    return page;
+}
+
+static int previousDataPage(int page) {
+    page--;
+    if (isFsmPage(page)) page--;
+    return page;
+}
+
+// Checks whether a page number can hold records of the table
+static bool isDataPage(RecordManager *rm, int page) {
+    return page >= rm->start_page && page <= rm->last_page && !isFsmPage(page);
+}
+
+// Stores the number of used slots of a data page in the free-space map
+static RC fsmSetUsed(RecordManager *rm, int dataPage, int usedSlots) {
+    BM_PageHandle fsm;
 
-    RC status = pinPage(&record_mgr->poolconfig, &pH, record_mgr->last_page);
+    RC status = pinPage(&rm->poolconfig, &fsm, fsmPageFor(dataPage));
     if (status != RC_OK) return status;
 
-    int free_slot_in_page = findFreeSlot(pH.data, getRecordSize(rel->schema));
-    if (free_slot_in_page == -1) {
-        status = unpinPage(&record_mgr->poolconfig, &pH);
-        if (status != RC_OK) return status;
-        record_mgr->last_page += 1;
-        status = pinPage(&record_mgr->poolconfig, &pH, record_mgr->last_page);
+    ((unsigned short *)fsm.data)[fsmEntryFor(dataPage)] = (unsigned short)usedSlots;
+
+    status = markDirty(&rm->poolconfig, &fsm);
+    if (status != RC_OK) return status;
+    return unpinPage(&rm->poolconfig, &fsm);
+}
+
+// Finds the first data page from the hint up to limit with a free slot; a page past limit when all are full
+static RC fsmSearch(RecordManager *rm, int limit, int *pageNum) {
+    int page = rm->fsm_hint;
+
+    while (page <= limit) {
+        BM_PageHandle fsm;
+        int fsmPage = fsmPageFor(page);
+
+        RC status = pinPage(&rm->poolconfig, &fsm, fsmPage);
         if (status != RC_OK) return status;
-        free_slot_in_page = findFreeSlot(pH.data, getRecordSize(rel->schema));
-    }
 
-    int record_size = getRecordSize(rel->schema);
-    char *slot_pointer = pH.data + (free_slot_in_page * record_size);
-    memcpy(slot_pointer, record->data, record_size);
+        unsigned short *used = (unsigned short *)fsm.data;
+        while (page <= limit && fsmPageFor(page) == fsmPage && used[fsmEntryFor(page)] >= rm->max_slots)
+            page = nextDataPage(page);
+
+        status = unpinPage(&rm->poolconfig, &fsm);
+        if (status != RC_OK) return status;
 
-    record->id.page = record_mgr->last_page;
-    record->id.slot = free_slot_in_page;
+        if (page <= limit && fsmPageFor(page) == fsmPage) break;  // found a page with room
+    }
+    *pageNum = page;
+    return RC_OK;
+}
 
-    status = markDirty(&record_mgr->poolconfig, &pH);
-    if (status != RC_OK) return status;
+// Finds a data page with a free slot, starting at the hint and appending a page when all are full
+static RC fsmFindPage(RecordManager *rm, int *pageNum) {
+    int page;
 
-    status = unpinPage(&record_mgr->poolconfig, &pH);
+    RC status = fsmSearch(rm, rm->last_page, &page);
     if (status != RC_OK) return status;
 
-    record_mgr->num_tuples++;
+    // every page before this one is full
+    rm->fsm_hint = page;
+    if (page > rm->last_page) rm->last_page = page;
+    *pageNum = page;
     return RC_OK;
 }
 
-// Delete a record from the table
-extern RC deleteRecord(RM_TableData *rel, RID id) {
-    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
-    BM_PageHandle pH;
+// Formats a page that was never used as a data page; a slotted page starts with an empty directory
+static void initDataPage(RecordManager *rm, char *data) {
+    if (rm->layout == RM_LAYOUT_SLOTTED) {
+        if (SLOTTED_HEADER(data)->data_start != 0) return;
+        memset(data, 0, PAGE_SIZE);
+        SLOTTED_HEADER(data)->data_start = PAGE_SIZE;
+        return;
+    }
+    if (PAGE_HEADER(data)->num_slots != 0) return;
 
-    RC delete_page = pinPage(&record_mgr->poolconfig, &pH, id.page);
-    if (delete_page != RC_OK) return delete_page;
+    memset(data, 0, PAGE_SIZE);
+    PAGE_HEADER(data)->num_slots = rm->max_slots;
+    PAGE_HEADER(data)->free_slots = rm->max_slots;
+}
 
-    int record_size = getRecordSize(rel->schema);
-    char *slot_pointer = pH.data + (id.slot * record_size);
-    memset(slot_pointer, '\0', record_size);
+// Checks the occupancy bit of a slot, or on a slotted page whether its entry holds a tuple
+static bool isSlotUsed(RecordManager *rm, char *data, int slot) {
+    if (slot < 0 || slot >= PAGE_HEADER(data)->num_slots) return FALSE;
+    if (rm->layout == RM_LAYOUT_SLOTTED) return SLOT_DIRECTORY(data)[slot].length != 0;
+    return (PAGE_BITMAP(data)[slot / BITMAP_WORD_BITS] >> (slot % BITMAP_WORD_BITS)) & 1u;
+}
 
-    delete_page = markDirty(&record_mgr->poolconfig, &pH);
-    if (delete_page != RC_OK) return delete_page;
+// Sets or clears the occupancy bit of a slot and keeps the free count in sync. Slotted
+// pages mark a slot used when its tuple is written; clearing it frees the tuple.
+static void setSlotUsed(RecordManager *rm, char *data, int slot, bool used) {
+    if (rm->layout == RM_LAYOUT_SLOTTED) {
+        RM_SlottedHeader *header = SLOTTED_HEADER(data);
+        RM_SlotEntry *entry = &SLOT_DIRECTORY(data)[slot];
 
-    delete_page = unpinPage(&record_mgr->poolconfig, &pH);
-    return delete_page;
+        if (used || entry->length == 0) return;
+        header->hole_bytes += entry->length;
+        entry->length = 0;
+        header->slots.free_slots++;
+        if (header->slots.free_slots == header->slots.num_slots) {
+            header->data_start = PAGE_SIZE;  // nothing left to keep
+            header->hole_bytes = 0;
+        }
+        return;
+    }
+
+    unsigned int *word = &PAGE_BITMAP(data)[slot / BITMAP_WORD_BITS];
+    unsigned int bit = 1u << (slot % BITMAP_WORD_BITS);
+
+    if (used && !(*word & bit)) {
+        *word |= bit;
+        PAGE_HEADER(data)->free_slots--;
+    } else if (!used && (*word & bit)) {
+        *word &= ~bit;
+        PAGE_HEADER(data)->free_slots++;
+    }
 }
 
-// Update a record in the table
-extern RC updateRecord(RM_TableData *rel, Record *record) {
-    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
-    BM_PageHandle pH;
+// A free slot of a slotted page that takes any record while leaving room for growth, -1 if none
+static int findFreeTuple(RecordManager *rm, char *data) {
+    RM_SlottedHeader *header = SLOTTED_HEADER(data);
+    int needed = rm->max_tuple_size + rm->grow_reserve;
+    int slot = header->slots.num_slots;
 
-    RC update_page = pinPage(&record_mgr->poolconfig, &pH, record->id.page);
-    if (update_page != RC_OK) return update_page;
+    if (header->slots.free_slots > 0) {
+        for (slot = 0; SLOT_DIRECTORY(data)[slot].length != 0; slot++);
+    } else if (slot < rm->max_slots) {
+        needed += sizeof(RM_SlotEntry);
+    } else {
+        return -1;
+    }
+    return slottedFreeBytes(data) >= needed ? slot : -1;
+}
 
-    int record_size = getRecordSize(rel->schema);
-    char *slot_pointer = pH.data + (record->id.slot * record_size);
-    memcpy(slot_pointer, record->data, record_size);
+// Function to find free slot in a page, one find-first-zero per bitmap word
+int findFreeSlot(RecordManager *rm, char *data) {
+    RM_PageHeader *header = PAGE_HEADER(data);
+    unsigned int *bitmap = PAGE_BITMAP(data);
 
-    update_page = markDirty(&record_mgr->poolconfig, &pH);
-    if (update_page != RC_OK) return update_page;
+    if (rm->layout == RM_LAYOUT_SLOTTED) return findFreeTuple(rm, data);
+    if (header->free_slots <= 0) return -1;
 
-    return unpinPage(&record_mgr->poolconfig, &pH);
+    for (int word = 0; word < BITMAP_WORDS(header->num_slots); word++) {
+        if (bitmap[word] == ~0u) continue;
+
+        int slotindex = word * BITMAP_WORD_BITS + __builtin_ctz(~bitmap[word]);
+        if (slotindex < header->num_slots) return slotindex;
+    }
+    return -1;  // No free slots found
 }
 
-// Get a record by its ID
-extern RC getRecord(RM_TableData *rel, RID id, Record *record) {
-    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
-    BM_PageHandle pH;
+// Entry of a page in the free-space map: its used slots, or max_slots once it takes no more records
+static int pageFill(RecordManager *rm, char *data) {
+    if (rm->layout == RM_LAYOUT_SLOTTED && findFreeTuple(rm, data) == -1) return rm->max_slots;
+    return PAGE_HEADER(data)->num_slots - PAGE_HEADER(data)->free_slots;
+}
 
-    RC record_page = pinPage(&record_mgr->poolconfig, &pH, id.page);
-    if (record_page != RC_OK) return record_page;
+/******************************** Zone Map Functions **********************************/
 
-    int record_size = getRecordSize(rel->schema);
-    char *slot_pointer = pH.data + (id.slot * record_size);
-    memcpy(record->data, slot_pointer, record_size);
+static char *zoneFileName(char *tableName) {
+    char *file_name = (char *)malloc(strlen(tableName) + 4);
+    if (file_name != NULL) sprintf(file_name, "%s.zm", tableName);
+    return file_name;
+}
 
-    record_page = unpinPage(&record_mgr->poolconfig, &pH);
-    return record_page;
-}
\ No newline at end of file
+// Lay out the zone entries of the table, INT, FLOAT and STRING attributes are summarized
+static RC initZoneMaps(RecordManager *rm, Schema *schema) {
+    rm->zone_maps = NULL;
+    rm->zone_pages = 0;
+    rm->zone_offsets = (int *)malloc(sizeof(int) * schema->numAttr);
+    if (rm->zone_offsets == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    int offset = sizeof(int);
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (schema->dataTypes[i] == DT_BOOL) {
+            rm->zone_offsets[i] = -1;
+            continue;
+        }
+        rm->zone_offsets[i] = offset;
+        offset += 2 * rm->attr_sizes[i];
+    }
+    rm->zone_entry_size = (offset + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+    return RC_OK;
+}
+
+// Grow the zone maps so they cover page, new entries are empty
+static RC ensureZoneCapacity(RecordManager *rm, int page) {
+    if (page < rm->zone_pages) return RC_OK;
+
+    int pages = rm->zone_pages > 0 ? rm->zone_pages : 64;
+    while (pages <= page) pages *= 2;
+
+    char *zone_maps = (char *)realloc(rm->zone_maps, (size_t)pages * rm->zone_entry_size);
+    if (zone_maps == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    memset(zone_maps + (size_t)rm->zone_pages * rm->zone_entry_size, 0, (size_t)(pages - rm->zone_pages) * rm->zone_entry_size);
+    rm->zone_maps = zone_maps;
+    rm->zone_pages = pages;
+    return RC_OK;
+}
+
+#define ZONE_ENTRY(rm, page) ((rm)->zone_maps + (size_t)(page) * (rm)->zone_entry_size)
+
+// Compare two stored values of an attribute, same result as valueSmaller/valueEquals
+static int compareStored(DataType dt, char *left, char *right, int length) {
+    switch (dt) {
+        case DT_INT: {
+            int l, r;
+            memcpy(&l, left, sizeof(int));
+            memcpy(&r, right, sizeof(int));
+            return (l > r) - (l < r);
+        }
+        case DT_FLOAT: {
+            float l, r;
+            memcpy(&l, left, sizeof(float));
+            memcpy(&r, right, sizeof(float));
+            return (l > r) - (l < r);
+        }
+        case DT_STRING:
+            return strncmp(left, right, length);
+        default:
+            return 0;
+    }
+}
+
+// Compare a stored value with a constant of the same type
+static int compareStoredValue(DataType dt, char *stored, Value *value, int length) {
+    switch (dt) {
+        case DT_INT: {
+            int l;
+            memcpy(&l, stored, sizeof(int));
+            return (l > value->v.intV) - (l < value->v.intV);
+        }
+        case DT_FLOAT: {
+            float l;
+            memcpy(&l, stored, sizeof(float));
+            return (l > value->v.floatV) - (l < value->v.floatV);
+        }
+        case DT_STRING: {
+            int result = strncmp(stored, value->v.stringV, length);
+            // a stored string filling the whole attribute is a prefix of any longer constant
+            if (result == 0 && memchr(stored, '\0', length) == NULL && strlen(value->v.stringV) > (size_t)length) return -1;
+            return result;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Widen the zone entry of page so it covers the record in row
+static RC zoneWiden(RecordManager *rm, Schema *schema, int page, char *row) {
+    RC status = ensureZoneCapacity(rm, page);
+    if (status != RC_OK) return status;
+
+    char *entry = ZONE_ENTRY(rm, page);
+    bool first = (entry[0] == ZONE_EMPTY);
+
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (rm->zone_offsets[i] < 0) continue;
+
+        int size = rm->attr_sizes[i];
+        char *value = row + rm->attr_offsets[i];
+        char *min = entry + rm->zone_offsets[i];
+        char *max = min + size;
+
+        if (first || compareStored(schema->dataTypes[i], value, min, size) < 0) {
+            if (schema->dataTypes[i] == DT_STRING) strncpy(min, value, size);
+            else memcpy(min, value, size);
+        }
+        if (first || compareStored(schema->dataTypes[i], value, max, size) > 0) {
+            if (schema->dataTypes[i] == DT_STRING) strncpy(max, value, size);
+            else memcpy(max, value, size);
+        }
+    }
+    entry[0] = ZONE_VALID;
+    return RC_OK;
+}
+
+// Forget the bounds of a page that holds no records any more
+static void zoneReset(RecordManager *rm, int page) {
+    if (page < rm->zone_pages) ZONE_ENTRY(rm, page)[0] = ZONE_EMPTY;
+}
+
+// Whether a comparison between attrRef and constant can hold on a page with this entry;
+// attrFirst tells which side of the comparison the attribute is on
+static bool zoneMayCompare(RecordManager *rm, Schema *schema, char *entry, OpType op, int attr, Value *constant, bool attrFirst) {
+    if (attr < 0 || attr >= schema->numAttr || rm->zone_offsets[attr] < 0) return TRUE;
+    if (constant->dt != schema->dataTypes[attr]) return TRUE;     // evalExpr reports the error
+
+    int size = rm->attr_sizes[attr];
+    char *min = entry + rm->zone_offsets[attr];
+    char *max = min + size;
+    DataType dt = schema->dataTypes[attr];
+
+    if (op == OP_COMP_EQUAL)
+        return compareStoredValue(dt, min, constant, size) <= 0 && compareStoredValue(dt, max, constant, size) >= 0;
+    if (attrFirst)
+        return compareStoredValue(dt, min, constant, size) < 0;     // attr < constant
+    return compareStoredValue(dt, max, constant, size) > 0;         // constant < attr
+}
+
+// Whether any record of page may satisfy cond; FALSE only if the zone map rules it out
+static bool zoneMayMatch(RecordManager *rm, Schema *schema, int page, Expr *cond) {
+    if (page >= rm->zone_pages || ZONE_ENTRY(rm, page)[0] == ZONE_EMPTY) return FALSE;
+    if (cond == NULL || cond->type != EXPR_OP) return TRUE;
+
+    Operator *op = cond->expr.op;
+    switch (op->type) {
+        case OP_BOOL_AND:
+            return zoneMayMatch(rm, schema, page, op->args[0]) && zoneMayMatch(rm, schema, page, op->args[1]);
+        case OP_BOOL_OR:
+            return zoneMayMatch(rm, schema, page, op->args[0]) || zoneMayMatch(rm, schema, page, op->args[1]);
+        case OP_COMP_EQUAL:
+        case OP_COMP_SMALLER: {
+            Expr *left = op->args[0], *right = op->args[1];
+            char *entry = ZONE_ENTRY(rm, page);
+
+            if (left->type == EXPR_ATTRREF && right->type == EXPR_CONST)
+                return zoneMayCompare(rm, schema, entry, op->type, left->expr.attrRef, right->expr.cons, TRUE);
+            if (left->type == EXPR_CONST && right->type == EXPR_ATTRREF)
+                return zoneMayCompare(rm, schema, entry, op->type, right->expr.attrRef, left->expr.cons, FALSE);
+            return TRUE;
+        }
+        default:
+            return TRUE;
+    }
+}
+
+static RC saveZoneMaps(RecordManager *rm, char *tableName, bool clean) {
+    char *file_name = zoneFileName(tableName);
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    FILE *file = fopen(file_name, "wb");
+    free(file_name);
+    if (file == NULL) return RC_WRITE_FAILED;
+
+    RM_ZoneFileHeader header;
+    memcpy(header.magic, ZONE_MAGIC, sizeof(header.magic));
+    header.clean = clean;
+    header.entry_size = rm->zone_entry_size;
+    header.num_pages = rm->zone_pages;
+
+    RC status = RC_OK;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        (rm->zone_pages > 0 && fwrite(rm->zone_maps, rm->zone_entry_size, rm->zone_pages, file) != (size_t)rm->zone_pages))
+        status = RC_WRITE_FAILED;
+    if (fclose(file) != 0) status = RC_WRITE_FAILED;
+    return status;
+}
+
+// Recompute the zone maps from the data pages
+static RC rebuildZoneMaps(RecordManager *rm, Schema *schema) {
+    BM_PageHandle pH;
+    char *row = (char *)malloc(rm->record_size);
+    if (row == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    if (rm->zone_maps != NULL) memset(rm->zone_maps, 0, (size_t)rm->zone_pages * rm->zone_entry_size);
+
+    RC status = RC_OK;
+    for (int page = rm->start_page; page <= rm->last_page && status == RC_OK; page = nextDataPage(page)) {
+        status = pinPage(&rm->poolconfig, &pH, page);
+        if (status != RC_OK) break;
+
+        for (int slot = 0; slot < PAGE_HEADER(pH.data)->num_slots && status == RC_OK; slot++) {
+            if (!isSlotUsed(rm, pH.data, slot)) continue;
+            readSlot(rm, schema->numAttr, pH.data, slot, row);
+            status = zoneWiden(rm, schema, page, row);
+        }
+        RC unpin_status = unpinPage(&rm->poolconfig, &pH);
+        if (status == RC_OK) status = unpin_status;
+    }
+
+    free(row);
+    return status;
+}
+
+// Load the zone maps saved by the last close, rebuilding them if the file is missing
+// or was not closed cleanly, then mark the file as in use
+static RC loadZoneMaps(RecordManager *rm, Schema *schema, char *tableName) {
+    char *file_name = zoneFileName(tableName);
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    FILE *file = fopen(file_name, "rb");
+    free(file_name);
+
+    bool loaded = FALSE;
+    RM_ZoneFileHeader header;
+    if (file != NULL) {
+        if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, ZONE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.clean && header.entry_size == rm->zone_entry_size && header.num_pages >= 0) {
+            loaded = (header.num_pages == 0 || ensureZoneCapacity(rm, header.num_pages - 1) == RC_OK) &&
+                     fread(rm->zone_maps, rm->zone_entry_size, header.num_pages, file) == (size_t)header.num_pages;
+        }
+        fclose(file);
+    }
+
+    RC status = loaded ? RC_OK : rebuildZoneMaps(rm, schema);
+    if (status != RC_OK) return status;
+    return saveZoneMaps(rm, tableName, FALSE);
+}
+
+/******************************** Dictionary Functions ********************************/
+
+static char *dictFileName(char *tableName) {
+    char *file_name = (char *)malloc(strlen(tableName) + 6);
+    if (file_name != NULL) sprintf(file_name, "%s.dict", tableName);
+    return file_name;
+}
+
+static void removeDictionaryFile(char *tableName) {
+    char *file_name = dictFileName(tableName);
+    if (file_name != NULL) remove(file_name);
+    free(file_name);
+}
+
+// Create the dictionary file of a table, without entries yet
+static RC createDictionaryFile(char *tableName, int numAttrs, bool *encoded) {
+    RM_DictFileHeader header;
+    SM_FileHandle fh;
+    char *file_name = dictFileName(tableName);
+    char *page = (char *)calloc(PAGE_SIZE, 1);
+    RC status = (file_name == NULL || page == NULL) ? RC_MEMORY_ALLOCATION_FAILED : RC_OK;
+
+    if (status == RC_OK && sizeof(header) + numAttrs * sizeof(int) > PAGE_SIZE) status = RC_WRITE_FAILED;
+    if (status == RC_OK) {
+        memcpy(header.magic, DICT_MAGIC, sizeof(header.magic));
+        header.num_attrs = numAttrs;
+        memcpy(page, &header, sizeof(header));
+        for (int i = 0; i < numAttrs; i++) ((int *)(page + sizeof(header)))[i] = encoded[i];
+        status = createPageFile(file_name);
+    }
+    if (status == RC_OK) status = openPageFile(file_name, &fh);
+    if (status == RC_OK) {
+        status = writeBlock(0, &fh, page);
+        RC close_status = closePageFile(&fh);
+        if (status == RC_OK) status = close_status;
+    }
+    free(page);
+    free(file_name);
+    return status;
+}
+
+static void freeDictionary(RM_Dictionary *dict) {
+    if (dict == NULL) return;
+    for (int i = 0; dict->columns != NULL && i < dict->num_attrs; i++) {
+        free(dict->columns[i].strings);
+        free(dict->columns[i].buckets);
+    }
+    free(dict->columns);
+    free(dict->encoded);
+    free(dict->file_name);
+    free(dict->page);
+    free(dict);
+}
+
+// Read every entry of a page of the dictionary file into memory, *used is set to the bytes they take
+static RC readDictionaryPage(RM_Dictionary *dict, char *page, int *used) {
+    RC status = RC_OK;
+
+    *used = 0;
+    while (status == RC_OK && *used + DICT_ENTRY_HEADER <= PAGE_SIZE) {
+        unsigned short entry[2];  // attribute, length + 1
+        memcpy(entry, page + *used, DICT_ENTRY_HEADER);
+        if (entry[1] == 0) break;
+
+        int attr = entry[0], length = entry[1] - 1;
+        if (attr >= dict->num_attrs || !dict->encoded[attr] || length > dict->columns[attr].width ||
+            *used + DICT_ENTRY_HEADER + length > PAGE_SIZE)
+            return RC_ERROR;
+        status = dictionaryRemember(&dict->columns[attr], page + *used + DICT_ENTRY_HEADER, length);
+        *used += DICT_ENTRY_HEADER + length;
+    }
+    return status;
+}
+
+// Load the dictionary of a table; rm->dictionary stays NULL when the table has none
+static RC openDictionary(RecordManager *rm, Schema *schema, char *tableName) {
+    SM_FileHandle fh;
+    RM_DictFileHeader header;
+
+    rm->dictionary = NULL;
+    char *file_name = dictFileName(tableName);
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    if (openPageFile(file_name, &fh) != RC_OK) {
+        free(file_name);
+        return RC_OK;  // no attribute is encoded
+    }
+
+    RM_Dictionary *dict = (RM_Dictionary *)calloc(1, sizeof(RM_Dictionary));
+    char *page = (char *)malloc(PAGE_SIZE);
+    RC status = RC_MEMORY_ALLOCATION_FAILED;
+    if (dict != NULL && page != NULL) {
+        dict->file_name = file_name;
+        dict->page = page;
+        dict->num_attrs = schema->numAttr;
+        dict->encoded = (bool *)calloc(schema->numAttr, sizeof(bool));
+        dict->columns = (RM_DictColumn *)calloc(schema->numAttr, sizeof(RM_DictColumn));
+        if (dict->encoded != NULL && dict->columns != NULL) status = readBlock(0, &fh, page);
+    } else {
+        free(file_name);
+        free(page);
+    }
+
+    if (status == RC_OK) {
+        memcpy(&header, page, sizeof(header));
+        if (memcmp(header.magic, DICT_MAGIC, sizeof(header.magic)) != 0 || header.num_attrs != schema->numAttr) status = RC_ERROR;
+    }
+    for (int i = 0; status == RC_OK && i < schema->numAttr; i++) {
+        dict->encoded[i] = ((int *)(page + sizeof(header)))[i] != 0;
+        dict->columns[i].width = schema->typeLength[i];
+        if (dict->encoded[i] && schema->dataTypes[i] != DT_STRING) status = RC_ERROR;
+    }
+
+    // new entries go to the last page after the ones it has
+    for (int p = 1; status == RC_OK && p < fh.totalNumPages; p++) {
+        status = readBlock(p, &fh, page);
+        if (status == RC_OK) status = readDictionaryPage(dict, page, &dict->page_used);
+        dict->page_num = p;
+    }
+    closePageFile(&fh);
+
+    if (status != RC_OK) {
+        freeDictionary(dict);
+        return status;
+    }
+    rm->dictionary = dict;
+    return RC_OK;
+}
+
+// Append a string of an encoded attribute to the dictionary file, then give it the next code
+static RC dictionaryAdd(RM_Dictionary *dict, int attr, char *value) {
+    RM_DictColumn *column = &dict->columns[attr];
+    int length = strnlen(value, column->width);
+    int needed = DICT_ENTRY_HEADER + length;
+    unsigned short entry[2] = {(unsigned short)attr, (unsigned short)(length + 1)};
+    SM_FileHandle fh;
+
+    if (dict->page_num == 0 || dict->page_used + needed > PAGE_SIZE) {
+        dict->page_num++;
+        dict->page_used = 0;
+        memset(dict->page, 0, PAGE_SIZE);
+    }
+    char *dest = dict->page + dict->page_used;
+    memcpy(dest, entry, DICT_ENTRY_HEADER);
+    memcpy(dest + DICT_ENTRY_HEADER, value, length);
+
+    // the entry is on disk before any record holding its code
+    RC status = openPageFile(dict->file_name, &fh);
+    if (status == RC_OK) {
+        status = ensureCapacity(dict->page_num + 1, &fh);
+        if (status == RC_OK) status = writeBlock(dict->page_num, &fh, dict->page);
+        RC close_status = closePageFile(&fh);
+        if (status == RC_OK) status = close_status;
+    }
+    if (status != RC_OK) {
+        memset(dest, 0, needed);
+        return status;
+    }
+    dict->page_used += needed;
+    return dictionaryRemember(column, value, length);
+}
+
+// Give every string of an encoded attribute in row a code, adding the ones the dictionary lacks
+static RC dictionaryAddRow(RecordManager *rm, char *row) {
+    RM_Dictionary *dict = rm->dictionary;
+
+    for (int i = 0; dict != NULL && i < dict->num_attrs; i++) {
+        if (!dict->encoded[i]) continue;
+
+        char *value = row + rm->attr_offsets[i];
+        if (dictionaryCode(&dict->columns[i], value) != -1) continue;
+
+        RC status = dictionaryAdd(dict, i, value);
+        if (status != RC_OK) return status;
+    }
+    return RC_OK;
+}
+
+// Copy of cond that can be evaluated on stored records: an encoded attribute compared for
+// equality with a string constant is compared with the constant's code instead, -1 when no
+// record holds it. NULL when cond reads an encoded attribute any other way, or on no memory.
+static Expr *codedCondition(RecordManager *rm, Expr *cond) {
+    RM_Dictionary *dict = rm->dictionary;
+    Expr *bound = NULL;
+
+    switch (cond->type) {
+        case EXPR_CONST: {
+            Value *value = (Value *)malloc(sizeof(Value));
+            if (value == NULL) return NULL;
+            CPVAL(value, cond->expr.cons);
+            MAKE_CONS(bound, value);
+            return bound;
+        }
+        case EXPR_ATTRREF: {
+            int attr = cond->expr.attrRef;
+            if (attr >= 0 && attr < dict->num_attrs && dict->encoded[attr]) return NULL;
+            MAKE_ATTRREF(bound, attr);
+            return bound;
+        }
+        case EXPR_OP:
+            break;
+    }
+
+    Operator *op = cond->expr.op;
+    if (op->type == OP_COMP_EQUAL) {
+        for (int side = 0; side < 2; side++) {
+            Expr *attr = op->args[side], *constant = op->args[1 - side];
+            if (attr->type != EXPR_ATTRREF || constant->type != EXPR_CONST || constant->expr.cons->dt != DT_STRING) continue;
+            if (attr->expr.attrRef < 0 || attr->expr.attrRef >= dict->num_attrs || !dict->encoded[attr->expr.attrRef]) continue;
+
+            // a constant longer than the attribute equals none of its strings
+            RM_DictColumn *column = &dict->columns[attr->expr.attrRef];
+            char *string = constant->expr.cons->v.stringV;
+            int code = (int)strlen(string) > column->width ? -1 : dictionaryCode(column, string);
+
+            Expr *left, *right;
+            Value *value;
+            MAKE_VALUE(value, DT_INT, code);
+            MAKE_ATTRREF(left, attr->expr.attrRef);
+            MAKE_CONS(right, value);
+            MAKE_BINOP_EXPR(bound, left, right, OP_COMP_EQUAL);
+            return bound;
+        }
+    }
+
+    Expr *left = codedCondition(rm, op->args[0]);
+    Expr *right = (left != NULL && op->type != OP_BOOL_NOT) ? codedCondition(rm, op->args[1]) : NULL;
+    if (left == NULL || (op->type != OP_BOOL_NOT && right == NULL)) {
+        if (left != NULL) freeExpr(left);
+        return NULL;
+    }
+    if (op->type == OP_BOOL_NOT) MAKE_UNOP_EXPR(bound, left, op->type);
+    else MAKE_BINOP_EXPR(bound, left, right, op->type);
+    return bound;
+}
+
+/******************************** Index Maintenance Functions *************************/
+
+// File of an index, <table>.<suffix>
+static char *indexFileName(char *tableName, char *suffix) {
+    char *file_name = (char *)malloc(strlen(tableName) + strlen(suffix) + 2);
+    if (file_name != NULL) sprintf(file_name, "%s.%s", tableName, suffix);
+    return file_name;
+}
+
+// File of a secondary index, <table>.ix.<index>
+static char *secondaryIndexFileName(char *tableName, char *indexName) {
+    char *file_name = (char *)malloc(strlen(tableName) + strlen(indexName) + 5);
+    if (file_name != NULL) sprintf(file_name, "%s.ix.%s", tableName, indexName);
+    return file_name;
+}
+
+// Pack the key and included attributes of a row the way the index stores them
+static void packRowKey(RecordManager *rm, Schema *schema, RM_Index *index, char *row, char *key) {
+    for (int i = 0; i < index->num_key_attrs + index->num_included_attrs; i++) {
+        int attr = index->key_attrs[i];
+        char *value = row + rm->attr_offsets[attr];
+
+        // strings are padded with '\0' so equal keys are equal bytes
+        if (schema->dataTypes[attr] == DT_STRING) strncpy(key, value, rm->attr_sizes[attr]);
+        else memcpy(key, value, rm->attr_sizes[attr]);
+        key += rm->attr_sizes[attr];
+    }
+}
+
+static RC indexInsertKey(RM_Index *index, char *key, RID rid) {
+    if (index->type == RM_INDEX_HASH) return insertHashKey(index->hash, key, rid);
+    return insertKey(index->tree, key, rid);
+}
+
+static RC indexDeleteKey(RM_Index *index, char *key, RID rid) {
+    if (index->type == RM_INDEX_HASH) return deleteHashKey(index->hash, key, rid);
+    return deleteKey(index->tree, key, rid);
+}
+
+// keyAttrs lists the key attributes followed by the included ones
+static RC createIndexFile(char *fileName, Schema *schema, int numKeyAttrs, int numIncludedAttrs, int *keyAttrs,
+                          RM_IndexType type, bool unique) {
+    int total = numKeyAttrs + numIncludedAttrs;
+    DataType *types = (DataType *)malloc(sizeof(DataType) * total);
+    int *lengths = (int *)malloc(sizeof(int) * total);
+    if (types == NULL || lengths == NULL) {
+        free(types);
+        free(lengths);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    for (int i = 0; i < total; i++) {
+        types[i] = schema->dataTypes[keyAttrs[i]];
+        lengths[i] = schema->typeLength[keyAttrs[i]];
+    }
+    RC status = (type == RM_INDEX_HASH) ? createHashIndex(fileName, numKeyAttrs, numIncludedAttrs, types, lengths, unique)
+                                        : createBtree(fileName, numKeyAttrs, numIncludedAttrs, types, lengths, unique, 0);
+
+    free(types);
+    free(lengths);
+    return status;
+}
+
+static RC deleteIndexFile(char *fileName, RM_IndexType type) {
+    return (type == RM_INDEX_HASH) ? deleteHashIndex(fileName) : deleteBtree(fileName);
+}
+
+// Open the file of an index into index->tree or index->hash
+static RC openIndexFile(char *fileName, RM_Index *index) {
+    if (index->type == RM_INDEX_HASH) {
+        RC status = openHashIndex(&index->hash, fileName);
+        if (status == RC_OK) index->key_size = index->hash->keySize;
+        return status;
+    }
+    RC status = openBtree(&index->tree, fileName);
+    if (status == RC_OK) index->key_size = index->tree->keySize;
+    return status;
+}
+
+static RC closeIndexFile(RM_Index *index) {
+    return (index->type == RM_INDEX_HASH) ? closeHashIndex(index->hash) : closeBtree(index->tree);
+}
+
+// Register an opened index with the table, taking over its scratch buffers
+static RC addIndex(RecordManager *rm, RM_Index *opened, int *keyAttrs) {
+    RM_Index *indexes = (RM_Index *)realloc(rm->indexes, sizeof(RM_Index) * (rm->num_indexes + 1));
+    if (indexes == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    rm->indexes = indexes;
+
+    RM_Index *index = &indexes[rm->num_indexes];
+    int total = opened->num_key_attrs + opened->num_included_attrs;
+    *index = *opened;
+    index->key_attrs = (int *)malloc(sizeof(int) * total);
+    index->key = (char *)malloc(index->key_size);
+    index->old_key = (char *)malloc(index->key_size);
+    if (index->key_attrs == NULL || index->key == NULL || index->old_key == NULL) {
+        free(index->key_attrs);
+        free(index->key);
+        free(index->old_key);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    memcpy(index->key_attrs, keyAttrs, sizeof(int) * total);
+    index->key_part_size = 0;
+    for (int i = 0; i < index->num_key_attrs; i++) index->key_part_size += rm->attr_sizes[keyAttrs[i]];
+    rm->num_indexes++;
+    return RC_OK;
+}
+
+// Close an index and take it out of the table's list
+static RC removeIndex(RecordManager *rm, int position) {
+    RM_Index *index = &rm->indexes[position];
+
+    RC status = closeIndexFile(index);
+    free(index->key_attrs);
+    free(index->key);
+    free(index->old_key);
+
+    memmove(index, index + 1, sizeof(RM_Index) * (rm->num_indexes - position - 1));
+    rm->num_indexes--;
+    return status;
+}
+
+// Fill an empty index with the records already in the table
+static RC buildIndexFromTable(RecordManager *rm, Schema *schema, RM_Index *index) {
+    BM_PageHandle pH;
+    int capacity = rm->num_tuples > 0 ? rm->num_tuples : 1024, count = 0;
+    char *keys = (char *)malloc((size_t)capacity * index->key_size);
+    RID *rids = (RID *)malloc(sizeof(RID) * capacity);
+    RC status = (keys == NULL || rids == NULL) ? RC_MEMORY_ALLOCATION_FAILED : RC_OK;
+
+    for (int page = rm->start_page; page <= rm->last_page && status == RC_OK; page = nextDataPage(page)) {
+        status = pinPage(&rm->poolconfig, &pH, page);
+        if (status != RC_OK) break;
+
+        for (int slot = 0; slot < PAGE_HEADER(pH.data)->num_slots && status == RC_OK; slot++) {
+            if (!isSlotUsed(rm, pH.data, slot)) continue;
+
+            if (count == capacity) {
+                char *more_keys = (char *)realloc(keys, (size_t)capacity * 2 * index->key_size);
+                RID *more_rids = (RID *)realloc(rids, sizeof(RID) * capacity * 2);
+                if (more_keys != NULL) keys = more_keys;
+                if (more_rids != NULL) rids = more_rids;
+                if (more_keys == NULL || more_rids == NULL) {
+                    status = RC_MEMORY_ALLOCATION_FAILED;
+                    break;
+                }
+                capacity *= 2;
+            }
+            readSlot(rm, schema->numAttr, pH.data, slot, rm->row_buffer);
+            packRowKey(rm, schema, index, rm->row_buffer, keys + (size_t)count * index->key_size);
+            rids[count].page = page;
+            rids[count].slot = slot;
+            count++;
+        }
+        RC unpin_status = unpinPage(&rm->poolconfig, &pH);
+        if (status == RC_OK) status = unpin_status;
+    }
+
+    // a tree is built bottom-up from the sorted keys, a hash index takes them one by one
+    if (status == RC_OK && index->type == RM_INDEX_BTREE) status = bulkBuildBtree(index->tree, keys, rids, count);
+    for (int i = 0; i < count && status == RC_OK && index->type == RM_INDEX_HASH; i++)
+        status = insertHashKey(index->hash, keys + (size_t)i * index->key_size, rids[i]);
+
+    free(keys);
+    free(rids);
+    return status;
+}
+
+// Open an index file, creating and building it from the table when it is missing
+static RC attachIndex(RecordManager *rm, Schema *schema, char *fileName, RM_Index *index, int *keyAttrs) {
+    bool build = FALSE;
+
+    RC status = openIndexFile(fileName, index);
+    if (status == RC_FILE_NOT_FOUND) {
+        status = createIndexFile(fileName, schema, index->num_key_attrs, index->num_included_attrs, keyAttrs,
+                                 index->type, index->unique);
+        if (status == RC_OK) status = openIndexFile(fileName, index);
+        build = TRUE;
+    }
+    if (status != RC_OK) return status;
+
+    status = addIndex(rm, index, keyAttrs);
+    if (status != RC_OK) {
+        closeIndexFile(index);
+        return status;
+    }
+    if (build) status = buildIndexFromTable(rm, schema, &rm->indexes[rm->num_indexes - 1]);
+    return status;
+}
+
+// Secondary indexes of a table, listed in <table>.ix
+#define INDEX_CATALOG_MAGIC "IDX2"
+
+typedef struct RM_IndexCatalogEntry {
+    char name[RM_MAX_INDEX_NAME];
+    int type;
+    int unique;
+    int num_key_attrs;
+    int num_included_attrs;
+    int key_attrs[RM_MAX_INDEX_ATTRS];   // Key attributes, then the included ones
+} RM_IndexCatalogEntry;
+
+// Read the catalog of a table, a missing catalog lists no indexes
+static RC loadIndexCatalog(char *tableName, RM_IndexCatalogEntry **entries, int *count) {
+    char magic[4];
+
+    *entries = NULL;
+    *count = 0;
+    char *file_name = indexFileName(tableName, "ix");
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    FILE *file = fopen(file_name, "rb");
+    free(file_name);
+    if (file == NULL) return RC_OK;
+
+    RC status = RC_OK;
+    if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, INDEX_CATALOG_MAGIC, sizeof(magic)) != 0 ||
+        fread(count, sizeof(int), 1, file) != 1 || *count < 0) {
+        status = RC_ERROR;
+    } else if (*count > 0) {
+        *entries = (RM_IndexCatalogEntry *)malloc(sizeof(RM_IndexCatalogEntry) * *count);
+        if (*entries == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+        else if (fread(*entries, sizeof(RM_IndexCatalogEntry), *count, file) != (size_t)*count) status = RC_ERROR;
+    }
+    fclose(file);
+
+    if (status != RC_OK) {
+        free(*entries);
+        *entries = NULL;
+        *count = 0;
+    }
+    return status;
+}
+
+static RC saveIndexCatalog(RecordManager *rm, char *tableName) {
+    RM_IndexCatalogEntry entry;
+    int count = 0;
+
+    for (int i = 0; i < rm->num_indexes; i++)
+        if (!rm->indexes[i].primary) count++;
+
+    char *file_name = indexFileName(tableName, "ix");
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    FILE *file = fopen(file_name, "wb");
+    free(file_name);
+    if (file == NULL) return RC_WRITE_FAILED;
+
+    bool ok = fwrite(INDEX_CATALOG_MAGIC, 4, 1, file) == 1 && fwrite(&count, sizeof(int), 1, file) == 1;
+    for (int i = 0; i < rm->num_indexes && ok; i++) {
+        RM_Index *index = &rm->indexes[i];
+        if (index->primary) continue;
+
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.name, index->name);
+        entry.type = index->type;
+        entry.unique = index->unique;
+        entry.num_key_attrs = index->num_key_attrs;
+        entry.num_included_attrs = index->num_included_attrs;
+        memcpy(entry.key_attrs, index->key_attrs, sizeof(int) * (index->num_key_attrs + index->num_included_attrs));
+        ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+    }
+    if (fclose(file) != 0) ok = FALSE;
+    return ok ? RC_OK : RC_WRITE_FAILED;
+}
+
+// Delete every index file of a table and its catalog
+static void removeIndexFiles(char *tableName) {
+    RM_IndexCatalogEntry *entries;
+    int count;
+
+    char *file_name = indexFileName(tableName, "pk");
+    if (file_name != NULL) deleteBtree(file_name);
+    free(file_name);
+
+    if (loadIndexCatalog(tableName, &entries, &count) == RC_OK) {
+        for (int i = 0; i < count; i++) {
+            entries[i].name[RM_MAX_INDEX_NAME - 1] = '\0';
+            file_name = secondaryIndexFileName(tableName, entries[i].name);
+            if (file_name != NULL) deleteIndexFile(file_name, (RM_IndexType)entries[i].type);
+            free(file_name);
+        }
+        free(entries);
+    }
+
+    file_name = indexFileName(tableName, "ix");
+    if (file_name != NULL) remove(file_name);
+    free(file_name);
+}
+
+// Open the indexes of a table: the primary key index and the ones in the catalog.
+// Missing index files are created and built from the table.
+static RC openIndexes(RecordManager *rm, RM_TableData *rel) {
+    Schema *schema = rel->schema;
+    RM_IndexCatalogEntry *entries;
+    RM_Index index;
+    int count;
+    RC status = RC_OK;
+
+    if (schema->keySize > 0) {
+        char *file_name = indexFileName(rel->name, "pk");
+        if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+        memset(&index, 0, sizeof(index));
+        index.type = RM_INDEX_BTREE;
+        index.primary = TRUE;
+        index.unique = TRUE;
+        index.num_key_attrs = schema->keySize;
+        status = attachIndex(rm, schema, file_name, &index, schema->keyAttrs);
+        free(file_name);
+        if (status != RC_OK) return status;
+    }
+
+    status = loadIndexCatalog(rel->name, &entries, &count);
+    for (int i = 0; i < count && status == RC_OK; i++) {
+        memset(&index, 0, sizeof(index));
+        memcpy(index.name, entries[i].name, RM_MAX_INDEX_NAME);
+        index.name[RM_MAX_INDEX_NAME - 1] = '\0';
+        index.type = (RM_IndexType)entries[i].type;
+        index.unique = entries[i].unique;
+        index.num_key_attrs = entries[i].num_key_attrs;
+        index.num_included_attrs = entries[i].num_included_attrs;
+        if (index.num_key_attrs <= 0 || index.num_included_attrs < 0 ||
+            index.num_key_attrs + index.num_included_attrs > RM_MAX_INDEX_ATTRS) {
+            status = RC_ERROR;
+            break;
+        }
+
+        char *file_name = secondaryIndexFileName(rel->name, index.name);
+        if (file_name == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+        else status = attachIndex(rm, schema, file_name, &index, entries[i].key_attrs);
+        free(file_name);
+    }
+    free(entries);
+    return status;
+}
+
+static RC closeIndexes(RecordManager *rm) {
+    RC status = RC_OK;
+
+    while (rm->num_indexes > 0) {
+        RC close_status = removeIndex(rm, rm->num_indexes - 1);
+        if (status == RC_OK) status = close_status;
+    }
+    free(rm->indexes);
+    rm->indexes = NULL;
+    return status;
+}
+
+// Add a row to every index; on a duplicate key the indexes already changed are rolled back
+static RC indexInsertRow(RecordManager *rm, Schema *schema, char *row, RID rid) {
+    for (int i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        packRowKey(rm, schema, index, row, index->key);
+
+        RC status = indexInsertKey(index, index->key, rid);
+        if (status != RC_OK) {
+            while (--i >= 0) indexDeleteKey(&rm->indexes[i], rm->indexes[i].key, rid);
+            return status;
+        }
+    }
+    return RC_OK;
+}
+
+static RC indexDeleteRow(RecordManager *rm, Schema *schema, char *row, RID rid) {
+    for (int i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        packRowKey(rm, schema, index, row, index->key);
+
+        RC status = indexDeleteKey(index, index->key, rid);
+        if (status != RC_OK) return status;
+    }
+    return RC_OK;
+}
+
+static bool keyPartChanged(RM_Index *index) {
+    return memcmp(index->old_key, index->key, index->key_part_size) != 0;
+}
+
+// Move a row to its new entries in the indexes where its key or included values changed.
+// New keys are added first so a duplicate leaves every index as it was; an entry whose
+// key stays the same is replaced afterwards.
+static RC indexUpdateRow(RecordManager *rm, Schema *schema, char *oldRow, char *newRow, RID rid) {
+    int i;
+    RC status = RC_OK;
+
+    for (i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        packRowKey(rm, schema, index, oldRow, index->old_key);
+        packRowKey(rm, schema, index, newRow, index->key);
+        if (!keyPartChanged(index)) continue;
+
+        status = indexInsertKey(index, index->key, rid);
+        if (status != RC_OK) break;
+    }
+
+    if (status != RC_OK) {
+        while (--i >= 0)
+            if (keyPartChanged(&rm->indexes[i])) indexDeleteKey(&rm->indexes[i], rm->indexes[i].key, rid);
+        return status;
+    }
+
+    for (i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        if (memcmp(index->old_key, index->key, index->key_size) == 0) continue;
+
+        status = indexDeleteKey(index, index->old_key, rid);
+        if (status == RC_OK && !keyPartChanged(index)) status = indexInsertKey(index, index->key, rid);
+        if (status != RC_OK) return status;
+    }
+    return RC_OK;
+}
+
+/******************************** Statistics Helpers **********************************/
+
+static void freeTableStats(RM_TableStats *stats) {
+    if (stats == NULL) return;
+    free(stats->attrs);
+    free(stats->bounds);
+    free(stats);
+}
+
+static RM_TableStats *allocTableStats(int numAttrs, int numBuckets) {
+    RM_TableStats *stats = (RM_TableStats *)calloc(1, sizeof(RM_TableStats));
+    if (stats == NULL) return NULL;
+
+    stats->attrs = (RM_AttrStats *)calloc(numAttrs, sizeof(RM_AttrStats));
+    stats->bounds = (double *)calloc((size_t)numAttrs * (numBuckets + 1), sizeof(double));
+    if (stats->attrs == NULL || stats->bounds == NULL) {
+        freeTableStats(stats);
+        return NULL;
+    }
+    memcpy(stats->header.magic, STATS_MAGIC, sizeof(stats->header.magic));
+    stats->header.num_attrs = numAttrs;
+    stats->header.num_buckets = numBuckets;
+    return stats;
+}
+
+static int statsSize(int numAttrs, int numBuckets) {
+    return sizeof(RM_StatsHeader) + numAttrs * (sizeof(RM_AttrStats) + (numBuckets + 1) * sizeof(double));
+}
+
+// Where the statistics start on page 0: after the table header and the schema text
+static int statsOffset(char *headerPage) {
+    char *schema_text = headerPage + sizeof(RM_TableHeader);
+    return sizeof(RM_TableHeader) + strnlen(schema_text, PAGE_SIZE - sizeof(RM_TableHeader)) + 1;
+}
+
+// Read the statistics stored on page 0, NULL when the table was never analyzed
+static RM_TableStats *readTableStats(char *headerPage, Schema *schema) {
+    RM_StatsHeader header;
+    int offset = statsOffset(headerPage);
+
+    if (offset + (int)sizeof(header) > PAGE_SIZE) return NULL;
+    memcpy(&header, headerPage + offset, sizeof(header));
+    if (memcmp(header.magic, STATS_MAGIC, sizeof(header.magic)) != 0 || header.num_attrs != schema->numAttr ||
+        header.num_buckets < 1 || offset + statsSize(header.num_attrs, header.num_buckets) > PAGE_SIZE)
+        return NULL;
+
+    RM_TableStats *stats = allocTableStats(header.num_attrs, header.num_buckets);
+    if (stats == NULL) return NULL;
+    stats->header = header;
+
+    char *data = headerPage + offset + sizeof(header);
+    for (int a = 0; a < header.num_attrs; a++) {
+        memcpy(&stats->attrs[a], data, sizeof(RM_AttrStats));
+        data += sizeof(RM_AttrStats);
+        memcpy(stats->bounds + a * (header.num_buckets + 1), data, (header.num_buckets + 1) * sizeof(double));
+        data += (header.num_buckets + 1) * sizeof(double);
+    }
+    return stats;
+}
+
+static void writeTableStats(char *headerPage, RM_TableStats *stats) {
+    int buckets = stats->header.num_buckets;
+    char *data = headerPage + statsOffset(headerPage);
+
+    memcpy(data, &stats->header, sizeof(RM_StatsHeader));
+    data += sizeof(RM_StatsHeader);
+    for (int a = 0; a < stats->header.num_attrs; a++) {
+        memcpy(data, &stats->attrs[a], sizeof(RM_AttrStats));
+        data += sizeof(RM_AttrStats);
+        memcpy(data, stats->bounds + a * (buckets + 1), (buckets + 1) * sizeof(double));
+        data += (buckets + 1) * sizeof(double);
+    }
+}
+
+// An attribute value as the statistics keep it
+static double statsValue(DataType type, char *value, int size) {
+    int int_value;
+    float float_value;
+    bool bool_value;
+    double key = 0;
+
+    switch (type) {
+        case DT_INT:
+            memcpy(&int_value, value, sizeof(int));
+            return int_value;
+        case DT_FLOAT:
+            memcpy(&float_value, value, sizeof(float));
+            return float_value;
+        case DT_BOOL:
+            memcpy(&bool_value, value, sizeof(bool));
+            return bool_value ? 1 : 0;
+        case DT_STRING: {
+            bool ended = FALSE;
+            for (int i = 0; i < STATS_STRING_PREFIX; i++) {
+                if (i >= size || value[i] == '\0') ended = TRUE;
+                key = key * 256 + (ended ? 0 : (unsigned char)value[i]);
+            }
+            return key;
+        }
+    }
+    return 0;
+}
+
+static double statsConstant(Value *value) {
+    switch (value->dt) {
+        case DT_INT:    return value->v.intV;
+        case DT_FLOAT:  return value->v.floatV;
+        case DT_BOOL:   return value->v.boolV ? 1 : 0;
+        case DT_STRING: return statsValue(DT_STRING, value->v.stringV, strlen(value->v.stringV));
+    }
+    return 0;
+}
+
+// 64-bit hash of the bytes of an attribute value, strings up to their end
+static unsigned long long statsHash(DataType type, char *value, int size) {
+    unsigned long long hash = 1469598103934665603ULL;
+
+    for (int i = 0; i < size && !(type == DT_STRING && value[i] == '\0'); i++) {
+        hash ^= (unsigned char)value[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// HyperLogLog: the low HLL_BITS bits pick a register, which keeps the longest run of
+// leading zeros seen in the remaining bits
+static void hllAdd(unsigned char *registers, unsigned long long hash) {
+    int reg = hash & ((1 << HLL_BITS) - 1);
+    unsigned char rank = 1;
+
+    for (hash >>= HLL_BITS; rank <= 64 - HLL_BITS && !(hash & (1ULL << (63 - HLL_BITS))); hash <<= 1) rank++;
+    if (rank > registers[reg]) registers[reg] = rank;
+}
+
+static double hllEstimate(unsigned char *registers) {
+    int m = 1 << HLL_BITS, zeros = 0;
+    double sum = 0;
+
+    for (int i = 0; i < m; i++) {
+        sum += 1.0 / (double)(1ULL << registers[i]);
+        if (registers[i] == 0) zeros++;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+    // few values leave registers empty, linear counting is closer then
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * log((double)m / zeros);
+    return estimate;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double left = *(const double *)a, right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+/*************************** Record Manager *******************************************/
+// Initialize record manager
+extern RC initRecordManager(void *mgmtData) {
+    initStorageManager();
+    return RC_OK;
+}
+
+// Shut down record manager
+extern RC shutdownRecordManager() {
+    if (record_mgr != NULL) {
+        free(record_mgr);
+        record_mgr = NULL;
+    }
+    return RC_OK;
+}
+
+/***************************** Table Functions *****************************************/
+// Create table with row-wise data pages
+extern RC createTable(char *name, Schema *schema) {
+    return createTableWithLayout(name, schema, RM_LAYOUT_ROW);
+}
+
+// Create table whose data pages use the given layout
+extern RC createTableWithLayout(char *name, Schema *schema, RM_Layout layout) {
+    return createTableWithDictionary(name, schema, layout, 0, NULL);
+}
+
+// Create table whose data pages use the given layout and hold the listed string attributes as
+// codes into a dictionary of their distinct strings
+extern RC createTableWithDictionary(char *name, Schema *schema, RM_Layout layout, int numEncoded, int *encodedAttrs) {
+    if (name == NULL || schema == NULL) return RC_FILE_NOT_FOUND;
+    if (layout != RM_LAYOUT_ROW && layout != RM_LAYOUT_PAX && layout != RM_LAYOUT_SLOTTED) return RC_ERROR;
+
+    for (int i = 0; i < schema->numAttr; i++) {
+        switch (schema->dataTypes[i]) {
+            case DT_INT:
+            case DT_FLOAT:
+            case DT_STRING:
+            case DT_BOOL:
+                break;
+            default: return RC_ERROR;
+        }
+    }
+
+    bool *encoded = (bool *)calloc(schema->numAttr, sizeof(bool));
+    if (encoded == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    for (int i = 0; i < numEncoded; i++) {
+        int attr = encodedAttrs[i];
+        if (attr < 0 || attr >= schema->numAttr || schema->dataTypes[attr] != DT_STRING ||
+            schema->typeLength[attr] + DICT_ENTRY_HEADER > PAGE_SIZE) {
+            free(encoded);
+            return RC_ERROR;
+        }
+        encoded[attr] = TRUE;
+    }
+    Schema *stored = storedSchema(schema, encoded);
+    if (stored == NULL) {
+        free(encoded);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    RM_TableHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.num_tuples = 0;
+    header.start_page = FIRST_DATA_PAGE;
+    header.last_page = FIRST_DATA_PAGE;
+    header.max_slots = slotsPerPage(stored->recordSize);
+    header.layout = layout;
+
+    // a slotted page fits as many records as it has room for tuples of the shortest length,
+    // but only takes one while a longest tuple plus the room kept for growth still fits
+    RC status = RC_OK;
+    if (layout == RM_LAYOUT_SLOTTED) {
+        int min_tuple, max_tuple, reserve;
+        tupleSizes(stored, &min_tuple, &max_tuple);
+        reserve = max_tuple - min_tuple > SLOTTED_MAX_RESERVE ? SLOTTED_MAX_RESERVE : max_tuple - min_tuple;
+        if ((int)sizeof(RM_SlottedHeader) + (int)sizeof(RM_SlotEntry) + max_tuple + reserve > PAGE_SIZE)
+            status = RC_RM_RECORD_DOES_NOT_FIT;
+        header.max_slots = (PAGE_SIZE - (int)sizeof(RM_SlottedHeader)) / (min_tuple + (int)sizeof(RM_SlotEntry));
+    }
+    freeStoredSchema(stored);
+
+    // the dictionary of an earlier table with this name does not apply
+    if (status == RC_OK) {
+        removeDictionaryFile(name);
+        if (numEncoded > 0) status = createDictionaryFile(name, schema->numAttr, encoded);
+    }
+    free(encoded);
+    if (status != RC_OK) return status;
+
+    // Create page file for table
+    status = createPageFile(name);
+    if (status != RC_OK) return status;
+
+    SM_FileHandle fh;
+    status = openPageFile(name, &fh);
+    if (status != RC_OK) return status;
+
+    // Write the table header followed by the serialized schema
+    char *header_page = (char *)calloc(PAGE_SIZE, 1);
+    char *serialized_data = serializeSchema(schema);
+    if (header_page == NULL || serialized_data == NULL) {
+        status = RC_MEMORY_ALLOCATION_FAILED;
+    } else if (sizeof(header) + strlen(serialized_data) >= PAGE_SIZE) {
+        status = RC_WRITE_FAILED;  // the schema does not fit on the header page
+    } else {
+        memcpy(header_page, &header, sizeof(header));
+        strcpy(header_page + sizeof(header), serialized_data);
+        status = writeBlock(0, &fh, header_page);
+    }
+    closePageFile(&fh);
+    free(serialized_data);
+    free(header_page);
+    if (status != RC_OK) return status;
+
+    // zone maps of an earlier table with this name do not apply
+    char *zone_file = zoneFileName(name);
+    if (zone_file != NULL) remove(zone_file);
+    free(zone_file);
+
+    // indexes of an earlier table with this name go too, then the unique index on the schema key
+    removeIndexFiles(name);
+    if (schema->keySize > 0) {
+        char *index_file = indexFileName(name, "pk");
+        if (index_file == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+        status = createIndexFile(index_file, schema, schema->keySize, 0, schema->keyAttrs, RM_INDEX_BTREE, TRUE);
+        free(index_file);
+    }
+    return status;
+}
+
+// Write the cached table header into page 0; force also writes the page to disk
+static RC flushTableHeader(RecordManager *rm, bool force) {
+    BM_PageHandle pH;
+    RM_TableHeader header;
+
+    if (!rm->header_dirty) return RC_OK;
+
+    RC status = pinPage(&rm->poolconfig, &pH, 0);
+    if (status != RC_OK) return status;
+
+    memcpy(&header, pH.data, sizeof(header));
+    header.num_tuples = rm->num_tuples;
+    header.start_page = rm->start_page;
+    header.last_page = rm->last_page;
+    header.max_slots = rm->max_slots;
+    header.layout = rm->layout;
+    memcpy(pH.data, &header, sizeof(header));
+
+    status = markDirty(&rm->poolconfig, &pH);
+    if (status == RC_OK && force) status = forcePage(&rm->poolconfig, &pH);
+    RC unpin_status = unpinPage(&rm->poolconfig, &pH);
+    if (status == RC_OK) status = unpin_status;
+
+    if (status == RC_OK) {
+        rm->header_dirty = FALSE;
+        rm->header_changes = 0;
+    }
+    return status;
+}
+
+// Note changes to the counts in the cached header, writing it out once enough have piled up
+static RC tableHeaderChanged(RecordManager *rm, int changes) {
+    rm->header_dirty = TRUE;
+    rm->header_changes += changes;
+    if (rm->header_changes < HEADER_FLUSH_CHANGES) return RC_OK;
+    return flushTableHeader(rm, TRUE);
+}
+
+// Open table
+extern RC openTable(RM_TableData *rel, char *name) {
+    RecordManager *record_mgr = (RecordManager *)calloc(1, sizeof(RecordManager));
+    if (record_mgr == NULL) return RC_ERROR;
+
+    RC status = initBufferPool(&record_mgr->poolconfig, name, maxPages, RS_FIFO, NULL);
+    if (status != RC_OK) {
+        free(record_mgr);
+        return status;
+    }
+
+    BM_PageHandle pH;
+    status = pinPage(&record_mgr->poolconfig, &pH, 0);
+    if (status != RC_OK) {
+        shutdownBufferPool(&record_mgr->poolconfig);
+        free(record_mgr);
+        return status;
+    }
+
+    // the counts and the append point come straight from the header, no page is scanned
+    RM_TableHeader header;
+    memcpy(&header, pH.data, sizeof(header));
+    if (memcmp(header.magic, TABLE_MAGIC, sizeof(header.magic)) != 0) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        shutdownBufferPool(&record_mgr->poolconfig);
+        free(record_mgr);
+        return RC_ERROR;
+    }
+
+    record_mgr->num_tuples = header.num_tuples;
+    record_mgr->start_page = header.start_page;
+    record_mgr->last_page = header.last_page;
+    record_mgr->max_slots = header.max_slots;
+    record_mgr->fsm_hint = header.start_page;
+    record_mgr->layout = (RM_Layout)header.layout;
+    record_mgr->header_dirty = FALSE;
+    record_mgr->header_changes = 0;
+
+    Schema *schema = deserializeSchema(pH.data + sizeof(header));
+    if (schema == NULL) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        shutdownBufferPool(&record_mgr->poolconfig);
+        free(record_mgr);
+        return RC_ERROR;
+    }
+    record_mgr->indexes = NULL;
+    record_mgr->num_indexes = 0;
+    record_mgr->stats = readTableStats(pH.data, schema);
+    rel->name = name;
+    rel->schema = schema;
+    rel->mgmtData = record_mgr;
+
+    // the layout of the stored records depends on which attributes are encoded
+    status = openDictionary(record_mgr, schema, name);
+    if (status == RC_OK) status = initRecordLayout(record_mgr, schema);
+    if (status == RC_OK) status = initZoneMaps(record_mgr, schema);
+    if (status == RC_OK) status = loadZoneMaps(record_mgr, schema, name);
+    if (status == RC_OK) status = openIndexes(record_mgr, rel);
+
+    RC unpin_status = unpinPage(&record_mgr->poolconfig, &pH);
+    if (status == RC_OK) status = unpin_status;
+    if (status != RC_OK) {
+        closeIndexes(record_mgr);
+        freeTableStats(record_mgr->stats);
+        freeRecordLayout(record_mgr);
+        freeDictionary(record_mgr->dictionary);
+        shutdownBufferPool(&record_mgr->poolconfig);
+        free(record_mgr);
+        rel->mgmtData = NULL;
+        return status;
+    }
+    return RC_OK;
+}
+
+// Close table
+extern RC closeTable(RM_TableData *rel) {
+    RecordManager *record_mgr = rel->mgmtData;
+    RC status = flushTableHeader(record_mgr, FALSE);
+    RC zone_status = saveZoneMaps(record_mgr, rel->name, TRUE);
+    RC index_status = closeIndexes(record_mgr);
+    RC pool_status = shutdownBufferPool(&record_mgr->poolconfig);
+    if (status == RC_OK) status = zone_status;
+    if (status == RC_OK) status = index_status;
+    if (status == RC_OK) status = pool_status;
+    freeRecordLayout(record_mgr);
+    freeDictionary(record_mgr->dictionary);
+    free(record_mgr->zone_offsets);
+    free(record_mgr->zone_maps);
+    freeTableStats(record_mgr->stats);
+    free(record_mgr);
+    freeSchema(rel->schema);
+    rel->schema = NULL;
+    return status;
+}
+
+// Write the table header and every changed page of the table to disk
+extern RC checkpointTable(RM_TableData *rel) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+
+    RC status = flushTableHeader(record_mgr, FALSE);
+    if (status != RC_OK) return status;
+    return forceFlushPool(&record_mgr->poolconfig);
+}
+
+// Delete table
+extern RC deleteTable(char *name) {
+    char *zone_file = zoneFileName(name);
+    if (zone_file != NULL) remove(zone_file);
+    free(zone_file);
+
+    removeDictionaryFile(name);
+    removeIndexFiles(name);
+
+    return destroyPageFile(name) == RC_OK ? RC_OK : RC_FILE_NOT_FOUND;
+}
+
+// Get number of tuples in the table
+extern int getNumTuples(RM_TableData *rel) {
+    return ((RecordManager *)rel->mgmtData)->num_tuples;
+}
+
+/******************************** Index Functions *************************************/
+
+// Create an index on attributes of an open table and build it from the records already there
+extern RC createIndex(RM_TableData *rel, char *indexName, int numAttrs, int *attrs, RM_IndexType type, bool unique) {
+    return createCoveringIndex(rel, indexName, numAttrs, attrs, 0, NULL, type, unique);
+}
+
+// Create an index whose entries also carry the included attributes, so scans that only
+// need those columns are answered from the index alone
+extern RC createCoveringIndex(RM_TableData *rel, char *indexName, int numAttrs, int *attrs, int numIncluded, int *included,
+                              RM_IndexType type, bool unique) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    Schema *schema = rel->schema;
+    int index_attrs[RM_MAX_INDEX_ATTRS];
+    RM_Index index;
+
+    if (indexName == NULL || indexName[0] == '\0' || strlen(indexName) >= RM_MAX_INDEX_NAME || strchr(indexName, '/') != NULL)
+        return RC_ERROR;
+    if (type != RM_INDEX_BTREE && type != RM_INDEX_HASH) return RC_ERROR;
+    if (numAttrs <= 0 || numIncluded < 0 || numAttrs + numIncluded > RM_MAX_INDEX_ATTRS) return RC_ERROR;
+    memcpy(index_attrs, attrs, sizeof(int) * numAttrs);
+    if (numIncluded > 0) memcpy(index_attrs + numAttrs, included, sizeof(int) * numIncluded);
+    for (int i = 0; i < numAttrs + numIncluded; i++)
+        if (index_attrs[i] < 0 || index_attrs[i] >= schema->numAttr) return RC_ERROR;
+    for (int i = 0; i < record_mgr->num_indexes; i++)
+        if (strcmp(record_mgr->indexes[i].name, indexName) == 0) return RC_IM_KEY_ALREADY_EXISTS;
+
+    char *file_name = secondaryIndexFileName(rel->name, indexName);
+    if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    memset(&index, 0, sizeof(index));
+    strcpy(index.name, indexName);
+    index.type = type;
+    index.unique = unique;
+    index.num_key_attrs = numAttrs;
+    index.num_included_attrs = numIncluded;
+
+    // a stale file of an earlier index with this name would be opened instead of built
+    deleteIndexFile(file_name, type);
+    RC status = attachIndex(record_mgr, schema, file_name, &index, index_attrs);
+
+    // duplicates already in the table make a unique index fail
+    if (status != RC_OK) {
+        int last = record_mgr->num_indexes - 1;
+        if (last >= 0 && strcmp(record_mgr->indexes[last].name, indexName) == 0) removeIndex(record_mgr, last);
+        deleteIndexFile(file_name, type);
+    }
+    free(file_name);
+
+    if (status == RC_OK) status = saveIndexCatalog(record_mgr, rel->name);
+    return status;
+}
+
+// Drop an index created with createIndex
+extern RC dropIndex(RM_TableData *rel, char *indexName) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+
+    for (int i = 0; i < record_mgr->num_indexes; i++) {
+        RM_Index *index = &record_mgr->indexes[i];
+        if (index->primary || strcmp(index->name, indexName) != 0) continue;
+
+        RM_IndexType type = index->type;
+        RC status = removeIndex(record_mgr, i);
+
+        char *file_name = secondaryIndexFileName(rel->name, indexName);
+        if (file_name == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+        if (status == RC_OK) status = deleteIndexFile(file_name, type);
+        free(file_name);
+
+        RC catalog_status = saveIndexCatalog(record_mgr, rel->name);
+        return status == RC_OK ? catalog_status : status;
+    }
+    return RC_RM_INDEX_NOT_FOUND;
+}
+
+/******************************** Statistics Functions ********************************/
+
+// Sample up to STATS_SAMPLE_PAGES data pages spread evenly over the table and store per
+// attribute statistics on page 0: min, max, distinct count, null fraction and equi-depth
+// histogram bounds. Distinct counts seen in a sample are scaled up by how unique the
+// sample looked, so a key stays close to num_tuples while a small domain stays as counted.
+extern RC analyzeTable(RM_TableData *rel) {
+    RecordManager *rm = (RecordManager *)rel->mgmtData;
+    Schema *schema = rel->schema;
+    int num_attrs = schema->numAttr, data_pages = 0, sampled_pages = 0, rows = 0, capacity = 1024;
+    BM_PageHandle pH, header;
+
+    RC status = pinPage(&rm->poolconfig, &header, 0);
+    if (status != RC_OK) return status;
+
+    // as many buckets as page 0 has room for
+    int room = PAGE_SIZE - statsOffset(header.data), buckets = STATS_MAX_BUCKETS;
+    while (buckets >= 1 && statsSize(num_attrs, buckets) > room) buckets--;
+    if (buckets < 1) {
+        unpinPage(&rm->poolconfig, &header);
+        return RC_RM_STATS_DO_NOT_FIT;
+    }
+
+    RM_TableStats *stats = allocTableStats(num_attrs, buckets);
+    unsigned char *registers = (unsigned char *)calloc((size_t)num_attrs << HLL_BITS, 1);
+    double *values = (double *)malloc(sizeof(double) * num_attrs * capacity);
+    if (stats == NULL || registers == NULL || values == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+
+    for (int page = rm->start_page; page <= rm->last_page; page = nextDataPage(page)) data_pages++;
+    int stride = data_pages > STATS_SAMPLE_PAGES ? data_pages / STATS_SAMPLE_PAGES : 1;
+
+    // values are gathered attribute-major: values[a * capacity + row]
+    for (int page = rm->start_page, i = 0; page <= rm->last_page && status == RC_OK; page = nextDataPage(page), i++) {
+        if (i % stride != 0 || sampled_pages == STATS_SAMPLE_PAGES) continue;
+        sampled_pages++;
+
+        status = pinPage(&rm->poolconfig, &pH, page);
+        if (status != RC_OK) break;
+
+        for (int slot = 0; slot < PAGE_HEADER(pH.data)->num_slots && status == RC_OK; slot++) {
+            if (!isSlotUsed(rm, pH.data, slot)) continue;
+
+            if (rows == capacity) {
+                double *more = (double *)malloc(sizeof(double) * num_attrs * capacity * 2);
+                if (more == NULL) {
+                    status = RC_MEMORY_ALLOCATION_FAILED;
+                    break;
+                }
+                for (int a = 0; a < num_attrs; a++)
+                    memcpy(more + (size_t)a * capacity * 2, values + (size_t)a * capacity, sizeof(double) * rows);
+                free(values);
+                values = more;
+                capacity *= 2;
+            }
+
+            readSlot(rm, num_attrs, pH.data, slot, rm->row_buffer);
+            for (int a = 0; a < num_attrs; a++) {
+                char *value = rm->row_buffer + rm->attr_offsets[a];
+                values[(size_t)a * capacity + rows] = statsValue(schema->dataTypes[a], value, rm->attr_sizes[a]);
+                hllAdd(registers + ((size_t)a << HLL_BITS), statsHash(schema->dataTypes[a], value, rm->attr_sizes[a]));
+            }
+            rows++;
+        }
+        RC unpin_status = unpinPage(&rm->poolconfig, &pH);
+        if (status == RC_OK) status = unpin_status;
+    }
+
+    if (status == RC_OK) {
+        stats->header.num_tuples = rm->num_tuples;
+        stats->header.sampled_rows = rows;
+
+        for (int a = 0; a < num_attrs && rows > 0; a++) {
+            double *column = values + (size_t)a * capacity, *bounds = stats->bounds + a * (buckets + 1);
+            RM_AttrStats *attr = &stats->attrs[a];
+
+            qsort(column, rows, sizeof(double), compareDoubles);
+            attr->min = column[0];
+            attr->max = column[rows - 1];
+            for (int b = 0; b <= buckets; b++) bounds[b] = column[(size_t)b * (rows - 1) / buckets];
+
+            double seen = hllEstimate(registers + ((size_t)a << HLL_BITS));
+            if (seen > rows) seen = rows;
+            if (seen < 1) seen = 1;
+            double unique = seen / rows;
+            attr->distinct = seen + unique * unique * (rm->num_tuples > rows ? rm->num_tuples - rows : 0);
+            attr->null_fraction = 0;
+        }
+
+        writeTableStats(header.data, stats);
+        status = markDirty(&rm->poolconfig, &header);
+    }
+    RC unpin_status = unpinPage(&rm->poolconfig, &header);
+    if (status == RC_OK) status = unpin_status;
+
+    free(registers);
+    free(values);
+    if (status != RC_OK) {
+        freeTableStats(stats);
+        return status;
+    }
+    freeTableStats(rm->stats);
+    rm->stats = stats;
+    return RC_OK;
+}
+
+// Without statistics, the guesses System R used
+#define DEFAULT_EQUAL_SELECTIVITY 0.1
+#define DEFAULT_RANGE_SELECTIVITY (1.0 / 3)
+
+// Fraction of the rows whose attribute is below value, read off the histogram
+static double fractionBelow(RM_TableStats *stats, int attr, double value) {
+    int buckets = stats->header.num_buckets;
+    double *bounds = stats->bounds + attr * (buckets + 1);
+
+    if (value <= bounds[0]) return 0;
+    if (value > bounds[buckets]) return 1;
+    for (int b = 0; b < buckets; b++) {
+        if (value > bounds[b + 1]) continue;
+        double width = bounds[b + 1] - bounds[b];
+        return (b + (width > 0 ? (value - bounds[b]) / width : 0)) / buckets;
+    }
+    return 1;
+}
+
+// A value several bounds share fills the buckets between them; any other value gets its
+// share of the distinct values
+static double equalSelectivity(RM_TableStats *stats, int attr, double value) {
+    RM_AttrStats *attr_stats = &stats->attrs[attr];
+    int buckets = stats->header.num_buckets, shared = 0;
+    double *bounds = stats->bounds + attr * (buckets + 1);
+
+    if (stats->header.sampled_rows == 0 || value < attr_stats->min || value > attr_stats->max) return 0;
+    for (int b = 0; b <= buckets; b++)
+        if (bounds[b] == value) shared++;
+    if (shared > 1 && (double)(shared - 1) / buckets > 1 / attr_stats->distinct) return (double)(shared - 1) / buckets;
+    return 1 / attr_stats->distinct;
+}
+
+// Selectivity of a comparison between an attribute and a constant, attr < value or,
+// with attrOnLeft false, value < attr
+static double compareSelectivity(RecordManager *rm, Schema *schema, OpType op, int attr, Value *value, bool attrOnLeft) {
+    RM_TableStats *stats = rm->stats;
+
+    if (stats == NULL || value->dt != schema->dataTypes[attr])
+        return op == OP_COMP_EQUAL ? DEFAULT_EQUAL_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+
+    double key = statsConstant(value), equal = equalSelectivity(stats, attr, key);
+    if (op == OP_COMP_EQUAL) return equal;
+    if (stats->header.sampled_rows == 0) return 0;
+
+    double below = fractionBelow(stats, attr, key), above = 1 - below - equal;
+    return attrOnLeft ? below : (above > 0 ? above : 0);
+}
+
+static double conditionSelectivity(RecordManager *rm, Schema *schema, Expr *cond) {
+    if (cond == NULL) return 1;
+    if (cond->type == EXPR_CONST) return (cond->expr.cons->dt == DT_BOOL && !cond->expr.cons->v.boolV) ? 0 : 1;
+    // a bare attribute is a boolean one, and the statistics keep no values for booleans,
+    // so it is taken to be true for half of the rows
+    if (cond->type == EXPR_ATTRREF) return 0.5;
+
+    Operator *op = cond->expr.op;
+    double left, right;
+    switch (op->type) {
+        case OP_BOOL_NOT:
+            return 1 - conditionSelectivity(rm, schema, op->args[0]);
+        case OP_BOOL_AND:
+            return conditionSelectivity(rm, schema, op->args[0]) * conditionSelectivity(rm, schema, op->args[1]);
+        case OP_BOOL_OR:
+            left = conditionSelectivity(rm, schema, op->args[0]);
+            right = conditionSelectivity(rm, schema, op->args[1]);
+            return left + right - left * right;
+        case OP_COMP_EQUAL:
+        case OP_COMP_SMALLER: {
+            Expr *a = op->args[0], *b = op->args[1];
+            if (a->type == EXPR_ATTRREF && b->type == EXPR_CONST)
+                return compareSelectivity(rm, schema, op->type, a->expr.attrRef, b->expr.cons, TRUE);
+            if (a->type == EXPR_CONST && b->type == EXPR_ATTRREF)
+                return compareSelectivity(rm, schema, op->type, b->expr.attrRef, a->expr.cons, FALSE);
+
+            // two attributes: equal values match one in max(distinct) of the time
+            if (op->type == OP_COMP_EQUAL && a->type == EXPR_ATTRREF && b->type == EXPR_ATTRREF && rm->stats != NULL) {
+                double distinct = rm->stats->attrs[a->expr.attrRef].distinct;
+                if (rm->stats->attrs[b->expr.attrRef].distinct > distinct) distinct = rm->stats->attrs[b->expr.attrRef].distinct;
+                return 1 / distinct;
+            }
+            return op->type == OP_COMP_EQUAL ? DEFAULT_EQUAL_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+        }
+    }
+    return DEFAULT_RANGE_SELECTIVITY;
+}
+
+// Estimated fraction of the records of a table that satisfy cond, from the statistics of the
+// last analyzeTable or fixed guesses when there are none
+extern double estimateSelectivity(RM_TableData *rel, Expr *cond) {
+    double selectivity = conditionSelectivity((RecordManager *)rel->mgmtData, rel->schema, cond);
+
+    if (selectivity < 0) return 0;
+    if (selectivity > 1) return 1;
+    return selectivity;
+}
+
+/******************************** Compaction Functions ********************************/
+
+// Store row in a free slot of another page in place of the record in slot, and repoint
+// every index at the new RID
+static RC moveRecord(RecordManager *rm, Schema *schema, BM_PageHandle *from, int slot, BM_PageHandle *to, int toSlot, char *row) {
+    RID old_rid = {from->pageNum, slot}, new_rid = {to->pageNum, toSlot};
+    int i;
+
+    // the target slot stays free until the indexes have followed, a failure leaves the record where it was
+    RC status = zoneWiden(rm, schema, to->pageNum, row);
+    if (status == RC_OK) status = writeSlot(rm, schema->numAttr, to->data, toSlot, row);
+    if (status != RC_OK) return status;
+
+    for (i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        packRowKey(rm, schema, index, row, index->key);
+
+        status = indexDeleteKey(index, index->key, old_rid);
+        if (status != RC_OK) break;
+        status = indexInsertKey(index, index->key, new_rid);
+        if (status != RC_OK) {
+            indexInsertKey(index, index->key, old_rid);
+            break;
+        }
+    }
+
+    if (status != RC_OK) {
+        while (--i >= 0) {
+            indexDeleteKey(&rm->indexes[i], rm->indexes[i].key, new_rid);
+            indexInsertKey(&rm->indexes[i], rm->indexes[i].key, old_rid);
+        }
+        setSlotUsed(rm, to->data, toSlot, FALSE);  // a slotted page took the tuple already
+        return status;
+    }
+    setSlotUsed(rm, to->data, toSlot, TRUE);
+    setSlotUsed(rm, from->data, slot, FALSE);
+    return RC_OK;
+}
+
+// Cut the pages after last_page off the table file
+static RC truncateTable(RecordManager *rm, char *name) {
+    SM_FileHandle fh;
+    int num_pages = rm->last_page + 1;
+
+    if (rm->fsm_hint > rm->last_page) rm->fsm_hint = nextDataPage(rm->last_page);
+
+    // cached copies of the cut pages would be written back past the new end
+    RC status = discardPages(&rm->poolconfig, num_pages);
+    if (status != RC_OK) return status;
+
+    status = openPageFile(name, &fh);
+    if (status != RC_OK) return status;
+    status = truncatePageFile(num_pages, &fh);
+    closePageFile(&fh);
+    return status;
+}
+
+// Move records from the last pages of the table into free slots nearer its start, at most
+// maxMoves per call or all of them when maxMoves <= 0, then cut the emptied pages off the file.
+// Moved records get new RIDs: the indexes follow them, RIDs kept by the caller and scans open
+// on the table do not. *done tells whether the table is as dense as it gets.
+extern RC compactTable(RM_TableData *rel, int maxMoves, bool *done) {
+    RecordManager *rm = (RecordManager *)rel->mgmtData;
+    Schema *schema = rel->schema;
+    BM_PageHandle from, to;
+    int moved = 0, last_page = rm->last_page;
+    bool finished = FALSE;
+    RC status = RC_OK;
+
+    while (status == RC_OK && !finished && (maxMoves <= 0 || moved < maxMoves)) {
+        int source = rm->last_page, target;
+
+        status = fsmSearch(rm, previousDataPage(source), &target);
+        if (status != RC_OK) break;
+        if (source == rm->start_page || target >= source) {
+            finished = TRUE;  // every page before the last one is full
+            break;
+        }
+        rm->fsm_hint = target;
+
+        status = ensureZoneCapacity(rm, target);
+        if (status == RC_OK) status = pinPage(&rm->poolconfig, &from, source);
+        if (status != RC_OK) break;
+        status = pinPage(&rm->poolconfig, &to, target);
+        if (status != RC_OK) {
+            unpinPage(&rm->poolconfig, &from);
+            break;
+        }
+        initDataPage(rm, to.data);
+
+        for (int slot = 0; slot < PAGE_HEADER(from.data)->num_slots && (maxMoves <= 0 || moved < maxMoves); slot++) {
+            if (!isSlotUsed(rm, from.data, slot)) continue;
+
+            int free_slot = findFreeSlot(rm, to.data);
+            if (free_slot == -1) break;
+
+            readSlot(rm, schema->numAttr, from.data, slot, rm->row_buffer);
+            status = moveRecord(rm, schema, &from, slot, &to, free_slot, rm->row_buffer);
+            if (status != RC_OK) break;
+            moved++;
+        }
+        int source_used = PAGE_HEADER(from.data)->num_slots - PAGE_HEADER(from.data)->free_slots;
+        int source_fill = pageFill(rm, from.data), target_fill = pageFill(rm, to.data);
+
+        RC unpin_status = markDirty(&rm->poolconfig, &from);
+        RC dirty_status = markDirty(&rm->poolconfig, &to);
+        if (unpin_status == RC_OK) unpin_status = dirty_status;
+        RC from_status = unpinPage(&rm->poolconfig, &from);
+        RC to_status = unpinPage(&rm->poolconfig, &to);
+        if (unpin_status == RC_OK) unpin_status = from_status;
+        if (unpin_status == RC_OK) unpin_status = to_status;
+        if (unpin_status == RC_OK) unpin_status = fsmSetUsed(rm, source, source_fill);
+        if (unpin_status == RC_OK) unpin_status = fsmSetUsed(rm, target, target_fill);
+        if (status == RC_OK) status = unpin_status;
+
+        // an emptied last page leaves the table
+        if (source_used == 0) {
+            zoneReset(rm, source);
+            rm->last_page = previousDataPage(source);
+        }
+    }
+
+    if (rm->last_page < last_page) {
+        RC truncate_status = truncateTable(rm, rel->name);
+        // the header must not point past the end of the shortened file
+        rm->header_dirty = TRUE;
+        if (truncate_status == RC_OK) truncate_status = flushTableHeader(rm, TRUE);
+        if (status == RC_OK) status = truncate_status;
+    }
+    if (done != NULL) *done = finished;
+    return status;
+}
+
+/******************************** Record Functions ************************************/
+// Insert record into table
+extern RC insertRecord(RM_TableData *rel, Record *record) {
+    return insertRecords(rel, &record, 1);
+}
+
+// Insert a batch of records, filling every free slot of a page under a single pin
+extern RC insertRecords(RM_TableData *rel, Record **records, int numRecords) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+
+    int num_attrs = rel->schema->numAttr;
+    int inserted = 0;
+
+    while (inserted < numRecords) {
+        int page;
+
+        // the free-space map points at the first page with room, reusing slots freed by deletes
+        RC status = fsmFindPage(record_mgr, &page);
+        if (status == RC_OK) status = ensureZoneCapacity(record_mgr, page);
+        if (status != RC_OK) return status;
+
+        status = pinPage(&record_mgr->poolconfig, &pH, page);
+        if (status != RC_OK) return status;
+        initDataPage(record_mgr, pH.data);
+
+        int page_inserts = 0;
+        int free_slot_in_page;
+        RC row_status = RC_OK;
+
+        while (inserted < numRecords && (free_slot_in_page = findFreeSlot(record_mgr, pH.data)) != -1) {
+            Record *record = records[inserted];
+            RID rid = {page, free_slot_in_page};
+
+            // a duplicate key, a string the dictionary fails to take or a failed write ends
+            // the batch, the records before it stay inserted
+            row_status = dictionaryAddRow(record_mgr, record->data);
+            if (row_status == RC_OK) row_status = indexInsertRow(record_mgr, rel->schema, record->data, rid);
+            if (row_status != RC_OK) break;
+
+            // the zone map has to cover the record before it reaches the page
+            row_status = zoneWiden(record_mgr, rel->schema, page, record->data);
+            if (row_status == RC_OK) row_status = writeSlot(record_mgr, num_attrs, pH.data, free_slot_in_page, record->data);
+            if (row_status != RC_OK) {
+                indexDeleteRow(record_mgr, rel->schema, record->data, rid);
+                break;
+            }
+            setSlotUsed(record_mgr, pH.data, free_slot_in_page, TRUE);
+            inserted++;
+
+            record->id.page = page;
+            record->id.slot = free_slot_in_page;
+            page_inserts++;
+        }
+        int page_fill = pageFill(record_mgr, pH.data);
+
+        if (page_inserts > 0) status = markDirty(&record_mgr->poolconfig, &pH);
+        if (status != RC_OK) {
+            unpinPage(&record_mgr->poolconfig, &pH);
+            return status;
+        }
+
+        status = unpinPage(&record_mgr->poolconfig, &pH);
+        if (status != RC_OK) return status;
+
+        status = fsmSetUsed(record_mgr, page, page_fill);
+        if (status != RC_OK) return status;
+
+        record_mgr->num_tuples += page_inserts;
+        if (page_inserts > 0) status = tableHeaderChanged(record_mgr, page_inserts);
+        if (row_status != RC_OK) return row_status;
+        if (status != RC_OK) return status;
+    }
+    return RC_OK;
+}
+
+// Delete a record from the table
+extern RC deleteRecord(RM_TableData *rel, RID id) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+
+    if (!isDataPage(record_mgr, id.page)) return RC_NO_TUPLE_RID;
+
+    RC delete_page = pinPage(&record_mgr->poolconfig, &pH, id.page);
+    if (delete_page != RC_OK) return delete_page;
+
+    if (!isSlotUsed(record_mgr, pH.data, id.slot)) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return RC_NO_TUPLE_RID;
+    }
+
+    if (record_mgr->num_indexes > 0) {
+        readSlot(record_mgr, rel->schema->numAttr, pH.data, id.slot, record_mgr->row_buffer);
+        delete_page = indexDeleteRow(record_mgr, rel->schema, record_mgr->row_buffer, id);
+        if (delete_page != RC_OK) {
+            unpinPage(&record_mgr->poolconfig, &pH);
+            return delete_page;
+        }
+    }
+    setSlotUsed(record_mgr, pH.data, id.slot, FALSE);
+    int used_slots = PAGE_HEADER(pH.data)->num_slots - PAGE_HEADER(pH.data)->free_slots;
+    int page_fill = pageFill(record_mgr, pH.data);
+
+    delete_page = markDirty(&record_mgr->poolconfig, &pH);
+    if (delete_page != RC_OK) return delete_page;
+
+    delete_page = unpinPage(&record_mgr->poolconfig, &pH);
+    if (delete_page != RC_OK) return delete_page;
+
+    // the freed slot is handed out again by the next insert
+    if (id.page < record_mgr->fsm_hint) record_mgr->fsm_hint = id.page;
+    if (used_slots == 0) zoneReset(record_mgr, id.page);
+    record_mgr->num_tuples--;
+
+    delete_page = fsmSetUsed(record_mgr, id.page, page_fill);
+    if (delete_page != RC_OK) return delete_page;
+    return tableHeaderChanged(record_mgr, 1);
+}
+
+// Move a record that outgrew its slotted page to a page with room for its new values. The
+// indexes already hold its new keys under the old RID and follow it to the new one; record->id
+// changes as soon as the record has moved, even when bookkeeping after the move fails.
+static RC relocateRecord(RecordManager *rm, Schema *schema, BM_PageHandle *from, Record *record) {
+    BM_PageHandle to;
+    int page;
+
+    RC status = fsmFindPage(rm, &page);
+    if (status == RC_OK) status = ensureZoneCapacity(rm, page);
+    if (status == RC_OK) status = pinPage(&rm->poolconfig, &to, page);
+    if (status != RC_OK) return status;
+    initDataPage(rm, to.data);
+
+    int slot = findFreeSlot(rm, to.data);
+    if (slot == -1) status = RC_RM_RECORD_DOES_NOT_FIT;
+    else status = moveRecord(rm, schema, from, record->id.slot, &to, slot, record->data);
+    if (status != RC_OK) {
+        unpinPage(&rm->poolconfig, &to);
+        return status;
+    }
+    record->id.page = page;
+    record->id.slot = slot;
+    int page_fill = pageFill(rm, to.data);
+
+    status = markDirty(&rm->poolconfig, &to);
+    RC unpin_status = unpinPage(&rm->poolconfig, &to);
+    if (status == RC_OK) status = unpin_status;
+    if (status == RC_OK) status = fsmSetUsed(rm, page, page_fill);
+    if (status == RC_OK) status = tableHeaderChanged(rm, 1);  // the table may have grown a page
+    return status;
+}
+
+// Update a record in the table. On a slotted table a record that no longer fits on its page
+// moves to another one and record->id is set to its new RID, like compactTable moves records.
+extern RC updateRecord(RM_TableData *rel, Record *record) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+
+    if (!isDataPage(record_mgr, record->id.page)) return RC_NO_TUPLE_RID;
+
+    RC update_page = pinPage(&record_mgr->poolconfig, &pH, record->id.page);
+    if (update_page != RC_OK) return update_page;
+
+    if (!isSlotUsed(record_mgr, pH.data, record->id.slot)) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return RC_NO_TUPLE_RID;
+    }
+
+    update_page = dictionaryAddRow(record_mgr, record->data);
+    if (update_page != RC_OK) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return update_page;
+    }
+
+    // a key already taken by another record rejects the update
+    if (record_mgr->num_indexes > 0) {
+        readSlot(record_mgr, rel->schema->numAttr, pH.data, record->id.slot, record_mgr->row_buffer);
+        update_page = indexUpdateRow(record_mgr, rel->schema, record_mgr->row_buffer, record->data, record->id);
+        if (update_page != RC_OK) {
+            unpinPage(&record_mgr->poolconfig, &pH);
+            return update_page;
+        }
+    }
+
+    // a record that grew past the free space of its slotted page leaves it
+    int page = record->id.page;
+    if (!slotHasRoom(record_mgr, rel->schema->numAttr, pH.data, record->id.slot, record->data)) {
+        RID rid = record->id;
+        update_page = relocateRecord(record_mgr, rel->schema, &pH, record);
+
+        // the record did not move: its old keys go back into the indexes under its RID
+        if (update_page != RC_OK && record->id.page == rid.page && record->id.slot == rid.slot) {
+            if (record_mgr->num_indexes > 0)
+                indexUpdateRow(record_mgr, rel->schema, record->data, record_mgr->row_buffer, rid);
+            unpinPage(&record_mgr->poolconfig, &pH);
+            return update_page;
+        }
+        int used_slots = PAGE_HEADER(pH.data)->num_slots - PAGE_HEADER(pH.data)->free_slots;
+        int page_fill = pageFill(record_mgr, pH.data);
+
+        RC unpin_status = markDirty(&record_mgr->poolconfig, &pH);
+        if (unpin_status == RC_OK) unpin_status = unpinPage(&record_mgr->poolconfig, &pH);
+        if (update_page == RC_OK) update_page = unpin_status;
+
+        // the page the record left may hold nothing any more
+        if (used_slots == 0) zoneReset(record_mgr, page);
+        if (page < record_mgr->fsm_hint) record_mgr->fsm_hint = page;
+        RC fsm_status = fsmSetUsed(record_mgr, page, page_fill);
+        return update_page == RC_OK ? fsm_status : update_page;
+    }
+
+    // the zone map has to cover the new values before they reach the page
+    update_page = zoneWiden(record_mgr, rel->schema, record->id.page, record->data);
+    if (update_page == RC_OK) update_page = writeSlot(record_mgr, rel->schema->numAttr, pH.data, record->id.slot, record->data);
+    if (update_page != RC_OK) {
+        // the slot keeps its old values, so the indexes get their old keys back
+        if (record_mgr->num_indexes > 0)
+            indexUpdateRow(record_mgr, rel->schema, record->data, record_mgr->row_buffer, record->id);
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return update_page;
+    }
+    int page_fill = pageFill(record_mgr, pH.data);
+
+    update_page = markDirty(&record_mgr->poolconfig, &pH);
+    if (update_page != RC_OK) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return update_page;
+    }
+
+    update_page = unpinPage(&record_mgr->poolconfig, &pH);
+    if (update_page != RC_OK || record_mgr->layout != RM_LAYOUT_SLOTTED) return update_page;
+
+    // the record's new length changes whether its page takes more records
+    return fsmSetUsed(record_mgr, page, page_fill);
+}
+
+// Get a record by its ID
+extern RC getRecord(RM_TableData *rel, RID id, Record *record) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+
+    if (!isDataPage(record_mgr, id.page)) return RC_NO_TUPLE_RID;
+
+    RC record_page = pinPage(&record_mgr->poolconfig, &pH, id.page);
+    if (record_page != RC_OK) return record_page;
+
+    if (!isSlotUsed(record_mgr, pH.data, id.slot)) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return RC_NO_TUPLE_RID;
+    }
+
+    readSlot(record_mgr, rel->schema->numAttr, pH.data, id.slot, record->data);
+    record->id = id;
+
+    record_page = unpinPage(&record_mgr->poolconfig, &pH);
+    return record_page;
+}
+
+// Get a record without copying it: the reference points into the pinned page until it is released
+extern RC getRecordRef(RM_TableData *rel, RID id, RM_RecordRef *ref) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+
+    ref->record.data = NULL;
+    if (!isDataPage(record_mgr, id.page)) return RC_NO_TUPLE_RID;
+
+    RC status = pinPage(&record_mgr->poolconfig, &pH, id.page);
+    if (status != RC_OK) return status;
+
+    if (!isSlotUsed(record_mgr, pH.data, id.slot)) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return RC_NO_TUPLE_RID;
+    }
+
+    ref->rel = rel;
+    ref->record.id = id;
+    if (record_mgr->layout == RM_LAYOUT_ROW && record_mgr->dictionary == NULL) {
+        ref->record.data = PAGE_SLOTS(pH.data) + id.slot * record_mgr->record_size;
+        ref->pinned = TRUE;
+        return RC_OK;
+    }
+
+    // PAX and slotted pages and encoded attributes do not hold the record as it is laid out
+    // in memory, so it is gathered into a copy
+    ref->record.data = (char *)malloc(record_mgr->record_size);
+    if (ref->record.data == NULL) {
+        unpinPage(&record_mgr->poolconfig, &pH);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    readSlot(record_mgr, rel->schema->numAttr, pH.data, id.slot, ref->record.data);
+    ref->pinned = FALSE;
+
+    status = unpinPage(&record_mgr->poolconfig, &pH);
+    if (status != RC_OK) {
+        free(ref->record.data);
+        ref->record.data = NULL;
+    }
+    return status;
+}
+
+// Unpin the page of a record reference, or free its copy
+extern RC releaseRecordRef(RM_RecordRef *ref) {
+    RC status = RC_OK;
+
+    if (ref->record.data == NULL) return RC_OK;
+    if (ref->pinned) {
+        RecordManager *record_mgr = (RecordManager *)ref->rel->mgmtData;
+        BM_PageHandle pH;
+        pH.pageNum = ref->record.id.page;
+        pH.data = ref->record.data;
+        status = unpinPage(&record_mgr->poolconfig, &pH);
+    } else {
+        free(ref->record.data);
+    }
+    ref->record.data = NULL;
+    return status;
+}
+
+// Get a record through the primary key index
+extern RC getRecordByKey(RM_TableData *rel, Value **key, Record *record) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    RID id;
+
+    RM_Index *index = NULL;
+    RC status;
+
+    // a hash index on the key answers with a single bucket pin, the tree walks from its root
+    for (int i = 0; i < record_mgr->num_indexes; i++) {
+        RM_Index *candidate = &record_mgr->indexes[i];
+        bool on_key = candidate->unique && candidate->num_key_attrs == rel->schema->keySize &&
+                      memcmp(candidate->key_attrs, rel->schema->keyAttrs, sizeof(int) * rel->schema->keySize) == 0;
+
+        if (on_key && (index == NULL || candidate->type == RM_INDEX_HASH)) index = candidate;
+    }
+    if (index == NULL) return RC_IM_KEY_NOT_FOUND;
+
+    if (index->type == RM_INDEX_HASH) {
+        status = packHashKey(index->hash, key, index->key);
+        if (status == RC_OK) status = findHashKey(index->hash, index->key, &id);
+    } else {
+        status = packKey(index->tree, key, index->key);
+        if (status == RC_OK) status = findKey(index->tree, index->key, &id);
+    }
+    if (status == RC_OK) status = getRecord(rel, id, record);
+    return status;
+}
+
+// Position of a requested RID, sorted by page so each page is pinned once
+typedef struct RID_Request {
+    RID id;
+    int index;                      // Position in the caller's array
+} RID_Request;
+
+static int compareRidRequests(const void *a, const void *b) {
+    const RID_Request *left = (const RID_Request *)a, *right = (const RID_Request *)b;
+
+    if (left->id.page != right->id.page) return (left->id.page < right->id.page) ? -1 : 1;
+    return (left->id.slot < right->id.slot) ? -1 : (left->id.slot > right->id.slot);
+}
+
+// Get a batch of records, grouped by page so every distinct page is pinned once
+extern RC getRecords(RM_TableData *rel, RID *ids, int numIds, Record **records) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    BM_PageHandle pH;
+    RC status = RC_OK;
+
+    if (numIds <= 0) return RC_OK;
+
+    int num_attrs = rel->schema->numAttr;
+    RID_Request *requests = (RID_Request *)malloc(sizeof(RID_Request) * numIds);
+    PageNumber *pages = (PageNumber *)malloc(sizeof(PageNumber) * numIds);
+    if (requests == NULL || pages == NULL) {
+        free(requests);
+        free(pages);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    for (int i = 0; i < numIds; i++) {
+        requests[i].id = ids[i];
+        requests[i].index = i;
+    }
+    qsort(requests, numIds, sizeof(RID_Request), compareRidRequests);
+
+    // let the disk start on every page before the first one is pinned
+    int numPages = 0;
+    for (int i = 0; i < numIds; i++)
+        if (numPages == 0 || pages[numPages - 1] != requests[i].id.page) pages[numPages++] = requests[i].id.page;
+    prefetchPages(&record_mgr->poolconfig, pages, numPages);
+
+    for (int i = 0; i < numIds && status == RC_OK;) {
+        int page = requests[i].id.page;
+
+        if (!isDataPage(record_mgr, page)) {
+            status = RC_NO_TUPLE_RID;
+            break;
+        }
+        status = pinPage(&record_mgr->poolconfig, &pH, page);
+        if (status != RC_OK) break;
+
+        for (; i < numIds && requests[i].id.page == page; i++) {
+            Record *record = records[requests[i].index];
+
+            if (!isSlotUsed(record_mgr, pH.data, requests[i].id.slot)) {
+                status = RC_NO_TUPLE_RID;
+                break;
+            }
+            readSlot(record_mgr, num_attrs, pH.data, requests[i].id.slot, record->data);
+            record->id = requests[i].id;
+        }
+
+        RC unpin_status = unpinPage(&record_mgr->poolconfig, &pH);
+        if (status == RC_OK) status = unpin_status;
+    }
+
+    free(requests);
+    free(pages);
+    return status;
+}
+
+/******************************** Scan Functions **************************************/
+
+// Start a scan over all records matching cond, or all records if cond is NULL
+extern RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond) {
+    return startProjectedScan(rel, scan, cond, NULL, 0);
+}
+
+static void freeProjectedSchema(Schema *projection) {
+    if (projection == NULL) return;
+    free(projection->attrNames);
+    free(projection->dataTypes);
+    free(projection->typeLength);
+    free(projection->keyAttrs);
+    free(projection->attrOffsets);
+    free(projection->attrSizes);
+    free(projection);
+}
+
+// Schema holding only the given attributes of schema, in the given order. Attribute
+// names are shared with schema, the arrays are owned by the new schema.
+static Schema *projectSchema(Schema *schema, int *attrs, int numAttrs) {
+    Schema *projection = (Schema *)malloc(sizeof(Schema));
+    if (projection == NULL) return NULL;
+
+    projection->numAttr = numAttrs;
+    projection->attrNames = (char **)malloc(sizeof(char *) * numAttrs);
+    projection->dataTypes = (DataType *)malloc(sizeof(DataType) * numAttrs);
+    projection->typeLength = (int *)malloc(sizeof(int) * numAttrs);
+    projection->keyAttrs = (int *)malloc(sizeof(int) * (schema->keySize > 0 ? schema->keySize : 1));
+    projection->keySize = 0;
+
+    for (int i = 0; i < numAttrs; i++) {
+        projection->attrNames[i] = schema->attrNames[attrs[i]];
+        projection->dataTypes[i] = schema->dataTypes[attrs[i]];
+        projection->typeLength[i] = schema->typeLength[attrs[i]];
+    }
+    if (initSchemaLayout(projection) != RC_OK) {
+        projection->attrOffsets = NULL;
+        projection->attrSizes = NULL;
+        freeProjectedSchema(projection);
+        return NULL;
+    }
+
+    // keep the key attributes that survive the projection
+    for (int k = 0; k < schema->keySize; k++)
+        for (int i = 0; i < numAttrs; i++)
+            if (attrs[i] == schema->keyAttrs[k]) {
+                projection->keyAttrs[projection->keySize++] = i;
+                break;
+            }
+
+    return projection;
+}
+
+// Constant bounds a condition puts on one attribute
+typedef struct RM_AttrBounds {
+    Value *eq;
+    Value *low;
+    bool low_inclusive;
+    Value *high;
+    bool high_inclusive;
+} RM_AttrBounds;
+
+// Collect the bounds of the conjunction cond: attr = c, attr < c, c < attr and their negations.
+// Anything else (OR, comparisons between attributes) is left for the condition to decide.
+static void collectBounds(Schema *schema, Expr *cond, RM_AttrBounds *bounds) {
+    if (cond == NULL || cond->type != EXPR_OP) return;
+
+    Operator *op = cond->expr.op;
+    bool negated = FALSE;
+    if (op->type == OP_BOOL_AND) {
+        collectBounds(schema, op->args[0], bounds);
+        collectBounds(schema, op->args[1], bounds);
+        return;
+    }
+    if (op->type == OP_BOOL_NOT && op->args[0]->type == EXPR_OP && op->args[0]->expr.op->type == OP_COMP_SMALLER) {
+        op = op->args[0]->expr.op;
+        negated = TRUE;
+    }
+    if (op->type != OP_COMP_EQUAL && op->type != OP_COMP_SMALLER) return;
+
+    Expr *left = op->args[0], *right = op->args[1];
+    bool attr_left = left->type == EXPR_ATTRREF && right->type == EXPR_CONST;
+    if (!attr_left && !(left->type == EXPR_CONST && right->type == EXPR_ATTRREF)) return;
+
+    int attr = attr_left ? left->expr.attrRef : right->expr.attrRef;
+    Value *value = attr_left ? right->expr.cons : left->expr.cons;
+    if (attr < 0 || attr >= schema->numAttr || value->dt != schema->dataTypes[attr]) return;
+
+    RM_AttrBounds *b = &bounds[attr];
+    if (op->type == OP_COMP_EQUAL) {
+        if (b->eq == NULL) b->eq = value;
+    } else if (attr_left != negated) {
+        // attr < c, or not (c < attr): an upper bound
+        if (b->high == NULL) {
+            b->high = value;
+            b->high_inclusive = negated;
+        }
+    } else if (b->low == NULL) {
+        // c < attr, or not (attr < c): a lower bound
+        b->low = value;
+        b->low_inclusive = negated;
+    }
+}
+
+// Pack a constant as a one-attribute key. A string longer than the attribute is cut to it,
+// which makes a range bound on it inclusive.
+static void packBound(Schema *schema, int attr, Value *value, char *key, bool *inclusive) {
+    switch (value->dt) {
+        case DT_INT:   memcpy(key, &value->v.intV, sizeof(int)); break;
+        case DT_FLOAT: memcpy(key, &value->v.floatV, sizeof(float)); break;
+        case DT_BOOL:  memcpy(key, &value->v.boolV, sizeof(bool)); break;
+        case DT_STRING:
+            strncpy(key, value->v.stringV, schema->typeLength[attr]);
+            if (strlen(value->v.stringV) > (size_t)schema->typeLength[attr] && inclusive != NULL) *inclusive = TRUE;
+            break;
+    }
+}
+
+static int compareRidOrder(const void *a, const void *b) {
+    const RID *left = (const RID *)a, *right = (const RID *)b;
+
+    if (left->page != right->page) return (left->page < right->page) ? -1 : 1;
+    return (left->slot < right->slot) ? -1 : (left->slot > right->slot);
+}
+
+static RC appendRid(RID **rids, int *count, int *capacity, RID rid) {
+    if (*count == *capacity) {
+        RID *more = (RID *)realloc(*rids, sizeof(RID) * *capacity * 2);
+        if (more == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+        *rids = more;
+        *capacity *= 2;
+    }
+    (*rids)[(*count)++] = rid;
+    return RC_OK;
+}
+
+// Attributes an expression reads
+static void collectAttrRefs(Expr *expr, bool *needed) {
+    if (expr == NULL) return;
+    if (expr->type == EXPR_ATTRREF) needed[expr->expr.attrRef] = TRUE;
+    else if (expr->type == EXPR_OP) {
+        collectAttrRefs(expr->expr.op->args[0], needed);
+        if (expr->expr.op->type != OP_BOOL_NOT) collectAttrRefs(expr->expr.op->args[1], needed);
+    }
+}
+
+// How much an index narrows a condition down: 3 a hash with every key attribute bound by an
+// equality, 2 a tree bound the same way, 1 a single-attribute tree with a range, 0 not at all
+static int indexScore(RM_Index *index, RM_AttrBounds *bounds) {
+    for (int k = 0; k < index->num_key_attrs; k++) {
+        if (bounds[index->key_attrs[k]].eq != NULL) continue;
+
+        if (index->type == RM_INDEX_BTREE && index->num_key_attrs == 1) {
+            RM_AttrBounds *b = &bounds[index->key_attrs[0]];
+            if (b->low != NULL || b->high != NULL) return 1;
+        }
+        return 0;
+    }
+    return (index->type == RM_INDEX_HASH) ? 3 : 2;
+}
+
+// Whether the key and included attributes of an index hold every attribute a scan reads
+static bool indexCovers(RM_Index *index, bool *needed, int numAttrs) {
+    for (int a = 0; a < numAttrs; a++) {
+        if (!needed[a]) continue;
+
+        bool found = FALSE;
+        for (int k = 0; k < index->num_key_attrs + index->num_included_attrs && !found; k++)
+            found = index->key_attrs[k] == a;
+        if (!found) return FALSE;
+    }
+    return TRUE;
+}
+
+// Open a cursor over the entries of index that can match: the bound key, the range, or
+// (score 0) the whole tree
+static RC openIndexCursor(RecordManager *rm, Schema *schema, RM_Index *index, int score, RM_AttrBounds *bounds, RM_IndexCursor *cursor) {
+    char *low = (char *)calloc(1, index->key_size), *high = (char *)calloc(1, index->key_size);
+    RC status = (low == NULL || high == NULL) ? RC_MEMORY_ALLOCATION_FAILED : RC_OK;
+
+    cursor->index = index;
+    cursor->tree_scan = NULL;
+    cursor->hash_scan = NULL;
+
+    if (status == RC_OK && score >= 2) {
+        for (int k = 0, offset = 0; k < index->num_key_attrs; k++) {
+            int attr = index->key_attrs[k];
+            packBound(schema, attr, bounds[attr].eq, low + offset, NULL);
+            offset += rm->attr_sizes[attr];
+        }
+        if (index->type == RM_INDEX_HASH) status = openHashScan(index->hash, low, &cursor->hash_scan);
+        else status = openTreeRangeScan(index->tree, low, TRUE, low, TRUE, &cursor->tree_scan);
+    } else if (status == RC_OK && score == 1) {
+        int attr = index->key_attrs[0];
+        RM_AttrBounds *b = &bounds[attr];
+        bool low_inclusive = b->low_inclusive, high_inclusive = b->high_inclusive;
+
+        if (b->low != NULL) packBound(schema, attr, b->low, low, &low_inclusive);
+        if (b->high != NULL) packBound(schema, attr, b->high, high, &high_inclusive);
+        status = openTreeRangeScan(index->tree, b->low != NULL ? low : NULL, low_inclusive,
+                                   b->high != NULL ? high : NULL, high_inclusive, &cursor->tree_scan);
+    } else if (status == RC_OK) {
+        status = openTreeScan(index->tree, &cursor->tree_scan);
+    }
+
+    free(low);
+    free(high);
+    return status;
+}
+
+// Next entry of an index cursor, RC_IM_NO_MORE_ENTRIES at the end
+static RC nextIndexCursor(RM_IndexCursor *cursor, char *key, RID *rid) {
+    if (cursor->hash_scan != NULL) return nextHashKeyEntry(cursor->hash_scan, key, rid);
+    return nextKeyEntry(cursor->tree_scan, key, rid);
+}
+
+static RC closeIndexCursor(RM_IndexCursor *cursor) {
+    RC status = RC_OK;
+
+    if (cursor->hash_scan != NULL) status = closeHashScan(cursor->hash_scan);
+    if (cursor->tree_scan != NULL) status = closeTreeScan(cursor->tree_scan);
+    cursor->hash_scan = NULL;
+    cursor->tree_scan = NULL;
+    return status;
+}
+
+// Above this estimated selectivity a scan reads the table rather than an index that does not cover it
+#define INDEX_SCAN_MAX_SELECTIVITY 0.2
+
+// Pick the index that serves a scan best. An index holding every attribute the scan reads
+// answers it on its own (covered); otherwise the RIDs it returns for cond are fetched in page
+// order. A tree that covers the scan but does not narrow cond is still read instead of the
+// table when its entries are smaller than records. Leaves the scan alone when no index helps.
+static RC planIndexScan(RecordManager *rm, Schema *schema, RM_ScanManager *scan_mgr, int *attrs, int numAttrs) {
+    RM_Index *best = NULL;
+    int best_rank = 0, best_score = 0;
+    RC status = RC_OK;
+
+    if (rm->num_indexes == 0) return RC_OK;
+
+    RM_AttrBounds *bounds = (RM_AttrBounds *)calloc(schema->numAttr, sizeof(RM_AttrBounds));
+    bool *needed = (bool *)calloc(schema->numAttr, sizeof(bool));
+    if (bounds == NULL || needed == NULL) {
+        free(bounds);
+        free(needed);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    collectBounds(schema, scan_mgr->cond, bounds);
+    collectAttrRefs(scan_mgr->cond, needed);
+    if (attrs == NULL)
+        for (int a = 0; a < schema->numAttr; a++) needed[a] = TRUE;
+    else
+        for (int i = 0; i < numAttrs; i++) needed[attrs[i]] = TRUE;
+
+    for (int i = 0; i < rm->num_indexes; i++) {
+        RM_Index *index = &rm->indexes[i];
+        int score = indexScore(index, bounds);
+        bool covers = indexCovers(index, needed, schema->numAttr);
+        int rank = score * 2 + covers;
+
+        // a whole-tree pass only pays off when it reads fewer bytes than the table
+        if (score == 0 && (index->type != RM_INDEX_BTREE || index->key_size + (int)sizeof(RID) >= rm->record_size)) rank = 0;
+        if (rank > best_rank) {
+            best = index;
+            best_rank = rank;
+            best_score = score;
+        }
+    }
+
+    // fetching most of the table through RIDs costs more than reading it in order
+    if (best != NULL && best_rank % 2 == 0 && rm->stats != NULL &&
+        conditionSelectivity(rm, schema, scan_mgr->cond) > INDEX_SCAN_MAX_SELECTIVITY)
+        best = NULL;
+
+    if (best != NULL) status = openIndexCursor(rm, schema, best, best_score, bounds, &scan_mgr->cursor);
+    free(bounds);
+    free(needed);
+    if (best == NULL || status != RC_OK) return status;
+
+    if (best_rank % 2 == 1) {
+        // covered: the cursor stays open and next() rebuilds records from its entries
+        scan_mgr->covered_key = (char *)malloc(best->key_size);
+        scan_mgr->covered_row = (char *)calloc(1, rm->record_size);
+        if (scan_mgr->covered_key == NULL || scan_mgr->covered_row == NULL) {
+            closeIndexCursor(&scan_mgr->cursor);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+        scan_mgr->covered = TRUE;
+        return RC_OK;
+    }
+
+    int capacity = 64;
+    RID rid;
+    RC next_status = RC_IM_NO_MORE_ENTRIES;
+    scan_mgr->index_rids = (RID *)malloc(sizeof(RID) * capacity);
+    if (scan_mgr->index_rids == NULL) status = RC_MEMORY_ALLOCATION_FAILED;
+
+    while (status == RC_OK && (next_status = nextIndexCursor(&scan_mgr->cursor, NULL, &rid)) == RC_OK)
+        status = appendRid(&scan_mgr->index_rids, &scan_mgr->num_index_rids, &capacity, rid);
+    if (status == RC_OK && next_status != RC_IM_NO_MORE_ENTRIES) status = next_status;
+    closeIndexCursor(&scan_mgr->cursor);
+
+    if (status != RC_OK) {
+        free(scan_mgr->index_rids);
+        scan_mgr->index_rids = NULL;
+        scan_mgr->num_index_rids = 0;
+        return status;
+    }
+
+    // tree order is key order, the fetch wants page order
+    if (scan_mgr->num_index_rids > 1) qsort(scan_mgr->index_rids, scan_mgr->num_index_rids, sizeof(RID), compareRidOrder);
+    scan_mgr->use_index = TRUE;
+    return RC_OK;
+}
+
+// Set up a scan; cond is evaluated in arena, or in an arena of the scan's own if it is NULL
+static RC openScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numAttrs, Arena *arena) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    Schema *schema = rel->schema;
+
+    if (attrs != NULL) {
+        if (numAttrs <= 0) return RC_ERROR;
+        for (int i = 0; i < numAttrs; i++)
+            if (attrs[i] < 0 || attrs[i] >= schema->numAttr) return RC_ERROR;
+    }
+
+    RM_ScanManager *scan_mgr = (RM_ScanManager *)malloc(sizeof(RM_ScanManager));
+    if (scan_mgr == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    scan_mgr->current_record = (Record *)malloc(sizeof(Record));
+    if (scan_mgr->current_record == NULL) {
+        free(scan_mgr);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    scan_mgr->cond = cond;
+    scan_mgr->current_page = record_mgr->start_page;
+    scan_mgr->current_slot = 0;
+    scan_mgr->scanned_count = 0;
+    scan_mgr->record_size = schema->recordSize;
+    scan_mgr->page_pinned = FALSE;
+    scan_mgr->projection = NULL;
+    scan_mgr->runs = NULL;
+    scan_mgr->num_runs = 0;
+    scan_mgr->row_buffer = NULL;
+    scan_mgr->coded_cond = NULL;
+    scan_mgr->stored_row = NULL;
+    scan_mgr->use_index = FALSE;
+    scan_mgr->index_rids = NULL;
+    scan_mgr->num_index_rids = 0;
+    scan_mgr->next_rid = 0;
+    scan_mgr->covered = FALSE;
+    scan_mgr->covered_key = NULL;
+    scan_mgr->covered_row = NULL;
+    initArena(&scan_mgr->own_arena, 0);
+    scan_mgr->arena = arena != NULL ? arena : &scan_mgr->own_arena;
+
+    // only row pages have a row to point at, other matches are gathered into a buffer first
+    if (record_mgr->layout != RM_LAYOUT_ROW || record_mgr->dictionary != NULL) {
+        scan_mgr->row_buffer = (char *)malloc(scan_mgr->record_size);
+        if (scan_mgr->row_buffer == NULL) {
+            free(scan_mgr->current_record);
+            free(scan_mgr);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+    }
+
+    // with encoded attributes cond is decided on the stored records when it can be, and only
+    // matches have their codes looked up
+    if (record_mgr->dictionary != NULL && cond != NULL) {
+        scan_mgr->coded_cond = codedCondition(record_mgr, cond);
+        scan_mgr->stored_row = (char *)malloc(record_mgr->stored->recordSize);
+        if (scan_mgr->stored_row == NULL) {
+            if (scan_mgr->coded_cond != NULL) freeExpr(scan_mgr->coded_cond);
+            free(scan_mgr->row_buffer);
+            free(scan_mgr->current_record);
+            free(scan_mgr);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+    }
+
+    if (attrs != NULL) {
+        scan_mgr->projection = projectSchema(schema, attrs, numAttrs);
+        scan_mgr->runs = (RM_CopyRun *)malloc(sizeof(RM_CopyRun) * numAttrs);
+        if (scan_mgr->projection == NULL || scan_mgr->runs == NULL) {
+            freeProjectedSchema(scan_mgr->projection);
+            free(scan_mgr->runs);
+            if (scan_mgr->coded_cond != NULL) freeExpr(scan_mgr->coded_cond);
+            free(scan_mgr->stored_row);
+            free(scan_mgr->row_buffer);
+            free(scan_mgr->current_record);
+            free(scan_mgr);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+
+        // one run per attribute, merged with the previous run when both sides are adjacent
+        for (int i = 0, dst = 0; i < numAttrs; i++) {
+            int src = schema->attrOffsets[attrs[i]], length = schema->attrSizes[attrs[i]];
+
+            RM_CopyRun *last = scan_mgr->num_runs > 0 ? &scan_mgr->runs[scan_mgr->num_runs - 1] : NULL;
+            if (last != NULL && last->src + last->length == src && last->dst + last->length == dst) {
+                last->length += length;
+            } else {
+                RM_CopyRun *run = &scan_mgr->runs[scan_mgr->num_runs++];
+                run->src = src;
+                run->dst = dst;
+                run->length = length;
+            }
+            dst += length;
+        }
+    }
+
+    // an index on the attributes the scan reads may answer it, or limit it to the RIDs it returns
+    RC status = planIndexScan(record_mgr, schema, scan_mgr, attrs, numAttrs);
+    if (status != RC_OK) {
+        free(scan_mgr->covered_key);
+        free(scan_mgr->covered_row);
+        freeProjectedSchema(scan_mgr->projection);
+        free(scan_mgr->runs);
+        if (scan_mgr->coded_cond != NULL) freeExpr(scan_mgr->coded_cond);
+        free(scan_mgr->stored_row);
+        free(scan_mgr->row_buffer);
+        free(scan_mgr->current_record);
+        free(scan_mgr);
+        return status;
+    }
+
+    scan->rel = rel;
+    scan->mgmtData = scan_mgr;
+    return RC_OK;
+}
+
+// Start a scan that returns only the attributes listed in attrs. The returned records use
+// the schema from getScanSchema, which stays valid until closeScan. A NULL attrs returns
+// whole records, like startScan.
+extern RC startProjectedScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numAttrs) {
+    return openScan(rel, scan, cond, attrs, numAttrs, NULL);
+}
+
+// Start a scan that evaluates cond in the caller's arena. The scan resets the arena after
+// every record and at closeScan, so the arena must not hold anything else until then.
+extern RC startScanInArena(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, Arena *arena) {
+    return openScan(rel, scan, cond, NULL, 0, arena);
+}
+
+// Schema of the records a scan returns
+extern Schema *getScanSchema(RM_ScanHandle *scan) {
+    RM_ScanManager *scan_mgr = (RM_ScanManager *)scan->mgmtData;
+    return scan_mgr->projection != NULL ? scan_mgr->projection : scan->rel->schema;
+}
+
+// Evaluate cond on a record in arena, which is reset afterwards
+static RC conditionHolds(Expr *cond, Record *record, Schema *schema, Arena *arena, bool *holds) {
+    Value *result;
+    RC status = evalExprInArena(record, schema, cond, arena, &result);
+    *holds = status == RC_OK && result->v.boolV;
+    resetArena(arena);
+    return status;
+}
+
+// Evaluate cond, if any, on the probe record and copy it out if it matches
+static RC matchProbe(RM_ScanManager *scan_mgr, Schema *schema, Expr *cond, Record *record, bool *matched) {
+    Record *probe = scan_mgr->current_record;
+
+    *matched = FALSE;
+    scan_mgr->scanned_count++;
+
+    if (cond != NULL) {
+        bool match;
+        RC status = conditionHolds(cond, probe, schema, scan_mgr->arena, &match);
+        if (status != RC_OK || !match) return status;
+    }
+
+    if (scan_mgr->projection == NULL) {
+        memcpy(record->data, probe->data, scan_mgr->record_size);
+    } else {
+        for (int r = 0; r < scan_mgr->num_runs; r++) {
+            RM_CopyRun *run = &scan_mgr->runs[r];
+            memcpy(record->data + run->dst, probe->data + run->src, run->length);
+        }
+    }
+    record->id = probe->id;
+    *matched = TRUE;
+    return RC_OK;
+}
+
+// Point the probe at a slot of the pinned page and match it
+static RC matchSlot(RecordManager *rm, RM_ScanManager *scan_mgr, Schema *schema, int slot, Record *record, bool *matched) {
+    Record *probe = scan_mgr->current_record;
+    char *data = scan_mgr->page.data;
+    Expr *cond = scan_mgr->cond;
+
+    probe->id.page = scan_mgr->current_page;
+    probe->id.slot = slot;
+    if (scan_mgr->coded_cond != NULL) {
+        // compared on the codes where the record lies, a row page needs no copy
+        Record stored = {probe->id, scan_mgr->stored_row};
+        if (rm->layout == RM_LAYOUT_ROW) stored.data = PAGE_SLOTS(data) + slot * rm->stored->recordSize;
+        else readStored(rm, schema->numAttr, data, slot, stored.data);
+
+        bool match;
+        RC status = conditionHolds(scan_mgr->coded_cond, &stored, rm->stored, scan_mgr->arena, &match);
+        if (status != RC_OK || !match) {
+            scan_mgr->scanned_count++;
+            *matched = FALSE;
+            return status;
+        }
+        probe->data = scan_mgr->row_buffer;
+        decodeRow(rm, schema->numAttr, stored.data, probe->data);
+        cond = NULL;
+    } else if (scan_mgr->row_buffer == NULL) {
+        probe->data = PAGE_SLOTS(data) + slot * scan_mgr->record_size;
+    } else {
+        probe->data = scan_mgr->row_buffer;
+        readSlot(rm, schema->numAttr, data, slot, probe->data);
+    }
+    return matchProbe(scan_mgr, schema, cond, record, matched);
+}
+
+// Next match of a covered scan, rebuilt from index entries without touching the table
+static RC nextCovered(RecordManager *rm, RM_ScanManager *scan_mgr, Schema *schema, Record *record) {
+    RM_Index *index = scan_mgr->cursor.index;
+    Record *probe = scan_mgr->current_record;
+    RC status;
+    bool matched;
+
+    while ((status = nextIndexCursor(&scan_mgr->cursor, scan_mgr->covered_key, &probe->id)) == RC_OK) {
+        char *value = scan_mgr->covered_key;
+
+        for (int k = 0; k < index->num_key_attrs + index->num_included_attrs; k++) {
+            int attr = index->key_attrs[k];
+            memcpy(scan_mgr->covered_row + rm->attr_offsets[attr], value, rm->attr_sizes[attr]);
+            value += rm->attr_sizes[attr];
+        }
+        probe->data = scan_mgr->covered_row;
+
+        status = matchProbe(scan_mgr, schema, scan_mgr->cond, record, &matched);
+        if (status != RC_OK || matched) return status;
+    }
+    return status == RC_IM_NO_MORE_ENTRIES ? RC_RM_NO_MORE_TUPLES : status;
+}
+
+// Next match among the RIDs of an index scan. They are in page order, so each page is
+// pinned once for all of its RIDs; the whole condition is still checked on every record.
+static RC nextIndexed(RecordManager *rm, RM_ScanManager *scan_mgr, Schema *schema, Record *record) {
+    RC status;
+    bool matched;
+
+    while (scan_mgr->next_rid < scan_mgr->num_index_rids) {
+        RID id = scan_mgr->index_rids[scan_mgr->next_rid++];
+
+        if (!scan_mgr->page_pinned || scan_mgr->current_page != id.page) {
+            if (scan_mgr->page_pinned) {
+                scan_mgr->page_pinned = FALSE;
+                status = unpinPage(&rm->poolconfig, &scan_mgr->page);
+                if (status != RC_OK) return status;
+            }
+            status = pinPage(&rm->poolconfig, &scan_mgr->page, id.page);
+            if (status != RC_OK) return status;
+            scan_mgr->page_pinned = TRUE;
+            scan_mgr->current_page = id.page;
+        }
+
+        // the record may have been deleted since the scan started
+        if (id.slot >= PAGE_HEADER(scan_mgr->page.data)->num_slots || !isSlotUsed(rm, scan_mgr->page.data, id.slot)) continue;
+
+        status = matchSlot(rm, scan_mgr, schema, id.slot, record, &matched);
+        if (status != RC_OK || matched) return status;
+    }
+
+    if (scan_mgr->page_pinned) {
+        scan_mgr->page_pinned = FALSE;
+        status = unpinPage(&rm->poolconfig, &scan_mgr->page);
+        if (status != RC_OK) return status;
+    }
+    return RC_RM_NO_MORE_TUPLES;
+}
+
+// Return the next matching record. The current page stays pinned until all of its
+// slots are scanned, the condition is evaluated on the slot in place and only
+// matching records are copied out.
+extern RC next(RM_ScanHandle *scan, Record *record) {
+    RecordManager *record_mgr = (RecordManager *)scan->rel->mgmtData;
+    RM_ScanManager *scan_mgr = (RM_ScanManager *)scan->mgmtData;
+    Schema *schema = scan->rel->schema;
+    RC status;
+    bool matched;
+
+    if (scan_mgr->covered) return nextCovered(record_mgr, scan_mgr, schema, record);
+    if (scan_mgr->use_index) return nextIndexed(record_mgr, scan_mgr, schema, record);
+
+    while (TRUE) {
+        if (!scan_mgr->page_pinned) {
+            if (scan_mgr->current_page > record_mgr->last_page) return RC_RM_NO_MORE_TUPLES;
+
+            // pages the zone map rules out are never pinned
+            if (!zoneMayMatch(record_mgr, schema, scan_mgr->current_page, scan_mgr->cond)) {
+                scan_mgr->current_page = nextDataPage(scan_mgr->current_page);
+                continue;
+            }
+
+            status = pinPage(&record_mgr->poolconfig, &scan_mgr->page, scan_mgr->current_page);
+            if (status != RC_OK) return status;
+            scan_mgr->page_pinned = TRUE;
+            scan_mgr->current_slot = 0;
+        }
+
+        char *data = scan_mgr->page.data;
+        int num_slots = PAGE_HEADER(data)->num_slots;
+
+        for (int slot = scan_mgr->current_slot; slot < num_slots; slot++) {
+            if (!isSlotUsed(record_mgr, data, slot)) continue;
+
+            status = matchSlot(record_mgr, scan_mgr, schema, slot, record, &matched);
+            if (status != RC_OK) return status;
+            if (!matched) continue;
+
+            scan_mgr->current_slot = slot + 1;
+            return RC_OK;
+        }
+
+        // page done, move on with one unpin
+        status = unpinPage(&record_mgr->poolconfig, &scan_mgr->page);
+        scan_mgr->page_pinned = FALSE;
+        if (status != RC_OK) return status;
+        scan_mgr->current_page = nextDataPage(scan_mgr->current_page);
+    }
+}
+
+// Close the scan and release the page it still holds
+extern RC closeScan(RM_ScanHandle *scan) {
+    RecordManager *record_mgr = (RecordManager *)scan->rel->mgmtData;
+    RM_ScanManager *scan_mgr = (RM_ScanManager *)scan->mgmtData;
+    RC status = RC_OK;
+
+    if (scan_mgr == NULL) return RC_OK;
+
+    if (scan_mgr->page_pinned) status = unpinPage(&record_mgr->poolconfig, &scan_mgr->page);
+    if (scan_mgr->covered) {
+        RC cursor_status = closeIndexCursor(&scan_mgr->cursor);
+        if (status == RC_OK) status = cursor_status;
+    }
+
+    freeProjectedSchema(scan_mgr->projection);
+    free(scan_mgr->runs);
+    if (scan_mgr->coded_cond != NULL) freeExpr(scan_mgr->coded_cond);
+    free(scan_mgr->stored_row);
+    free(scan_mgr->row_buffer);
+    free(scan_mgr->index_rids);
+    free(scan_mgr->covered_key);
+    free(scan_mgr->covered_row);
+    free(scan_mgr->current_record);
+    resetArena(scan_mgr->arena);
+    freeArena(&scan_mgr->own_arena);
+    free(scan_mgr);
+    scan->mgmtData = NULL;
+    return status;
+}
+
+/***************************** Parallel Scan Functions ********************************/
+
+#define PARALLEL_MORSEL_PAGES 16    // Pages a worker reads and scans in one go
+
+struct RM_ParallelScan;
+
+// One worker thread; it owns the pages [next_page, end_page) until someone steals part of them
+typedef struct RM_ScanWorker {
+    pthread_t thread;
+    int id;
+    pthread_mutex_t lock;           // Guards next_page and end_page
+    int next_page;                  // Stored atomically, thieves estimate the range without the lock
+    int end_page;
+    struct RM_ParallelScan *scan;
+} RM_ScanWorker;
+
+typedef struct RM_ParallelScan {
+    RM_TableData *rel;
+    Expr *cond;
+    Expr *coded_cond;               // cond on the codes of encoded attributes, see openScan
+    RM_ScanCallback callback;
+    void *context;
+    RM_ScanWorker *workers;
+    int num_workers;
+    int record_size;
+    RC status;                      // First error seen by any worker
+} RM_ParallelScan;
+
+// Write every dirty page of the pool to disk; unlike forceFlushPool this includes pinned pages
+static RC flushPinnedPool(BM_BufferPool *pool) {
+    PageNumber *frames = getFrameContents(pool);
+    bool *dirty = getDirtyFlags(pool);
+    RC status = (frames == NULL || dirty == NULL) ? RC_MEMORY_ALLOCATION_FAILED : RC_OK;
+
+    for (int i = 0; i < pool->numPages && status == RC_OK; i++) {
+        BM_PageHandle pH;
+        if (frames[i] == NO_PAGE || !dirty[i]) continue;
+
+        pH.pageNum = frames[i];
+        status = forcePage(pool, &pH);
+    }
+    free(frames);
+    free(dirty);
+    return status;
+}
+
+static void setParallelScanError(RM_ParallelScan *scan, RC status) {
+    RC expected = RC_OK;
+    __atomic_compare_exchange_n(&scan->status, &expected, status, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// Take the next morsel from the worker's own range, stealing the upper half of the
+// largest remaining range of another worker once its own range is used up
+static bool claimMorsel(RM_ScanWorker *worker, int *firstPage, int *numPages) {
+    RM_ParallelScan *scan = worker->scan;
+
+    while (TRUE) {
+        pthread_mutex_lock(&worker->lock);
+        if (worker->next_page < worker->end_page) {
+            *firstPage = worker->next_page;
+            *numPages = worker->end_page - worker->next_page;
+            if (*numPages > PARALLEL_MORSEL_PAGES) *numPages = PARALLEL_MORSEL_PAGES;
+            __atomic_store_n(&worker->next_page, worker->next_page + *numPages, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&worker->lock);
+            return TRUE;
+        }
+        pthread_mutex_unlock(&worker->lock);
+
+        // the remaining counts are only an estimate until the victim is locked
+        RM_ScanWorker *victim = NULL;
+        int most = 0;
+        for (int i = 0; i < scan->num_workers; i++) {
+            RM_ScanWorker *other = &scan->workers[i];
+            int remaining = __atomic_load_n(&other->end_page, __ATOMIC_RELAXED) - __atomic_load_n(&other->next_page, __ATOMIC_RELAXED);
+            if (other != worker && remaining > most) {
+                most = remaining;
+                victim = other;
+            }
+        }
+        if (victim == NULL) return FALSE;
+
+        pthread_mutex_lock(&victim->lock);
+        int remaining = victim->end_page - victim->next_page;
+        int stolen_start = victim->next_page + remaining / 2;
+        int stolen_end = victim->end_page;
+        if (remaining > 0) __atomic_store_n(&victim->end_page, stolen_start, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&victim->lock);
+
+        if (remaining > 0) {
+            pthread_mutex_lock(&worker->lock);
+            __atomic_store_n(&worker->next_page, stolen_start, __ATOMIC_RELAXED);
+            __atomic_store_n(&worker->end_page, stolen_end, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&worker->lock);
+        }
+    }
+}
+
+// Evaluate the condition on every record of one data page and hand matches to the callback.
+// storedBuffer takes the stored records of a table with encoded attributes.
+static RC scanPageInPlace(RM_ParallelScan *scan, int worker, int pageNum, char *data, char *rowBuffer, char *storedBuffer,
+                          Arena *arena) {
+    RecordManager *record_mgr = (RecordManager *)scan->rel->mgmtData;
+    Schema *schema = scan->rel->schema;
+    Record probe;
+    int num_slots = PAGE_HEADER(data)->num_slots;
+    char *slots = PAGE_SLOTS(data);
+
+    for (int slot = 0; slot < num_slots; slot++) {
+        if (!isSlotUsed(record_mgr, data, slot)) continue;
+
+        Expr *cond = scan->cond;
+        probe.id.page = pageNum;
+        probe.id.slot = slot;
+        if (record_mgr->dictionary != NULL) {
+            // readSlot would share the table's buffer between the workers
+            Record stored = {probe.id, storedBuffer};
+            if (record_mgr->layout == RM_LAYOUT_ROW) stored.data = slots + slot * record_mgr->stored->recordSize;
+            else readStored(record_mgr, schema->numAttr, data, slot, stored.data);
+
+            if (scan->coded_cond != NULL) {
+                bool match;
+                RC status = conditionHolds(scan->coded_cond, &stored, record_mgr->stored, arena, &match);
+                if (status != RC_OK) return status;
+                if (!match) continue;
+                cond = NULL;
+            }
+            probe.data = rowBuffer;
+            decodeRow(record_mgr, schema->numAttr, stored.data, probe.data);
+        } else if (record_mgr->layout == RM_LAYOUT_ROW) {
+            probe.data = slots + slot * scan->record_size;
+        } else {
+            probe.data = rowBuffer;
+            readSlot(record_mgr, schema->numAttr, data, slot, probe.data);
+        }
+
+        if (cond != NULL) {
+            bool match;
+            RC status = conditionHolds(cond, &probe, schema, arena, &match);
+            if (status != RC_OK) return status;
+            if (!match) continue;
+        }
+
+        RC status = scan->callback(&probe, worker, scan->context);
+        if (status != RC_OK) return status;
+    }
+    return RC_OK;
+}
+
+// Worker thread: reads its morsels through its own file handle, so the buffer pool is
+// never touched from more than one thread
+static void *parallelScanWorker(void *arg) {
+    RM_ScanWorker *worker = (RM_ScanWorker *)arg;
+    RM_ParallelScan *scan = worker->scan;
+    RecordManager *record_mgr = (RecordManager *)scan->rel->mgmtData;
+    int first_page, num_pages;
+    Arena arena;                    // Values of cond, one arena per worker
+
+    initArena(&arena, 0);
+    FILE *file = fopen(scan->rel->name, "rb");
+    char *pages = (char *)malloc((size_t)PAGE_SIZE * PARALLEL_MORSEL_PAGES);
+    char *row_buffer = (char *)malloc(scan->record_size);
+    char *stored_buffer = (char *)malloc(record_mgr->stored->recordSize);
+    if (file == NULL || pages == NULL || row_buffer == NULL || stored_buffer == NULL) {
+        setParallelScanError(scan, file == NULL ? RC_FILE_NOT_FOUND : RC_MEMORY_ALLOCATION_FAILED);
+        if (file != NULL) fclose(file);
+        free(pages);
+        free(row_buffer);
+        free(stored_buffer);
+        return NULL;
+    }
+
+    while (__atomic_load_n(&scan->status, __ATOMIC_RELAXED) == RC_OK && claimMorsel(worker, &first_page, &num_pages)) {
+        // the morsel is not read at all if the zone map rules out every page in it
+        bool may_match = FALSE;
+        for (int i = 0; i < num_pages && !may_match; i++)
+            may_match = !isFsmPage(first_page + i) && zoneMayMatch(record_mgr, scan->rel->schema, first_page + i, scan->cond);
+        if (!may_match) continue;
+
+        // pages past the end of the file were never written and hold no records
+        if (fseek(file, (long)first_page * PAGE_SIZE, SEEK_SET) != 0) continue;
+        int pages_read = (int)fread(pages, PAGE_SIZE, num_pages, file);
+
+        for (int i = 0; i < pages_read; i++) {
+            if (isFsmPage(first_page + i) || !zoneMayMatch(record_mgr, scan->rel->schema, first_page + i, scan->cond)) continue;
+
+            RC status = scanPageInPlace(scan, worker->id, first_page + i, pages + (size_t)i * PAGE_SIZE, row_buffer, stored_buffer,
+                                        &arena);
+            if (status != RC_OK) {
+                setParallelScanError(scan, status);
+                break;
+            }
+        }
+    }
+
+    fclose(file);
+    free(pages);
+    free(row_buffer);
+    free(stored_buffer);
+    freeArena(&arena);
+    return NULL;
+}
+
+// Scan the table with numWorkers threads (one per online CPU if numWorkers <= 0).
+// The data pages are split into contiguous ranges, one per worker, that are consumed
+// a morsel at a time; idle workers steal from the busiest range. Changes made while
+// the scan runs may or may not be seen.
+extern RC parallelScan(RM_TableData *rel, Expr *cond, int numWorkers, RM_ScanCallback callback, void *context) {
+    RecordManager *record_mgr = (RecordManager *)rel->mgmtData;
+    RM_ParallelScan scan;
+
+    if (callback == NULL) return RC_ERROR;
+
+    // workers read the file directly, so it has to be current
+    RC status = flushPinnedPool(&record_mgr->poolconfig);
+    if (status != RC_OK) return status;
+
+    int first_page = record_mgr->start_page;
+    int num_pages = record_mgr->last_page - first_page + 1;
+    if (num_pages <= 0) return RC_OK;
+
+    if (numWorkers <= 0) numWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int num_morsels = (num_pages + PARALLEL_MORSEL_PAGES - 1) / PARALLEL_MORSEL_PAGES;
+    if (numWorkers > num_morsels) numWorkers = num_morsels;
+    if (numWorkers < 1) numWorkers = 1;
+
+    scan.rel = rel;
+    scan.cond = cond;
+    scan.coded_cond = (record_mgr->dictionary != NULL && cond != NULL) ? codedCondition(record_mgr, cond) : NULL;
+    scan.callback = callback;
+    scan.context = context;
+    scan.num_workers = numWorkers;
+    scan.record_size = rel->schema->recordSize;
+    scan.status = RC_OK;
+    scan.workers = (RM_ScanWorker *)malloc(sizeof(RM_ScanWorker) * numWorkers);
+    if (scan.workers == NULL) {
+        if (scan.coded_cond != NULL) freeExpr(scan.coded_cond);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+
+    for (int i = 0; i < numWorkers; i++) {
+        RM_ScanWorker *worker = &scan.workers[i];
+        worker->id = i;
+        worker->scan = &scan;
+        worker->next_page = first_page + (int)((long)num_pages * i / numWorkers);
+        worker->end_page = first_page + (int)((long)num_pages * (i + 1) / numWorkers);
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+
+    int started = 0;
+    for (; started < numWorkers; started++) {
+        if (pthread_create(&scan.workers[started].thread, NULL, parallelScanWorker, &scan.workers[started]) != 0) break;
+    }
+    // the ranges of workers that could not be started are stolen by the others
+    if (started == 0) parallelScanWorker(&scan.workers[0]);
+
+    for (int i = 0; i < started; i++) pthread_join(scan.workers[i].thread, NULL);
+    for (int i = 0; i < numWorkers; i++) pthread_mutex_destroy(&scan.workers[i].lock);
+
+    free(scan.workers);
+    if (scan.coded_cond != NULL) freeExpr(scan.coded_cond);
+    return scan.status;
+}
+
+/******************************** Bulk Load Functions *********************************/
+#define BULK_LOAD_PAGES 64           // Pages packed in memory before one sequential write
+
+// Splits a delimited line in place, double quotes protect delimiters and "" is a quote
+static int splitFields(char *line, char delimiter, char **fields, int maxFields) {
+    int numFields = 0;
+    char *in = line, *out = line;
+
+    while (numFields < maxFields) {
+        fields[numFields++] = out;
+        bool quoted = (*in == '"');
+        if (quoted) in++;
+
+        while (*in != '\0') {
+            if (quoted && *in == '"') {
+                if (in[1] == '"') { *out++ = '"'; in += 2; continue; }
+                quoted = FALSE;
+                in++;
+                continue;
+            }
+            if (!quoted && *in == delimiter) break;
+            *out++ = *in++;
+        }
+
+        bool more = (*in == delimiter);
+        *out++ = '\0';
+        if (!more) return numFields;
+        in++;
+    }
+    return numFields + 1;  // more fields than the schema has attributes
+}
+
+// Parses one field into the bytes of an attribute
+static RC parseField(char *field, Schema *schema, int attrNum, char *dest) {
+    char *end;
+
+    switch (schema->dataTypes[attrNum]) {
+        case DT_INT: {
+            int value = (int)strtol(field, &end, 10);
+            if (end == field || *end != '\0') return RC_BULK_LOAD_PARSE_ERROR;
+            memcpy(dest, &value, sizeof(int));
+            break;
+        }
+        case DT_FLOAT: {
+            float value = strtof(field, &end);
+            if (end == field || *end != '\0') return RC_BULK_LOAD_PARSE_ERROR;
+            memcpy(dest, &value, sizeof(float));
+            break;
+        }
+        case DT_BOOL: {
+            bool value;
+            if (field[0] == 't' || field[0] == 'T' || strcmp(field, "1") == 0) value = TRUE;
+            else if (field[0] == 'f' || field[0] == 'F' || strcmp(field, "0") == 0) value = FALSE;
+            else return RC_BULK_LOAD_PARSE_ERROR;
+            memcpy(dest, &value, sizeof(bool));
+            break;
+        }
+        case DT_STRING:
+            strncpy(dest, field, schema->typeLength[attrNum]);  // pads the rest with '\0'
+            break;
+        default:
+            return RC_UNKNOWN_DATATYPE;
+    }
+    return RC_OK;
+}
+
+// Writes the packed pages to disk in one go and records them in the free-space map
+static RC flushLoadedPages(RecordManager *rm, SM_FileHandle *fh, char *pages, int firstPage, int numPages) {
+    if (numPages <= 0) return RC_OK;
+
+    RC status = writeBlocks(firstPage, numPages, fh, pages);
+    if (status != RC_OK) return status;
+
+    for (int i = 0; i < numPages; i++) {
+        char *data = pages + i * PAGE_SIZE;
+        if (isFsmPage(firstPage + i)) continue;
+
+        status = fsmSetUsed(rm, firstPage + i, pageFill(rm, data));
+        if (status != RC_OK) return status;
+    }
+    memset(pages, 0, (size_t)numPages * PAGE_SIZE);
+    return RC_OK;
+}
+
+// Loads delimited rows into new pages after the last data page, bypassing the buffer pool
+extern RC bulkLoadTable(RM_TableData *rel, FILE *input, char delimiter, int *numLoaded) {
+    RecordManager *rm = (RecordManager *)rel->mgmtData;
+    Schema *schema = rel->schema;
+    SM_FileHandle fh;
+
+    char *row = (char *)malloc(rm->record_size);
+    char **fields = (char **)malloc(sizeof(char *) * (schema->numAttr + 1));
+    char *pages = (char *)calloc(BULK_LOAD_PAGES, PAGE_SIZE);
+    char *line = NULL;
+    size_t line_capacity = 0;
+    int loaded = 0;
+
+    // a table without records is loaded from its first data page on
+    int page = (rm->num_tuples == 0 && rm->last_page == rm->start_page) ? rm->start_page : nextDataPage(rm->last_page);
+    int batch_start = page;
+
+    // pages written behind the pool's back must not have a cached copy
+    RC status = discardPages(&rm->poolconfig, page);
+    if (status == RC_OK) status = openPageFile(rel->name, &fh);
+    if (status != RC_OK) goto cleanup;
+
+    char *data = NULL;
+
+    while (getline(&line, &line_capacity, input) != -1) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') continue;
+
+        if (splitFields(line, delimiter, fields, schema->numAttr) != schema->numAttr) {
+            status = RC_BULK_LOAD_PARSE_ERROR;
+            break;
+        }
+
+        // move to the next page once the current one is full
+        int slot = (data != NULL) ? findFreeSlot(rm, data) : -1;
+        if (slot == -1) {
+            if (data != NULL) page = nextDataPage(page);
+            if (page - batch_start >= BULK_LOAD_PAGES) {
+                status = flushLoadedPages(rm, &fh, pages, batch_start, BULK_LOAD_PAGES);
+                if (status != RC_OK) break;
+                batch_start = page;
+            }
+            data = pages + (page - batch_start) * PAGE_SIZE;
+            initDataPage(rm, data);
+            slot = findFreeSlot(rm, data);
+            status = ensureZoneCapacity(rm, page);
+            if (status != RC_OK) break;
+        }
+
+        // row pages are parsed into place, other layouts and encoded attributes store the parsed
+        // row the way they lay it out
+        bool in_place = (rm->layout == RM_LAYOUT_ROW && rm->dictionary == NULL);
+        char *dest = in_place ? PAGE_SLOTS(data) + slot * rm->record_size : row;
+        for (int i = 0; i < schema->numAttr && status == RC_OK; i++)
+            status = parseField(fields[i], schema, i, dest + rm->attr_offsets[i]);
+        if (status != RC_OK) break;
+
+        // a duplicate key stops the load before the row is marked used
+        RID rid = {page, slot};
+        status = dictionaryAddRow(rm, dest);
+        if (status == RC_OK) status = indexInsertRow(rm, schema, dest, rid);
+        if (status != RC_OK) break;
+
+        if (!in_place) status = writeSlot(rm, schema->numAttr, data, slot, row);
+        if (status == RC_OK) status = zoneWiden(rm, schema, page, dest);
+        if (status != RC_OK) {
+            indexDeleteRow(rm, schema, dest, rid);
+            break;
+        }
+
+        setSlotUsed(rm, data, slot, TRUE);
+        loaded++;
+    }
+
+    // rows parsed before an error are kept
+    if (data != NULL) {
+        RC flush_status = flushLoadedPages(rm, &fh, pages, batch_start, page - batch_start + 1);
+        if (status == RC_OK) status = flush_status;
+        rm->last_page = page;
+    }
+    closePageFile(&fh);
+    rm->num_tuples += loaded;
+
+    // one header update for the whole load
+    if (loaded > 0) {
+        RC header_status = tableHeaderChanged(rm, loaded);
+        if (status == RC_OK) status = header_status;
+    }
+
+cleanup:
+    if (numLoaded != NULL) *numLoaded = loaded;
+    free(line);
+    free(pages);
+    free(fields);
+    free(row);
+    return status;
+}
+
+/******************************** Schema Functions ************************************/
+
+// Size of a record of the schema
+extern int getRecordSize(Schema *schema) {
+    return schema->recordSize;
+}
+
+// Create a schema; it takes over the arrays passed in and frees them in freeSchema
+extern Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys) {
+    Schema *schema = (Schema *)malloc(sizeof(Schema));
+    if (schema == NULL) return NULL;
+
+    schema->numAttr = numAttr;
+    schema->attrNames = attrNames;
+    schema->dataTypes = dataTypes;
+    schema->typeLength = typeLength;
+    schema->keySize = keySize;
+    schema->keyAttrs = keys;
+    if (initSchemaLayout(schema) != RC_OK) {
+        free(schema);
+        return NULL;
+    }
+    return schema;
+}
+
+// Free a schema and everything it owns
+extern RC freeSchema(Schema *schema) {
+    if (schema == NULL) return RC_OK;
+    for (int i = 0; i < schema->numAttr; i++) free(schema->attrNames[i]);
+    free(schema->attrNames);
+    free(schema->dataTypes);
+    free(schema->typeLength);
+    free(schema->keyAttrs);
+    free(schema->attrOffsets);
+    free(schema->attrSizes);
+    free(schema);
+    return RC_OK;
+}
+
+/******************************** Attribute Functions *********************************/
+
+// Create an empty record of the schema
+extern RC createRecord(Record **record, Schema *schema) {
+    Record *result = (Record *)malloc(sizeof(Record));
+    if (result == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    result->data = (char *)calloc(schema->recordSize, 1);
+    if (result->data == NULL) {
+        free(result);
+        return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    result->id.page = -1;
+    result->id.slot = -1;
+    *record = result;
+    return RC_OK;
+}
+
+// Free a record and its data
+extern RC freeRecord(Record *record) {
+    if (record == NULL) return RC_OK;
+    free(record->data);
+    free(record);
+    return RC_OK;
+}
+
+// Create an empty record in an arena; it lives until the arena is reset and is not freed with freeRecord
+extern RC createRecordInArena(Record **record, Schema *schema, Arena *arena) {
+    Record *result = (Record *)arenaAlloc(arena, sizeof(Record));
+    if (result == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    result->data = (char *)arenaAlloc(arena, schema->recordSize);
+    if (result->data == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    memset(result->data, 0, schema->recordSize);
+    result->id.page = -1;
+    result->id.slot = -1;
+    *record = result;
+    return RC_OK;
+}
+
+// Copy one attribute of a record into result; a string goes to string, which has room for
+// the attribute and its NUL
+static void readAttrValue(Record *record, Schema *schema, int attrNum, Value *result, char *string) {
+    char *data = record->data + schema->attrOffsets[attrNum];
+    result->dt = schema->dataTypes[attrNum];
+
+    switch (result->dt) {
+        case DT_INT:
+            memcpy(&result->v.intV, data, sizeof(int));
+            break;
+        case DT_FLOAT:
+            memcpy(&result->v.floatV, data, sizeof(float));
+            break;
+        case DT_BOOL:
+            memcpy(&result->v.boolV, data, sizeof(bool));
+            break;
+        case DT_STRING:
+            memcpy(string, data, schema->typeLength[attrNum]);
+            string[schema->typeLength[attrNum]] = '\0';
+            result->v.stringV = string;
+            break;
+    }
+}
+
+// Read one attribute of a record into a new value; strings are copied and NUL terminated
+extern RC getAttr(Record *record, Schema *schema, int attrNum, Value **value) {
+    if (attrNum < 0 || attrNum >= schema->numAttr) return RC_ERROR;
+
+    Value *result = (Value *)malloc(sizeof(Value));
+    if (result == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    char *string = NULL;
+    if (schema->dataTypes[attrNum] == DT_STRING) {
+        string = (char *)malloc(schema->typeLength[attrNum] + 1);
+        if (string == NULL) {
+            free(result);
+            return RC_MEMORY_ALLOCATION_FAILED;
+        }
+    }
+    readAttrValue(record, schema, attrNum, result, string);
+    *value = result;
+    return RC_OK;
+}
+
+// Like getAttr, but the value and its string live in the arena until it is reset; the value
+// must not be passed to freeVal
+extern RC getAttrInArena(Record *record, Schema *schema, int attrNum, Arena *arena, Value **value) {
+    if (attrNum < 0 || attrNum >= schema->numAttr) return RC_ERROR;
+
+    Value *result = (Value *)arenaAlloc(arena, sizeof(Value));
+    if (result == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+
+    char *string = NULL;
+    if (schema->dataTypes[attrNum] == DT_STRING) {
+        string = (char *)arenaAlloc(arena, schema->typeLength[attrNum] + 1);
+        if (string == NULL) return RC_MEMORY_ALLOCATION_FAILED;
+    }
+    readAttrValue(record, schema, attrNum, result, string);
+    *value = result;
+    return RC_OK;
+}
+
+// Write one attribute of a record; strings longer than the attribute are cut off
+extern RC setAttr(Record *record, Schema *schema, int attrNum, Value *value) {
+    if (attrNum < 0 || attrNum >= schema->numAttr) return RC_ERROR;
+    if (value->dt != schema->dataTypes[attrNum]) return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+
+    char *data = record->data + schema->attrOffsets[attrNum];
+    switch (value->dt) {
+        case DT_INT:
+            memcpy(data, &value->v.intV, sizeof(int));
+            break;
+        case DT_FLOAT:
+            memcpy(data, &value->v.floatV, sizeof(float));
+            break;
+        case DT_BOOL:
+            memcpy(data, &value->v.boolV, sizeof(bool));
+            break;
+        case DT_STRING:
+            strncpy(data, value->v.stringV, schema->typeLength[attrNum]);
+            break;
+    }
+    return RC_OK;
+}
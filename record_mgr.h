@@ -12,25 +12,91 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// How records are laid out on data pages
+typedef enum RM_Layout {
+	RM_LAYOUT_ROW = 0,	// one record after the other
+	RM_LAYOUT_PAX = 1,	// column by column within each page
+	RM_LAYOUT_SLOTTED = 2	// at their actual length behind a slot directory, strings without their padding
+} RM_Layout;
+
+// A record read in place: on a row table its data points into the page, which stays pinned
+// until releaseRecordRef; other layouts and tables with dictionary-encoded attributes gather
+// it into a copy. The data must not be written.
+typedef struct RM_RecordRef
+{
+	Record record;
+	RM_TableData *rel;
+	bool pinned;		// record.data is inside a pinned page, not a copy
+} RM_RecordRef;
+
+// Kinds of index a table can keep
+typedef enum RM_IndexType {
+	RM_INDEX_BTREE = 0,	// ordered, serves equality and range lookups
+	RM_INDEX_HASH = 1	// extendible hashing, equality lookups only
+} RM_IndexType;
+
+#define RM_MAX_INDEX_NAME 32
+#define RM_MAX_INDEX_ATTRS 16
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithLayout (char *name, Schema *schema, RM_Layout layout);
+// the listed string attributes are stored as int codes into a per-table dictionary of their
+// distinct strings; a scan compares them with string constants for equality on the codes
+extern RC createTableWithDictionary (char *name, Schema *schema, RM_Layout layout, int numEncoded, int *encodedAttrs);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
+// write the table header and the changed pages of an open table to disk
+extern RC checkpointTable (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC getRecords (RM_TableData *rel, RID *ids, int numIds, Record **records);
+extern RC getRecordRef (RM_TableData *rel, RID id, RM_RecordRef *ref);
+extern RC releaseRecordRef (RM_RecordRef *ref);
 
-// scans
+// indexes on attributes of an open table, kept up to date by every write
+extern RC createIndex (RM_TableData *rel, char *indexName, int numAttrs, int *attrs, RM_IndexType type, bool unique);
+// included attributes are stored in the entries, a scan that needs no other column never reads the table
+extern RC createCoveringIndex (RM_TableData *rel, char *indexName, int numAttrs, int *attrs, int numIncluded, int *included,
+                               RM_IndexType type, bool unique);
+extern RC dropIndex (RM_TableData *rel, char *indexName);
+
+// lookup through a unique index on the schema key, a hash index if the table has one
+extern RC getRecordByKey (RM_TableData *rel, Value **key, Record *record);
+
+// statistics sampled from the table and kept on its header page; scans use them to skip
+// an index when most of the table would match
+extern RC analyzeTable (RM_TableData *rel);
+extern double estimateSelectivity (RM_TableData *rel, Expr *cond);
+
+// moving records off sparse tail pages and shrinking the file, in steps of at most maxMoves records
+extern RC compactTable (RM_TableData *rel, int maxMoves, bool *done);
+
+// loading delimited rows directly into table pages
+extern RC bulkLoadTable (RM_TableData *rel, FILE *input, char delimiter, int *numLoaded);
+
+// scans, an index on the attributes cond compares with constants is used when there is one
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
+extern RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numAttrs);
+extern Schema *getScanSchema (RM_ScanHandle *scan);
+// cond is evaluated in arena, which the scan resets after every record and at closeScan
+extern RC startScanInArena (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, Arena *arena);
+
+// Called by the worker threads of a parallel scan for every matching record, possibly
+// concurrently. The record is only valid during the call; a result other than RC_OK stops the scan.
+typedef RC (*RM_ScanCallback) (Record *record, int worker, void *context);
+extern RC parallelScan (RM_TableData *rel, Expr *cond, int numWorkers, RM_ScanCallback callback, void *context);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
@@ -40,7 +106,9 @@ extern RC freeSchema (Schema *schema);
 // dealing with records and attribute values
 extern RC createRecord (Record **record, Schema *schema);
 extern RC freeRecord (Record *record);
+extern RC createRecordInArena (Record **record, Schema *schema, Arena *arena);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
+extern RC getAttrInArena (Record *record, Schema *schema, int attrNum, Arena *arena, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
 
 #endif // RECORD_MGR_H
@@ -18,7 +18,7 @@ typedef struct VarString {
 			var = (VarString *) malloc(sizeof(VarString));	\
 			var->size = 0;					\
 			var->bufsize = 100;					\
-			var->buf = calloc(100,0);				\
+			var->buf = calloc(100,1);				\
 		} while (0)
 
 #define FREE_VARSTRING(var)			\
@@ -49,6 +49,7 @@ typedef struct VarString {
 				int newbufsize = var->bufsize;				\
 				while((newbufsize *= 2) < newsize);			\
 				var->buf = realloc(var->buf, newbufsize);			\
+				var->bufsize = newbufsize;					\
 			}								\
 		} while (0)
 
@@ -148,6 +149,102 @@ serializeSchema(Schema *schema)
 	RETURN_STRING(result);
 }
 
+Schema *
+deserializeSchema(char *serialized)
+{
+	int i, numAttr, keySize = 0, pos;
+	char *cur = serialized;
+	Schema *result;
+
+	if (sscanf(cur, "Schema with <%i> attributes (%n", &numAttr, &pos) != 1 || numAttr <= 0)
+		return NULL;
+	cur += pos;
+
+	char **attrNames = (char **) calloc(numAttr, sizeof(char *));
+	DataType *dataTypes = (DataType *) malloc(sizeof(DataType) * numAttr);
+	int *typeLength = (int *) malloc(sizeof(int) * numAttr);
+	int *keys = (int *) malloc(sizeof(int) * numAttr);
+
+	if (attrNames == NULL || dataTypes == NULL || typeLength == NULL || keys == NULL)
+		goto fail;
+
+	for(i = 0; i < numAttr; i++)
+	{
+		int nameLen = strcspn(cur, ":");
+		if (cur[nameLen] != ':')
+			goto fail;
+		attrNames[i] = (char *) malloc(nameLen + 1);
+		if (attrNames[i] == NULL)
+			goto fail;
+		memcpy(attrNames[i], cur, nameLen);
+		attrNames[i][nameLen] = '\0';
+		cur += nameLen + 2;
+
+		typeLength[i] = 0;
+		if (strncmp(cur, "INT", 3) == 0)
+		{
+			dataTypes[i] = DT_INT;
+			cur += 3;
+		}
+		else if (strncmp(cur, "FLOAT", 5) == 0)
+		{
+			dataTypes[i] = DT_FLOAT;
+			cur += 5;
+		}
+		else if (strncmp(cur, "BOOL", 4) == 0)
+		{
+			dataTypes[i] = DT_BOOL;
+			cur += 4;
+		}
+		else if (sscanf(cur, "STRING[%i]%n", &typeLength[i], &pos) == 1)
+		{
+			dataTypes[i] = DT_STRING;
+			cur += pos;
+		}
+		else
+			goto fail;
+
+		if (i + 1 < numAttr)
+		{
+			if (strncmp(cur, ", ", 2) != 0)
+				goto fail;
+			cur += 2;
+		}
+	}
+
+	if (strncmp(cur, ") with keys: (", 14) != 0)
+		goto fail;
+	cur += 14;
+
+	while (*cur != ')' && *cur != '\0')
+	{
+		size_t nameLen = strcspn(cur, ",)");
+		for(i = 0; i < numAttr; i++)
+			if (strlen(attrNames[i]) == nameLen && strncmp(attrNames[i], cur, nameLen) == 0)
+				break;
+		if (i == numAttr || keySize == numAttr)
+			goto fail;
+		keys[keySize++] = i;
+		cur += nameLen;
+		if (strncmp(cur, ", ", 2) == 0)
+			cur += 2;
+	}
+
+	result = createSchema(numAttr, attrNames, dataTypes, typeLength, keySize, keys);
+	if (result != NULL)
+		return result;
+
+fail:
+	if (attrNames != NULL)
+		for(i = 0; i < numAttr; i++)
+			free(attrNames[i]);
+	free(attrNames);
+	free(dataTypes);
+	free(typeLength);
+	free(keys);
+	return NULL;
+}
+
 char * 
 serializeRecord(Record *record, Schema *schema)
 {
@@ -246,11 +343,10 @@ serializeValue(Value *val)
 	RETURN_STRING(result);
 }
 
-Value *
-stringToValue(char *val)
+// parses val into result; a string value is copied into string, which has strlen(val) bytes
+static void
+parseValue(char *val, Value *result, char *string)
 {
-	Value *result = (Value *) malloc(sizeof(Value));
-
 	switch(val[0])
 	{
 	case 'i':
@@ -263,7 +359,7 @@ stringToValue(char *val)
 		break;
 	case 's':
 		result->dt = DT_STRING;
-		result->v.stringV = malloc(strlen(val));
+		result->v.stringV = string;
 		strcpy(result->v.stringV, val + 1);
 		break;
 	case 'b':
@@ -275,7 +371,29 @@ stringToValue(char *val)
 		result->v.intV = -1;
 		break;
 	}
+}
 
+Value *
+stringToValue(char *val)
+{
+	Value *result = (Value *) malloc(sizeof(Value));
+
+	parseValue(val, result, (val[0] == 's') ? malloc(strlen(val)) : NULL);
+	return result;
+}
+
+// like stringToValue, but the value lives in the arena and must not be passed to freeVal
+Value *
+stringToValueInArena(char *val, Arena *arena)
+{
+	Value *result = (Value *) arenaAlloc(arena, sizeof(Value));
+	char *string = NULL;
+
+	if (result == NULL)
+		return NULL;
+	if (val[0] == 's' && (string = (char *) arenaAlloc(arena, strlen(val))) == NULL)
+		return NULL;
+	parseValue(val, result, string);
 	return result;
 }
 
@@ -283,26 +401,6 @@ stringToValue(char *val)
 RC 
 attrOffset (Schema *schema, int attrNum, int *result)
 {
-	int offset = 0;
-	int attrPos = 0;
-
-	for(attrPos = 0; attrPos < attrNum; attrPos++)
-		switch (schema->dataTypes[attrPos])
-		{
-		case DT_STRING:
-			offset += schema->typeLength[attrPos];
-			break;
-		case DT_INT:
-			offset += sizeof(int);
-			break;
-		case DT_FLOAT:
-			offset += sizeof(float);
-			break;
-		case DT_BOOL:
-			offset += sizeof(bool);
-			break;
-		}
-
-	*result = offset;
+	*result = schema->attrOffsets[attrNum];
 	return RC_OK;
 }
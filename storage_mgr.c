@@ -2,6 +2,7 @@
 #include "dberror.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 // dummy function, as it has no use we have left it empty
 void initStorageManager (){ } // empty as we have no use for this
@@ -251,6 +252,34 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 }
 
 
+RC writeBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPages)
+{
+    /*Verifying if file is open for writing*/
+    if(fHandle -> mgmtInfo == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    if(pageNum < 0 || numPages < 0) return RC_READ_NON_EXISTING_PAGE;
+
+    /*Pages may extend the file, but must start at or before its end*/
+    if(pageNum > fHandle -> totalNumPages)
+    {
+        RC status = ensureCapacity(pageNum, fHandle);
+        if(status != RC_OK) return status;
+    }
+
+    /*Moving file pointer to the first page*/
+    long sum = (long)pageNum * PAGE_SIZE;
+    if(fseek(fHandle -> mgmtInfo, sum, SEEK_SET) != 0) return RC_WRITE_FAILED;
+
+    /*Writing all pages with a single sequential write*/
+    if(fwrite(memPages, PAGE_SIZE, numPages, fHandle -> mgmtInfo) != (size_t) numPages) return RC_WRITE_FAILED;
+
+    /*Updating page count and current page position*/
+    if(pageNum + numPages > fHandle -> totalNumPages) fHandle -> totalNumPages = pageNum + numPages;
+    fHandle -> curPagePos = pageNum + numPages - 1;
+
+    return RC_OK;
+}
+
+
 RC appendEmptyBlock (SM_FileHandle *fHandle)
 {
     /*Verifying if file is open for writing*/
@@ -328,4 +357,24 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
     free(emptPage);
 
     return RC_OK;
-}
\ No newline at end of file
+}
+
+RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle)
+{
+    /*Verifying if file is open for writing*/
+    if(fHandle -> mgmtInfo == NULL) return RC_FILE_HANDLE_NOT_INIT;
+    if(numberOfPages < 1) return RC_WRITE_FAILED;
+
+    /*Checking if the file is already short enough*/
+    if(numberOfPages >= fHandle -> totalNumPages) return RC_OK;
+
+    /*Writing out buffered data before cutting the file*/
+    if(fflush(fHandle -> mgmtInfo) != 0) return RC_WRITE_FAILED;
+    if(ftruncate(fileno(fHandle -> mgmtInfo), (off_t)numberOfPages * PAGE_SIZE) != 0) return RC_WRITE_FAILED;
+
+    /*Updating total number of pages in file*/
+    fHandle -> totalNumPages = numberOfPages;
+    if(fHandle -> curPagePos >= numberOfPages) fHandle -> curPagePos = numberOfPages - 1;
+
+    return RC_OK;
+}
@@ -2,6 +2,7 @@
 #define TABLES_H
 
 #include "dt.h"
+#include "arena.h"
 
 // Data Types, Records, and Schemas
 typedef enum DataType {
@@ -41,6 +42,9 @@ typedef struct Schema
 	int *typeLength;
 	int *keyAttrs;
 	int keySize;
+	int *attrOffsets;	// byte offset of each attribute in a record
+	int *attrSizes;		// bytes each attribute takes in a record
+	int recordSize;
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
@@ -81,9 +85,11 @@ typedef struct RM_TableData
 
 // debug and read methods
 extern Value *stringToValue (char *value);
+extern Value *stringToValueInArena (char *value, Arena *arena);
 extern char *serializeTableInfo(RM_TableData *rel);
 extern char *serializeTableContent(RM_TableData *rel);
 extern char *serializeSchema(Schema *schema);
+extern Schema *deserializeSchema(char *serialized);
 extern char *serializeRecord(Record *record, Schema *schema);
 extern char *serializeAttr(Record *record, Schema *schema, int attrNum);
 extern char *serializeValue(Value *val);
@@ -1,11 +1,18 @@
 #include <stdlib.h>
+#include <pthread.h>
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "bm_trace.h"
 #include "tables.h"
 #include "test_helper.h"
 
 
+// pages per free-space-map group as record_mgr.c lays them out: the map page and the data pages it covers
+#define FSM_GROUP (PAGE_SIZE / (int) sizeof(unsigned short) + 1)
+
 #define ASSERT_EQUALS_RECORDS(_l,_r, schema, message)			\
 		do {									\
 			Record *_lR = _l;                                                   \
@@ -55,6 +62,33 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testSlotBitmap (void);
+static void testFreeSpaceReuse (void);
+static void testBatchInsertAndGet (void);
+static void testPageLayouts (void);
+static void testZoneMaps (void);
+static void testIndexes (void);
+static void testIndexScans (void);
+static void testCompaction (void);
+static void testHeaderPersistence (void);
+static void testRecordRefs (void);
+static void testDictionary (void);
+static void testStatistics (void);
+static void testParallelScan (void);
+static void testFullPool (void);
+static void testBulkLoad (void);
+static void testPrefetch (void);
+static void testPageTrace (void);
+
+// results a parallel scan gathers from its workers
+typedef struct ScanTotals {
+	pthread_mutex_t lock;
+	int count;
+	long sum;
+	bool badWorker;
+	int numWorkers;
+	Schema *schema;
+} ScanTotals;
 
 // struct for test records
 typedef struct TestRecord {
@@ -66,7 +100,17 @@ typedef struct TestRecord {
 // helper methods
 Record *testRecord(Schema *schema, int a, char *b, int c);
 Schema *testSchema (void);
+Schema *testSchemaWithLength (int length);
 Record *fromTestRecord (Schema *schema, TestRecord in);
+Expr *attrCompare (int attr, OpType op, char *constant);
+int countRecords (RM_TableData *table, Expr *cond);
+int filePages (char *name);
+int headerTuples (char *name);
+RC addToTotals (Record *record, int worker, void *context);
+void scanTotals (RM_TableData *table, Expr *cond, int *count, long *sum);
+void assertSelectivity (RM_TableData *table, Expr *cond, double expected, double tolerance, char *message);
+void writeRows (FILE *out, int from, int to, char delimiter);
+int checkLoadedRows (RM_TableData *table, int from, int to);
 
 // test name
 char *testName;
@@ -84,6 +128,23 @@ main (void)
 	testScans();
 	testScansTwo();
 	testMultipleScans();
+	testSlotBitmap();
+	testFreeSpaceReuse();
+	testBatchInsertAndGet();
+	testPageLayouts();
+	testZoneMaps();
+	testIndexes();
+	testIndexScans();
+	testCompaction();
+	testHeaderPersistence();
+	testRecordRefs();
+	testDictionary();
+	testStatistics();
+	testParallelScan();
+	testFullPool();
+	testBulkLoad();
+	testPrefetch();
+	testPageTrace();
 
 	return 0;
 }
@@ -616,59 +677,1475 @@ void testScansTwo (void)
 }
 
 
-Schema *
-testSchema (void)
+// ************************************************************
+void
+testSlotBitmap (void)
 {
-	Schema *result;
-	char *names[] = { "a", "b", "c" };
-	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
-	int sizes[] = { 0, 4, 0 };
-	int keys[] = {0};
-	int i;
-	char **cpNames = (char **) malloc(sizeof(char*) * 3);
-	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
-	int *cpSizes = (int *) malloc(sizeof(int) * 3);
-	int *cpKeys = (int *) malloc(sizeof(int));
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 2000, numLeft = 0, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	testName = "test slot bitmap with deleted slots and zero-valued records";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_b",schema));
+	TEST_CHECK(openTable(table, "test_table_b"));
+
+	// every third record is all zero bytes apart from its key, the first one entirely
+	for(i = 0; i < numInserts; i++)
+	{
+		r = (i % 3 == 0) ? testRecord(schema, i, "", 0) : testRecord(schema, i, "ab", i);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "every record counted");
+
+	// free every fifth slot, freeing it twice is an error
+	for(i = 0; i < numInserts; i += 5)
+		TEST_CHECK(deleteRecord(table,rids[i]));
+	ASSERT_ERROR(deleteRecord(table,rids[0]), "delete a free slot");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_b"));
+
+	createRecord(&r, schema);
+	for(i = 0; i < numInserts; i++)
+	{
+		if (i % 5 == 0)
+		{
+			ASSERT_EQUALS_INT(RC_NO_TUPLE_RID, getRecord(table, rids[i], r), "deleted slot is free");
+			continue;
+		}
+		TEST_CHECK(getRecord(table, rids[i], r));
+		ASSERT_EQUALS_RECORDS((i % 3 == 0) ? testRecord(schema, i, "", 0) : testRecord(schema, i, "ab", i), r, schema, "compare records");
+		numLeft++;
+	}
+	ASSERT_EQUALS_INT(numLeft, countRecords(table, NULL), "scan skips free slots");
+	ASSERT_EQUALS_INT(numLeft, getNumTuples(table), "tuples after reopen");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_b"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreeSpaceReuse (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, round, lastPage, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	testName = "test free-space map reusing deleted slots";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_f",schema));
+	TEST_CHECK(openTable(table, "test_table_f"));
+
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "ffff", i);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	lastPage = rids[numInserts - 1].page;
 
+	// emptying and refilling the table must not grow it
+	for(round = 0; round < 3; round++)
+	{
+		for(i = 0; i < numInserts; i++)
+			TEST_CHECK(deleteRecord(table,rids[i]));
+		for(i = 0; i < numInserts; i++)
+		{
+			r = testRecord(schema, i, "ffff", i);
+			TEST_CHECK(insertRecord(table,r));
+			rids[i] = r->id;
+			freeRecord(r);
+		}
+		ASSERT_EQUALS_INT(lastPage, rids[numInserts - 1].page, "refilled table ends on the same page");
+	}
+
+	// a slot freed in the middle of the table is taken by the next insert, also after a reopen
+	TEST_CHECK(deleteRecord(table,rids[10]));
+	r = testRecord(schema, numInserts, "ffff", 0);
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(rids[10].page, r->id.page, "insert reuses the freed slot's page");
+	freeRecord(r);
+
+	TEST_CHECK(deleteRecord(table,rids[1500]));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_f"));
+	r = testRecord(schema, numInserts + 1, "ffff", 0);
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(rids[1500].page, r->id.page, "free space map survives a reopen");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_f"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchInsertAndGet (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 500, i;
+	Record *batch[500], *results[500], *more[3];
+	RID rids[500], reversed[500];
+	Schema *schema;
+	testName = "test inserting and getting records in batches";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_g",schema));
+	TEST_CHECK(openTable(table, "test_table_g"));
+
+	for(i = 0; i < numInserts; i++)
+		batch[i] = testRecord(schema, i, "gggg", i % 10);
+	TEST_CHECK(insertRecords(table, batch, numInserts));
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "batch inserted");
+
+	// fetch the batch back in reverse order
+	for(i = 0; i < numInserts; i++)
+	{
+		rids[i] = batch[i]->id;
+		reversed[i] = batch[numInserts - 1 - i]->id;
+		createRecord(&results[i], schema);
+	}
+	TEST_CHECK(getRecords(table, reversed, numInserts, results));
+	for(i = 0; i < numInserts; i++)
+	{
+		ASSERT_TRUE(memcmp(results[i]->data, batch[numInserts - 1 - i]->data, getRecordSize(schema)) == 0, "compare batched records");
+		ASSERT_TRUE(results[i]->id.page == reversed[i].page && results[i]->id.slot == reversed[i].slot, "record id set");
+	}
+
+	// a duplicate key ends the batch, the records before it stay inserted
+	more[0] = testRecord(schema, numInserts, "gggg", 0);
+	more[1] = testRecord(schema, 3, "gggg", 0);
+	more[2] = testRecord(schema, numInserts + 1, "gggg", 0);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecords(table, more, 3), "duplicate key in a batch");
+	ASSERT_EQUALS_INT(numInserts + 1, getNumTuples(table), "records before the duplicate inserted");
+	ASSERT_EQUALS_INT(numInserts + 1, countRecords(table, NULL), "scan sees the partial batch");
+
+	// a deleted record fails the lookup batch
+	TEST_CHECK(deleteRecord(table, rids[7]));
+	ASSERT_EQUALS_INT(RC_NO_TUPLE_RID, getRecords(table, rids, numInserts, results), "batch with a deleted record");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_g"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+	{
+		freeRecord(batch[i]);
+		freeRecord(results[i]);
+	}
 	for(i = 0; i < 3; i++)
+		freeRecord(more[i]);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPageLayouts (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_Layout layouts[] = { RM_LAYOUT_ROW, RM_LAYOUT_PAX, RM_LAYOUT_SLOTTED };
+	char *strings[] = { "", "a", "bb", "cccc" };
+	int numInserts = 2000, numLeft, layout, i;
+	Record *r;
+	RID *rids;
+	bool *deleted;
+	Schema *schema;
+	testName = "test row, PAX and slotted page layouts";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	deleted = (bool *) malloc(sizeof(bool) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	for(layout = 0; layout < 3; layout++)
 	{
-		cpNames[i] = (char *) malloc(2);
-		strcpy(cpNames[i], names[i]);
+		TEST_CHECK(createTableWithLayout("test_table_l", schema, layouts[layout]));
+		TEST_CHECK(openTable(table, "test_table_l"));
+
+		for(i = 0; i < numInserts; i++)
+		{
+			r = testRecord(schema, i, strings[i % 4], i % 50);
+			TEST_CHECK(insertRecord(table,r));
+			rids[i] = r->id;
+			deleted[i] = FALSE;
+			freeRecord(r);
+		}
+
+		// grow every third string to full length, a slotted page may move the record
+		for(i = 0; i < numInserts; i += 3)
+		{
+			r = testRecord(schema, i, strings[3], -i);
+			r->id = rids[i];
+			TEST_CHECK(updateRecord(table,r));
+			rids[i] = r->id;
+			freeRecord(r);
+		}
+		for(i = 0; i < numInserts; i += 7)
+		{
+			TEST_CHECK(deleteRecord(table,rids[i]));
+			deleted[i] = TRUE;
+		}
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(openTable(table, "test_table_l"));
+
+		createRecord(&r, schema);
+		numLeft = 0;
+		for(i = 0; i < numInserts; i++)
+		{
+			if (deleted[i])
+				continue;
+			TEST_CHECK(getRecord(table, rids[i], r));
+			ASSERT_EQUALS_RECORDS((i % 3 == 0) ? testRecord(schema, i, strings[3], -i) : testRecord(schema, i, strings[i % 4], i % 50),
+					r, schema, "compare records");
+			numLeft++;
+		}
+		ASSERT_EQUALS_INT(numLeft, countRecords(table, NULL), "scan returns every record");
+		freeRecord(r);
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(deleteTable("test_table_l"));
 	}
-	memcpy(cpDt, dt, sizeof(DataType) * 3);
-	memcpy(cpSizes, sizes, sizeof(int) * 3);
-	memcpy(cpKeys, keys, sizeof(int));
+	TEST_CHECK(shutdownRecordManager());
 
-	result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+	free(rids);
+	free(deleted);
+	free(table);
+	TEST_DONE();
+}
 
-	return result;
+// ************************************************************
+void
+testZoneMaps (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	FILE *zoneFile;
+	testName = "test scans skipping pages by their zone maps";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_z",schema));
+	TEST_CHECK(openTable(table, "test_table_z"));
+
+	// keys in insertion order give every page a narrow range on a
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "zzzz", i % 10);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+
+	sel = attrCompare(0, OP_COMP_SMALLER, "i100");
+	ASSERT_EQUALS_INT(100, countRecords(table, sel), "a < 100");
+	freeExpr(sel);
+	MAKE_CONS(left, stringToValue("i2900"));
+	MAKE_ATTRREF(right, 0);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	ASSERT_EQUALS_INT(99, countRecords(table, sel), "2900 < a");
+	freeExpr(sel);
+	sel = attrCompare(0, OP_COMP_EQUAL, "i5000");
+	ASSERT_EQUALS_INT(0, countRecords(table, sel), "a = 5000 is outside every zone");
+	freeExpr(sel);
+
+	// an update far outside its page's range widens the zone
+	r = testRecord(schema, -7, "zzzz", 0);
+	r->id = rids[1500];
+	TEST_CHECK(updateRecord(table,r));
+	freeRecord(r);
+	sel = attrCompare(0, OP_COMP_EQUAL, "i-7");
+	ASSERT_EQUALS_INT(1, countRecords(table, sel), "a = -7 after the update");
+
+	zoneFile = fopen("test_table_z.zm", "rb");
+	ASSERT_TRUE(zoneFile != NULL, "zone map file exists");
+	fclose(zoneFile);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	ASSERT_EQUALS_INT(1, countRecords(table, sel), "a = -7 after reopen");
+	freeExpr(sel);
+	sel = attrCompare(0, OP_COMP_SMALLER, "i100");
+	ASSERT_EQUALS_INT(101, countRecords(table, sel), "a < 100 after reopen");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_z"));
+	TEST_CHECK(shutdownRecordManager());
+	zoneFile = fopen("test_table_z.zm", "rb");
+	ASSERT_TRUE(zoneFile == NULL, "zone map file deleted with the table");
+
+	free(rids);
+	free(table);
+	TEST_DONE();
 }
 
-Record *
-fromTestRecord (Schema *schema, TestRecord in)
+// ************************************************************
+void
+testIndexes (void)
 {
-	return testRecord(schema, in.a, in.b, in.c);
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 5000, attrB = 1, attrC = 2, i;
+	char b[5];
+	Record *r;
+	Value *key, *value;
+	Schema *schema;
+	Expr *sel;
+	testName = "test B+-tree and hash indexes";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_i",schema));
+	TEST_CHECK(openTable(table, "test_table_i"));
+
+	// the primary key index on a is a B+-tree, c gets a unique hash index
+	TEST_CHECK(createIndex(table, "c_hash", 1, &attrC, RM_INDEX_HASH, TRUE));
+	TEST_CHECK(createIndex(table, "b_tree", 1, &attrB, RM_INDEX_BTREE, FALSE));
+	ASSERT_ERROR(createIndex(table, "c_hash", 1, &attrC, RM_INDEX_HASH, FALSE), "index name taken");
+
+	// enough keys to split tree nodes and hash buckets many times
+	for(i = 0; i < numInserts; i++)
+	{
+		sprintf(b, "%d", i % 100);
+		r = testRecord(schema, i, b, i * 3);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	r = testRecord(schema, 17, "x", -1);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table,r), "duplicate primary key");
+	freeRecord(r);
+	r = testRecord(schema, numInserts, "x", 30);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table,r), "duplicate unique hash key");
+	freeRecord(r);
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "rejected records not inserted");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_i"));
+
+	// every key is still found after reopening
+	createRecord(&r, schema);
+	for(i = 0; i < numInserts; i += 7)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &key, r));
+		getAttr(r, schema, 2, &value);
+		ASSERT_EQUALS_INT(i * 3, value->v.intV, "record found by key");
+		freeVal(value);
+		freeVal(key);
+	}
+	MAKE_VALUE(key, DT_INT, numInserts);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, getRecordByKey(table, &key, r), "missing key");
+	freeVal(key);
+	freeRecord(r);
+
+	r = testRecord(schema, 17, "x", -1);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table,r), "duplicate primary key after reopen");
+	freeRecord(r);
+	r = testRecord(schema, numInserts, "x", 30);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertRecord(table,r), "duplicate unique hash key after reopen");
+	freeRecord(r);
+
+	sel = attrCompare(2, OP_COMP_EQUAL, "i300");
+	ASSERT_EQUALS_INT(1, countRecords(table, sel), "c = 300 through the hash index");
+	freeExpr(sel);
+	sel = attrCompare(1, OP_COMP_EQUAL, "s42");
+	ASSERT_EQUALS_INT(numInserts / 100, countRecords(table, sel), "b = '42' through the tree");
+	freeExpr(sel);
+
+	// a deleted key can be inserted again
+	MAKE_VALUE(key, DT_INT, 10);
+	createRecord(&r, schema);
+	TEST_CHECK(getRecordByKey(table, &key, r));
+	TEST_CHECK(deleteRecord(table, r->id));
+	freeRecord(r);
+	r = testRecord(schema, 10, "x", 30);
+	TEST_CHECK(insertRecord(table,r));
+	freeRecord(r);
+	freeVal(key);
+
+	TEST_CHECK(dropIndex(table, "b_tree"));
+	ASSERT_EQUALS_INT(RC_RM_INDEX_NOT_FOUND, dropIndex(table, "b_tree"), "index already dropped");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_i"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(table);
+	TEST_DONE();
 }
 
-Record *
-testRecord(Schema *schema, int a, char *b, int c)
+// ************************************************************
+void
+testIndexScans (void)
 {
-	Record *result;
-	Value *value;
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, attrB = 1, attrC = 2, projection[] = { 1, 2 }, a, i, j, rc, zz;
+	int counts[4];
+	char b[5];
+	Record *r;
+	Value *key, *value;
+	Schema *schema, *projected;
+	Expr *conds[4];
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	testName = "test scans driven by secondary and covering indexes";
+	schema = testSchema();
 
-	TEST_CHECK(createRecord(&result, schema));
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_x",schema));
+	TEST_CHECK(openTable(table, "test_table_x"));
 
-	MAKE_VALUE(value, DT_INT, a);
-	TEST_CHECK(setAttr(result, schema, 0, value));
-	freeVal(value);
+	// shuffled keys, so pages do not hold narrow ranges of any attribute
+	for(i = 0; i < numInserts; i++)
+	{
+		a = (int) ((i * 7919L) % numInserts);
+		sprintf(b, "s%d", a % 20);
+		r = testRecord(schema, a, b, a % 100);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
 
-	MAKE_STRING_VALUE(value, b);
-	TEST_CHECK(setAttr(result, schema, 1, value));
+	conds[0] = attrCompare(2, OP_COMP_EQUAL, "i7");
+	conds[1] = attrCompare(2, OP_COMP_SMALLER, "i5");
+	conds[2] = attrCompare(1, OP_COMP_EQUAL, "ss3");
+	MAKE_BINOP_EXPR(conds[3], attrCompare(1, OP_COMP_EQUAL, "ss3"), attrCompare(2, OP_COMP_EQUAL, "i3"), OP_BOOL_AND);
+	for(j = 0; j < 4; j++)
+		counts[j] = countRecords(table, conds[j]);
+	ASSERT_EQUALS_INT(30, counts[0], "c = 7 by scanning");
+	ASSERT_EQUALS_INT(150, counts[1], "c < 5 by scanning");
+	ASSERT_EQUALS_INT(150, counts[2], "b = 's3' by scanning");
+	ASSERT_EQUALS_INT(30, counts[3], "b = 's3' and c = 3 by scanning");
+
+	// the same conditions answered through the indexes
+	TEST_CHECK(createIndex(table, "c_tree", 1, &attrC, RM_INDEX_BTREE, FALSE));
+	TEST_CHECK(createIndex(table, "b_hash", 1, &attrB, RM_INDEX_HASH, FALSE));
+	for(j = 0; j < 4; j++)
+		ASSERT_EQUALS_INT(counts[j], countRecords(table, conds[j]), "same result through an index");
+
+	// a covering index answers a projection on b and c without reading the table
+	TEST_CHECK(dropIndex(table, "c_tree"));
+	TEST_CHECK(createCoveringIndex(table, "c_cover", 1, &attrC, 1, &attrB, RM_INDEX_BTREE, FALSE));
+
+	MAKE_VALUE(key, DT_INT, 7);
+	createRecord(&r, schema);
+	TEST_CHECK(getRecordByKey(table, &key, r));
+	MAKE_STRING_VALUE(value, "zz");
+	TEST_CHECK(setAttr(r, schema, 1, value));
+	TEST_CHECK(updateRecord(table, r));
 	freeVal(value);
+	freeVal(key);
+	freeRecord(r);
 
-	MAKE_VALUE(value, DT_INT, c);
-	TEST_CHECK(setAttr(result, schema, 2, value));
-	freeVal(value);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_x"));
+
+	TEST_CHECK(startProjectedScan(table, sc, conds[0], projection, 2));
+	projected = getScanSchema(sc);
+	createRecord(&r, projected);
+	i = 0;
+	zz = 0;
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		getAttr(r, projected, 1, &value);
+		ASSERT_EQUALS_INT(7, value->v.intV, "covered c");
+		freeVal(value);
+		getAttr(r, projected, 0, &value);
+		if (strcmp(value->v.stringV, "zz") == 0)
+			zz++;
+		else
+			ASSERT_EQUALS_STRING("s7", value->v.stringV, "covered b");
+		freeVal(value);
+		i++;
+	}
+	if (rc != RC_RM_NO_MORE_TUPLES)
+		TEST_CHECK(rc);
+	TEST_CHECK(closeScan(sc));
+	freeRecord(r);
+	ASSERT_EQUALS_INT(counts[0], i, "covered scan returns every match");
+	ASSERT_EQUALS_INT(1, zz, "covered scan sees the updated value");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_x"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(j = 0; j < 4; j++)
+		freeExpr(conds[j]);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompaction (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, numLeft = 0, pagesBefore, steps = 0, rc, i;
+	Record *r;
+	RID *rids;
+	Value *key;
+	Schema *schema;
+	bool done = FALSE;
+	testName = "test compacting a table and reopening it";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_c",schema));
+	TEST_CHECK(openTable(table, "test_table_c"));
+
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "cccc", i % 10);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	// keep every fifth record of the first two thirds
+	for(i = 0; i < numInserts; i++)
+	{
+		if (i % 5 == 0 && i < 2000)
+			numLeft++;
+		else
+			TEST_CHECK(deleteRecord(table,rids[i]));
+	}
+	TEST_CHECK(closeTable(table));
+	pagesBefore = filePages("test_table_c");
+	TEST_CHECK(openTable(table, "test_table_c"));
+
+	while(!done)
+	{
+		TEST_CHECK(compactTable(table, 100, &done));
+		steps++;
+	}
+	ASSERT_TRUE(steps > 1, "compaction ran in several steps");
+
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(filePages("test_table_c") < pagesBefore, "file shrunk");
+	TEST_CHECK(openTable(table, "test_table_c"));
+
+	ASSERT_EQUALS_INT(numLeft, getNumTuples(table), "tuples after compaction");
+	ASSERT_EQUALS_INT(numLeft, countRecords(table, NULL), "scan after compaction");
+	createRecord(&r, schema);
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		rc = getRecordByKey(table, &key, r);
+		if (i % 5 == 0 && i < 2000)
+		{
+			TEST_CHECK(rc);
+			ASSERT_EQUALS_RECORDS(testRecord(schema, i, "cccc", i % 10), r, schema, "moved record");
+		}
+		else
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "deleted record stays deleted");
+		freeVal(key);
+	}
+	freeRecord(r);
+
+	// the compacted table takes new records
+	r = testRecord(schema, numInserts, "cccc", 0);
+	TEST_CHECK(insertRecord(table,r));
+	freeRecord(r);
+	ASSERT_EQUALS_INT(numLeft + 1, countRecords(table, NULL), "insert after compaction");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_c"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testHeaderPersistence (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	testName = "test table header kept on page 0";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_h",schema));
+	TEST_CHECK(openTable(table, "test_table_h"));
+	ASSERT_EQUALS_INT(0, headerTuples("test_table_h"), "header of a new table");
+
+	// the header is written back after enough changes, without a close
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "hhhh", i);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	ASSERT_TRUE(headerTuples("test_table_h") >= 2048, "header flushed while inserting");
+
+	for(i = 0; i < numInserts; i += 3)
+		TEST_CHECK(deleteRecord(table,rids[i]));
+	TEST_CHECK(checkpointTable(table));
+	ASSERT_EQUALS_INT(2000, headerTuples("test_table_h"), "header after checkpoint");
+
+	TEST_CHECK(closeTable(table));
+	ASSERT_EQUALS_INT(2000, headerTuples("test_table_h"), "header after close");
+	TEST_CHECK(openTable(table, "test_table_h"));
+	ASSERT_EQUALS_INT(2000, getNumTuples(table), "tuples read from the header");
+	ASSERT_EQUALS_INT(2000, countRecords(table, NULL), "header matches the records");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_h"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testRecordRefs (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_Layout layouts[] = { RM_LAYOUT_ROW, RM_LAYOUT_PAX };
+	int numInserts = 1000, layout, i;
+	Record *r;
+	RID *rids;
+	RM_RecordRef ref, refs[10];
+	Value *value;
+	Schema *schema;
+	testName = "test reading records by reference";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	for(layout = 0; layout < 2; layout++)
+	{
+		TEST_CHECK(createTableWithLayout("test_table_rr", schema, layouts[layout]));
+		TEST_CHECK(openTable(table, "test_table_rr"));
+
+		for(i = 0; i < numInserts; i++)
+		{
+			r = testRecord(schema, i, "rrrr", i * 7);
+			TEST_CHECK(insertRecord(table,r));
+			rids[i] = r->id;
+			freeRecord(r);
+		}
+
+		createRecord(&r, schema);
+		for(i = 0; i < numInserts; i++)
+		{
+			TEST_CHECK(getRecordRef(table, rids[i], &ref));
+			TEST_CHECK(getRecord(table, rids[i], r));
+			ASSERT_TRUE(memcmp(ref.record.data, r->data, getRecordSize(schema)) == 0, "reference matches the copy");
+			getAttr(&ref.record, schema, 2, &value);
+			ASSERT_EQUALS_INT(i * 7, value->v.intV, "attribute through the reference");
+			freeVal(value);
+			TEST_CHECK(releaseRecordRef(&ref));
+		}
+		freeRecord(r);
+
+		// several references held at once, only row pages are read in place
+		for(i = 0; i < 10; i++)
+			TEST_CHECK(getRecordRef(table, rids[i * 100], &refs[i]));
+		ASSERT_EQUALS_INT(layouts[layout] == RM_LAYOUT_ROW, refs[0].pinned, "row records are not copied");
+		for(i = 0; i < 10; i++)
+			TEST_CHECK(releaseRecordRef(&refs[i]));
+
+		TEST_CHECK(deleteRecord(table, rids[1]));
+		ASSERT_EQUALS_INT(RC_NO_TUPLE_RID, getRecordRef(table, rids[1], &ref), "reference to a deleted record");
+		TEST_CHECK(releaseRecordRef(&ref));
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(deleteTable("test_table_rr"));
+	}
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testDictionary (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_Layout layouts[] = { RM_LAYOUT_ROW, RM_LAYOUT_PAX, RM_LAYOUT_SLOTTED };
+	char *strings[] = { "aaaa", "bbbb", "cc", "d" };
+	int numInserts = 1000, encoded[] = { 1 }, layout, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	Expr *sel;
+	FILE *dictFile;
+	testName = "test dictionary-encoded string attributes";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	for(layout = 0; layout < 3; layout++)
+	{
+		TEST_CHECK(createTableWithDictionary("test_table_d", schema, layouts[layout], 1, encoded));
+		TEST_CHECK(openTable(table, "test_table_d"));
+
+		for(i = 0; i < numInserts; i++)
+		{
+			r = testRecord(schema, i, strings[i % 4], i % 10);
+			TEST_CHECK(insertRecord(table,r));
+			rids[i] = r->id;
+			freeRecord(r);
+		}
+
+		// a string the dictionary has not seen yet
+		r = testRecord(schema, 5, "new", 5);
+		r->id = rids[5];
+		TEST_CHECK(updateRecord(table,r));
+		rids[5] = r->id;
+		freeRecord(r);
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(openTable(table, "test_table_d"));
+
+		createRecord(&r, schema);
+		for(i = 0; i < numInserts; i += 13)
+		{
+			TEST_CHECK(getRecord(table, rids[i], r));
+			ASSERT_EQUALS_RECORDS(testRecord(schema, i, strings[i % 4], i % 10), r, schema, "decoded record");
+		}
+		TEST_CHECK(getRecord(table, rids[5], r));
+		ASSERT_EQUALS_RECORDS(testRecord(schema, 5, "new", 5), r, schema, "updated record");
+		freeRecord(r);
+
+		sel = attrCompare(1, OP_COMP_EQUAL, "sbbbb");
+		ASSERT_EQUALS_INT(numInserts / 4 - 1, countRecords(table, sel), "b = 'bbbb' on the codes");
+		freeExpr(sel);
+		sel = attrCompare(1, OP_COMP_EQUAL, "snew");
+		ASSERT_EQUALS_INT(1, countRecords(table, sel), "b = 'new'");
+		freeExpr(sel);
+		sel = attrCompare(1, OP_COMP_EQUAL, "szzzz");
+		ASSERT_EQUALS_INT(0, countRecords(table, sel), "b = 'zzzz' is not in the dictionary");
+		freeExpr(sel);
+		sel = attrCompare(1, OP_COMP_SMALLER, "sc");
+		ASSERT_EQUALS_INT(numInserts / 2 - 1, countRecords(table, sel), "b < 'c' on the strings");
+		freeExpr(sel);
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(deleteTable("test_table_d"));
+		dictFile = fopen("test_table_d.dict", "rb");
+		ASSERT_TRUE(dictFile == NULL, "dictionary deleted with the table");
+	}
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testFullPool (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PageHandle handles[3];
+	BM_PoolStats stats;
+	ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU };
+	PageNumber *frames;
+	int strategy, i;
+	testName = "test pinning a page into a pool of fixed frames";
+
+	TEST_CHECK(createPageFile("test_pool.bin"));
+	for(strategy = 0; strategy < 4; strategy++)
+	{
+		TEST_CHECK(initBufferPool(bm, "test_pool.bin", 3, strategies[strategy], NULL));
+		for(i = 0; i < 3; i++)
+			TEST_CHECK(pinPage(bm, &handles[i], i));
+
+		// no victim, so the page is neither read nor counted as a miss
+		TEST_CHECK(resetPoolStats(bm));
+		ASSERT_EQUALS_INT(RC_Pinned_page_in_buffer, pinPage(bm, h, 3), "every frame fixed");
+		ASSERT_TRUE(h->data == NULL, "no page handed out");
+		TEST_CHECK(getPoolStats(bm, &stats));
+		ASSERT_TRUE(stats.misses == 0 && stats.pagesRead == 0 && stats.readLatency.count == 0, "failed pin did no I/O");
+
+		// once a frame is free the page replaces it
+		TEST_CHECK(unpinPage(bm, &handles[0]));
+		TEST_CHECK(pinPage(bm, h, 3));
+		TEST_CHECK(getPoolStats(bm, &stats));
+		ASSERT_TRUE(stats.misses == 1 && stats.pagesRead == 1 && stats.cleanEvictions == 1, "one read for the pin");
+		frames = getFrameContents(bm);
+		ASSERT_EQUALS_INT(3, frames[0], "page 0 was the victim");
+		free(frames);
+
+		TEST_CHECK(unpinPage(bm, h));
+		for(i = 1; i < 3; i++)
+			TEST_CHECK(unpinPage(bm, &handles[i]));
+		TEST_CHECK(shutdownBufferPool(bm));
+	}
+	TEST_CHECK(destroyPageFile("test_pool.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testStatistics (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	char *strings[] = { "aaaa", "bbbb", "cccc", "dddd" };
+	int numInserts = 3000, i;
+	Record *r;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	testName = "test table statistics and selectivity estimates";
+	schema = testSchema();
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_s",schema));
+	TEST_CHECK(openTable(table, "test_table_s"));
+
+	// a is unique, b takes 4 values and c 100, each equally often
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, strings[i % 4], i % 100);
+		TEST_CHECK(insertRecord(table,r));
+		freeRecord(r);
+	}
+
+	// without statistics the fixed guesses apply
+	sel = attrCompare(0, OP_COMP_EQUAL, "i5");
+	assertSelectivity(table, sel, 0.1, 0.0001, "a = 5 guessed");
+	freeExpr(sel);
+	sel = attrCompare(0, OP_COMP_SMALLER, "i5");
+	assertSelectivity(table, sel, 1.0 / 3, 0.0001, "a < 5 guessed");
+	freeExpr(sel);
+
+	TEST_CHECK(analyzeTable(table));
+
+	// equality follows the distinct-value estimates
+	sel = attrCompare(0, OP_COMP_EQUAL, "i1234");
+	assertSelectivity(table, sel, 1.0 / numInserts, 0.1 / numInserts, "a = 1234, 3000 distinct values");
+	freeExpr(sel);
+	sel = attrCompare(2, OP_COMP_EQUAL, "i7");
+	assertSelectivity(table, sel, 0.01, 0.001, "c = 7, 100 distinct values");
+	freeExpr(sel);
+	sel = attrCompare(1, OP_COMP_EQUAL, "sbbbb");
+	assertSelectivity(table, sel, 0.25, 0.03, "b = 'bbbb', 4 distinct values");
+	freeExpr(sel);
+	sel = attrCompare(0, OP_COMP_EQUAL, "i5000");
+	assertSelectivity(table, sel, 0, 0, "a = 5000 is above the maximum");
+	freeExpr(sel);
+
+	// ranges follow the histograms
+	sel = attrCompare(0, OP_COMP_SMALLER, "i300");
+	assertSelectivity(table, sel, 0.1, 0.02, "a < 300");
+	freeExpr(sel);
+	MAKE_CONS(left, stringToValue("i1500"));
+	MAKE_ATTRREF(right, 0);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	assertSelectivity(table, sel, 0.5, 0.02, "1500 < a");
+	freeExpr(sel);
+	sel = attrCompare(2, OP_COMP_SMALLER, "i25");
+	assertSelectivity(table, sel, 0.25, 0.03, "c < 25");
+	freeExpr(sel);
+	MAKE_BINOP_EXPR(sel, attrCompare(2, OP_COMP_EQUAL, "i7"), attrCompare(0, OP_COMP_SMALLER, "i300"), OP_BOOL_AND);
+	assertSelectivity(table, sel, 0.001, 0.0003, "c = 7 and a < 300");
+	freeExpr(sel);
+
+	// the statistics are kept on the header page
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_s"));
+	sel = attrCompare(2, OP_COMP_EQUAL, "i7");
+	assertSelectivity(table, sel, 0.01, 0.001, "c = 7 after reopen");
+	freeExpr(sel);
+	sel = attrCompare(0, OP_COMP_SMALLER, "i300");
+	assertSelectivity(table, sel, 0.1, 0.02, "a < 300 after reopen");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_s"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testParallelScan (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_Layout layouts[] = { RM_LAYOUT_ROW, RM_LAYOUT_PAX, RM_LAYOUT_ROW };
+	char *strings[] = { "aaaa", "bbbb", "cccc", "dddd" };
+	int numInserts = 20000, encoded[] = { 1 }, workers[] = { 1, 3, 64 }, count, table_kind, c, w, i;
+	long sum;
+	Record *r;
+	Schema *schema;
+	Expr *conds[4];
+	ScanTotals totals;
+	testName = "test parallel scans against sequential scans";
+	schema = testSchema();
+
+	conds[0] = NULL;
+	conds[1] = attrCompare(2, OP_COMP_EQUAL, "i7");
+	conds[2] = attrCompare(0, OP_COMP_SMALLER, "i500");	// zone maps skip all but the first pages
+	conds[3] = attrCompare(1, OP_COMP_EQUAL, "sbbbb");
+
+	TEST_CHECK(initRecordManager(NULL));
+	// row and PAX tables, then a row table with b dictionary-encoded
+	for(table_kind = 0; table_kind < 3; table_kind++)
+	{
+		if (table_kind < 2)
+		{
+			TEST_CHECK(createTableWithLayout("test_table_p", schema, layouts[table_kind]));
+		}
+		else
+		{
+			TEST_CHECK(createTableWithDictionary("test_table_p", schema, layouts[table_kind], 1, encoded));
+		}
+		TEST_CHECK(openTable(table, "test_table_p"));
+
+		// the pages stay dirty in the pool, the parallel scan reads them from the file
+		for(i = 0; i < numInserts; i++)
+		{
+			r = testRecord(schema, i, strings[i % 4], i % 100);
+			TEST_CHECK(insertRecord(table,r));
+			freeRecord(r);
+		}
+
+		for(c = 0; c < 4; c++)
+		{
+			scanTotals(table, conds[c], &count, &sum);
+			// 64 workers are more than the table has morsels
+			for(w = 0; w < 3; w++)
+			{
+				pthread_mutex_init(&totals.lock, NULL);
+				totals.count = 0;
+				totals.sum = 0;
+				totals.badWorker = FALSE;
+				totals.numWorkers = workers[w];
+				totals.schema = schema;
+				TEST_CHECK(parallelScan(table, conds[c], workers[w], addToTotals, &totals));
+				pthread_mutex_destroy(&totals.lock);
+				ASSERT_EQUALS_INT(count, totals.count, "parallel scan returns what a scan does");
+				ASSERT_TRUE(sum == totals.sum, "parallel scan returns the same records");
+				ASSERT_TRUE(!totals.badWorker, "worker numbers in range");
+			}
+		}
+
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(deleteTable("test_table_p"));
+	}
+	TEST_CHECK(shutdownRecordManager());
+
+	for(c = 1; c < 4; c++)
+		freeExpr(conds[c]);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBulkLoad (void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numFirst = 500, numSecond = 10000, numGood = 20, loaded, lastPage, total, rc, i;
+	char b[16];
+	FILE *csv;
+	Record *r;
+	Value *key;
+	Schema *schema;
+	testName = "test bulk loading a table from delimited rows";
+	// a handful of records per page, so the second load runs past the second free-space-map page
+	schema = testSchemaWithLength(1000);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_b",schema));
+	TEST_CHECK(openTable(table, "test_table_b"));
+
+	// an empty table is loaded from its first data page on
+	csv = fopen("test_bulk.csv", "w");
+	writeRows(csv, 0, numFirst, ',');
+	fclose(csv);
+	csv = fopen("test_bulk.csv", "r");
+	TEST_CHECK(bulkLoadTable(table, csv, ',', &loaded));
+	fclose(csv);
+	ASSERT_EQUALS_INT(numFirst, loaded, "rows loaded into an empty table");
+	ASSERT_EQUALS_INT(numFirst, getNumTuples(table), "tuples after the first load");
+	createRecord(&r, schema);
+	MAKE_VALUE(key, DT_INT, 0);
+	TEST_CHECK(getRecordByKey(table, &key, r));
+	freeVal(key);
+	ASSERT_TRUE(r->id.page == 2 && r->id.slot == 0, "first row on the first data page");
+	freeRecord(r);
+	checkLoadedRows(table, 0, numFirst);
+
+	TEST_CHECK(closeTable(table));
+	ASSERT_EQUALS_INT(numFirst, headerTuples("test_table_b"), "header after the first load");
+	TEST_CHECK(openTable(table, "test_table_b"));
+	ASSERT_EQUALS_INT(numFirst, countRecords(table, NULL), "scan after the first load");
+	checkLoadedRows(table, 0, numFirst);
+
+	// appended rows go after the pages in use, across the next free-space-map page
+	sprintf(b, "row%d", numFirst);
+	r = testRecord(schema, numFirst, b, numFirst * 2);
+	TEST_CHECK(insertRecord(table,r));
+	freeRecord(r);
+	csv = fopen("test_bulk.csv", "w");
+	writeRows(csv, numFirst + 1, numFirst + 1 + numSecond, ',');
+	fclose(csv);
+	csv = fopen("test_bulk.csv", "r");
+	TEST_CHECK(bulkLoadTable(table, csv, ',', &loaded));
+	fclose(csv);
+	total = numFirst + 1 + numSecond;
+	ASSERT_EQUALS_INT(numSecond, loaded, "rows appended");
+	ASSERT_EQUALS_INT(total, getNumTuples(table), "tuples after the append");
+	lastPage = checkLoadedRows(table, 0, total);
+	ASSERT_TRUE(lastPage > 1 + FSM_GROUP, "load crossed a free-space-map group");
+
+	TEST_CHECK(closeTable(table));
+	ASSERT_EQUALS_INT(total, headerTuples("test_table_b"), "header after the append");
+	TEST_CHECK(openTable(table, "test_table_b"));
+	ASSERT_EQUALS_INT(total, countRecords(table, NULL), "scan after the append");
+	checkLoadedRows(table, 0, total);
+
+	// a bad row stops the load, the rows before it stay
+	csv = fopen("test_bulk.csv", "w");
+	writeRows(csv, total, total + numGood, ',');
+	fprintf(csv, "%d,bad,x\n", total + numGood);
+	writeRows(csv, total + numGood + 1, total + 2 * numGood, ',');
+	fclose(csv);
+	csv = fopen("test_bulk.csv", "r");
+	rc = bulkLoadTable(table, csv, ',', &loaded);
+	ASSERT_EQUALS_INT(RC_BULK_LOAD_PARSE_ERROR, rc, "parse error");
+	fclose(csv);
+	ASSERT_EQUALS_INT(numGood, loaded, "rows before the bad one");
+	total += numGood;
+	ASSERT_EQUALS_INT(total, getNumTuples(table), "tuples after the parse error");
+	checkLoadedRows(table, total - numGood, total);
+	createRecord(&r, schema);
+	for(i = total; i < total + numGood + 1; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, getRecordByKey(table, &key, r), "rows from the bad one on not loaded");
+		freeVal(key);
+	}
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	ASSERT_EQUALS_INT(total, headerTuples("test_table_b"), "header after the parse error");
+	TEST_CHECK(openTable(table, "test_table_b"));
+	ASSERT_EQUALS_INT(total, countRecords(table, NULL), "scan after the parse error");
+	checkLoadedRows(table, 0, total);
+	TEST_CHECK(closeTable(table));
+
+	// the command line loader appends to the closed table and fails on a bad row
+	csv = fopen("test_bulk.csv", "w");
+	writeRows(csv, total, total + numGood, ';');
+	fclose(csv);
+	ASSERT_TRUE(system("./bulk_load test_table_b test_bulk.csv ';' > /dev/null 2>&1") == 0, "bulk_load succeeded");
+	csv = fopen("test_bulk.csv", "w");
+	fprintf(csv, "%d;bad\n", total + numGood);
+	fclose(csv);
+	ASSERT_TRUE(system("./bulk_load test_table_b test_bulk.csv ';' > /dev/null 2>&1") != 0, "bulk_load reports the bad row");
+	total += numGood;
+
+	TEST_CHECK(openTable(table, "test_table_b"));
+	ASSERT_EQUALS_INT(total, getNumTuples(table), "tuples after bulk_load");
+	ASSERT_EQUALS_INT(total, countRecords(table, NULL), "scan after bulk_load");
+	checkLoadedRows(table, 0, total);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_b"));
+	TEST_CHECK(shutdownRecordManager());
+	remove("test_bulk.csv");
+
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPrefetch (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PoolStats stats;
+	SM_FileHandle fh;
+	PageNumber pages[] = { 1, 2, 3, 5, 20 };
+	testName = "test prefetching pages into the pool";
+
+	TEST_CHECK(createPageFile("test_prefetch.bin"));
+	TEST_CHECK(openPageFile("test_prefetch.bin", &fh));
+	TEST_CHECK(ensureCapacity(8, &fh));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(initBufferPool(bm, "test_prefetch.bin", 4, RS_FIFO, NULL));
+
+	// page 1 is in a frame and page 20 is past the end of the file, 2, 3 and 5 are hinted
+	TEST_CHECK(pinPage(bm, h, 1));
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(prefetchPages(bm, pages, 5));
+	ASSERT_EQUALS_INT(1, getNumPrefetchResident(bm), "resident page not prefetched");
+	ASSERT_EQUALS_INT(3, getNumPrefetchIssued(bm), "pages handed to the disk");
+
+	// the first pin of a hinted page uses the read-ahead, a page that was resident does not
+	TEST_CHECK(pinPage(bm, h, 3));
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(pinPage(bm, h, 1));
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(getPoolStats(bm, &stats));
+	ASSERT_TRUE(stats.readAheadUsed == 1, "one prefetched page used");
+
+	// page 3 is resident now
+	TEST_CHECK(prefetchPages(bm, &pages[2], 1));
+	ASSERT_EQUALS_INT(2, getNumPrefetchResident(bm), "prefetched page now resident");
+	ASSERT_EQUALS_INT(3, getNumPrefetchIssued(bm), "nothing more handed to the disk");
+
+	TEST_CHECK(shutdownBufferPool(bm));
+	TEST_CHECK(destroyPageFile("test_prefetch.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testPageTrace (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_TraceHeader header;
+	BM_TraceRecord record;
+	FILE *trace;
+	char line[128];
+	int pins[] = { 0, 1, 0, 2, 3, 1 }, numPins = 6, numRecords = 0, i;
+	bool pagesMatch = TRUE, hitsMatch = TRUE, simulated = FALSE;
+	testName = "test recording a page access trace";
+
+	TEST_CHECK(createPageFile("test_trace.bin"));
+	TEST_CHECK(initBufferPool(bm, "test_trace.bin", 3, RS_LRU, NULL));
+
+	// only the second pin of page 0 is a hit, page 1 is evicted by page 3 before its second pin
+	TEST_CHECK(startPageTrace(bm, "test_trace.trace"));
+	for(i = 0; i < numPins; i++)
+	{
+		TEST_CHECK(pinPage(bm, h, pins[i]));
+		TEST_CHECK(unpinPage(bm, h));
+	}
+	TEST_CHECK(stopPageTrace(bm));
+	TEST_CHECK(pinPage(bm, h, 0));	// not recorded once the trace stopped
+	TEST_CHECK(unpinPage(bm, h));
+
+	trace = fopen("test_trace.trace", "rb");
+	ASSERT_TRUE(trace != NULL, "trace file written");
+	ASSERT_TRUE(fread(&header, sizeof(BM_TraceHeader), 1, trace) == 1, "trace header read");
+	ASSERT_TRUE(memcmp(header.magic, BM_TRACE_MAGIC, sizeof(header.magic)) == 0, "trace magic");
+	ASSERT_EQUALS_INT(PAGE_SIZE, header.pageSize, "trace page size");
+	ASSERT_EQUALS_INT(3, header.numFrames, "trace pool size");
+	ASSERT_EQUALS_INT(RS_LRU, header.strategy, "trace strategy");
+	while(fread(&record, sizeof(BM_TraceRecord), 1, trace) == 1)
+	{
+		if (numRecords < numPins && record.pageNum != pins[numRecords])
+			pagesMatch = FALSE;
+		if (((record.timeDelta & BM_TRACE_HIT_BIT) != 0) != (numRecords == 2))
+			hitsMatch = FALSE;
+		numRecords++;
+	}
+	fclose(trace);
+	ASSERT_EQUALS_INT(numPins, numRecords, "one record per pin");
+	ASSERT_TRUE(pagesMatch, "pages in pin order");
+	ASSERT_TRUE(hitsMatch, "hit bit set on the hit only");
+
+	// replaying the trace with the recording policy and pool size gives the same hit
+	trace = popen("./trace_sim test_trace.trace 3", "r");
+	ASSERT_TRUE(trace != NULL, "trace_sim started");
+	ASSERT_TRUE(fgets(line, sizeof(line), trace) != NULL, "trace_sim summary");
+	line[strcspn(line, "\n")] = '\0';
+	ASSERT_EQUALS_STRING("# 6 accesses, 4 distinct pages, recorded with 3 frames: hit ratio 0.1667", line, "trace_sim summary");
+	while(fgets(line, sizeof(line), trace) != NULL)
+		if (strcmp(line, "LRU,3,1,5,0.1667\n") == 0)
+			simulated = TRUE;
+	ASSERT_TRUE(pclose(trace) == 0, "trace_sim succeeded");
+	ASSERT_TRUE(simulated, "simulated LRU matches the pool");
+
+	TEST_CHECK(shutdownBufferPool(bm));
+	TEST_CHECK(destroyPageFile("test_trace.bin"));
+	remove("test_trace.trace");
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+Schema *
+testSchema (void)
+{
+	return testSchemaWithLength(4);
+}
+
+// the test schema with a wider string attribute b
+Schema *
+testSchemaWithLength (int length)
+{
+	Schema *result;
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+	int sizes[] = { 0, length, 0 };
+	int keys[] = {0};
+	int i;
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) malloc(sizeof(int));
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	memcpy(cpKeys, keys, sizeof(int));
+
+	result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
 
 	return result;
 }
+
+Record *
+fromTestRecord (Schema *schema, TestRecord in)
+{
+	return testRecord(schema, in.a, in.b, in.c);
+}
+
+Record *
+testRecord(Schema *schema, int a, char *b, int c)
+{
+	Record *result;
+	Value *value;
+
+	TEST_CHECK(createRecord(&result, schema));
+
+	MAKE_VALUE(value, DT_INT, a);
+	TEST_CHECK(setAttr(result, schema, 0, value));
+	freeVal(value);
+
+	MAKE_STRING_VALUE(value, b);
+	TEST_CHECK(setAttr(result, schema, 1, value));
+	freeVal(value);
+
+	MAKE_VALUE(value, DT_INT, c);
+	TEST_CHECK(setAttr(result, schema, 2, value));
+	freeVal(value);
+
+	return result;
+}
+
+Expr *
+attrCompare (int attr, OpType op, char *constant)
+{
+	Expr *result, *left, *right;
+
+	MAKE_ATTRREF(left, attr);
+	MAKE_CONS(right, stringToValue(constant));
+	MAKE_BINOP_EXPR(result, left, right, op);
+
+	return result;
+}
+
+int
+countRecords (RM_TableData *table, Expr *cond)
+{
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Record *r;
+	int count = 0, rc;
+
+	TEST_CHECK(createRecord(&r, table->schema));
+	TEST_CHECK(startScan(table, sc, cond));
+	while((rc = next(sc, r)) == RC_OK)
+		count++;
+	if (rc != RC_RM_NO_MORE_TUPLES)
+		TEST_CHECK(rc);
+	TEST_CHECK(closeScan(sc));
+
+	freeRecord(r);
+	free(sc);
+	return count;
+}
+
+int
+filePages (char *name)
+{
+	SM_FileHandle fh;
+	int pages;
+
+	TEST_CHECK(openPageFile(name, &fh));
+	pages = fh.totalNumPages;
+	TEST_CHECK(closePageFile(&fh));
+
+	return pages;
+}
+
+// tuple count as page 0 holds it: the header starts with a 4 byte magic
+int
+headerTuples (char *name)
+{
+	SM_FileHandle fh;
+	SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+	int tuples;
+
+	TEST_CHECK(openPageFile(name, &fh));
+	TEST_CHECK(readBlock(0, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	memcpy(&tuples, page + 4, sizeof(int));
+
+	free(page);
+	return tuples;
+}
+
+void
+assertSelectivity (RM_TableData *table, Expr *cond, double expected, double tolerance, char *message)
+{
+	double estimate = estimateSelectivity(table, cond);
+
+	if (estimate < expected - tolerance || estimate > expected + tolerance)
+	{
+		printf("[%s-%s-L%i-%s] FAILED: expected <%f> within <%f> but was <%f>: %s\n", TEST_INFO, expected, tolerance, estimate, message);
+		exit(1);
+	}
+	printf("[%s-%s-L%i-%s] OK: expected <%f> and was <%f>: %s\n", TEST_INFO, expected, estimate, message);
+}
+
+// callback of parallelScan, sums up the keys of the records
+RC
+addToTotals (Record *record, int worker, void *context)
+{
+	ScanTotals *totals = (ScanTotals *) context;
+	Value *value;
+
+	getAttr(record, totals->schema, 0, &value);
+	pthread_mutex_lock(&totals->lock);
+	totals->count++;
+	totals->sum += value->v.intV;
+	if (worker < 0 || worker >= totals->numWorkers)
+		totals->badWorker = TRUE;
+	pthread_mutex_unlock(&totals->lock);
+	freeVal(value);
+
+	return RC_OK;
+}
+
+// number of records and sum of their keys returned by a sequential scan
+void
+scanTotals (RM_TableData *table, Expr *cond, int *count, long *sum)
+{
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	Record *r;
+	Value *value;
+	int rc;
+
+	*count = 0;
+	*sum = 0;
+	TEST_CHECK(createRecord(&r, table->schema));
+	TEST_CHECK(startScan(table, sc, cond));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		getAttr(r, table->schema, 0, &value);
+		(*count)++;
+		*sum += value->v.intV;
+		freeVal(value);
+	}
+	if (rc != RC_RM_NO_MORE_TUPLES)
+		TEST_CHECK(rc);
+	TEST_CHECK(closeScan(sc));
+
+	freeRecord(r);
+	free(sc);
+}
+
+// writes the rows a<delimiter>row<a><delimiter>2a for the keys from up to to
+void
+writeRows (FILE *out, int from, int to, char delimiter)
+{
+	int i;
+
+	for(i = from; i < to; i++)
+		fprintf(out, "%d%crow%d%c%d\n", i, delimiter, i, delimiter, i * 2);
+}
+
+// finds the rows of writeRows by key and returns the highest page they are on; rows are
+// loaded in key order, so their RIDs grow and none is on a free-space-map page
+int
+checkLoadedRows (RM_TableData *table, int from, int to)
+{
+	Record *r;
+	Value *key, *b, *c;
+	RID last = { 0, -1 };
+	char expected[16];
+	int i;
+	bool rowsMatch = TRUE, ridsMatch = TRUE;
+
+	TEST_CHECK(createRecord(&r, table->schema));
+	for(i = from; i < to; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		TEST_CHECK(getRecordByKey(table, &key, r));
+		freeVal(key);
+
+		getAttr(r, table->schema, 1, &b);
+		getAttr(r, table->schema, 2, &c);
+		sprintf(expected, "row%d", i);
+		if (strcmp(b->v.stringV, expected) != 0 || c->v.intV != i * 2)
+			rowsMatch = FALSE;
+		freeVal(b);
+		freeVal(c);
+
+		if (r->id.page < 2 || (r->id.page - 1) % FSM_GROUP == 0)
+			ridsMatch = FALSE;
+		if (r->id.page < last.page || (r->id.page == last.page && r->id.slot <= last.slot))
+			ridsMatch = FALSE;
+		last = r->id;
+	}
+	freeRecord(r);
+
+	ASSERT_TRUE(rowsMatch, "loaded rows found by key");
+	ASSERT_TRUE(ridsMatch, "loaded rows on data pages in key order");
+	return last.page;
+}
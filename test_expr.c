@@ -29,6 +29,10 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testArenaExpressions (void);
+
+// helper methods
+static int arenaBlocks (Arena *arena);
 
 char *testName;
 
@@ -41,6 +45,7 @@ main (void)
 	testValueSerialize();
 	testOperators();
 	testExpressions();
+	testArenaExpressions();
 
 	return 0;
 }
@@ -123,3 +128,82 @@ testExpressions (void)
 
 	TEST_DONE();
 }
+
+// ************************************************************
+void
+testArenaExpressions (void)
+{
+	Arena arena;
+	Expr *op, *cmp, *l, *r;
+	Value *res;
+	Record *record;
+	Schema *schema;
+	char *names[] = { "a", "b" };
+	DataType dt[] = { DT_INT, DT_STRING };
+	int sizes[] = { 0, 4 };
+	int keys[] = { 0 };
+	int round, blocks = 0, wrong = 0, i;
+	testName = "test values and expressions in an arena";
+
+	TEST_CHECK(initArena(&arena, 256));
+
+	// values parsed into the arena
+	ASSERT_EQUALS_STRING(serializeValue(stringToValueInArena("i10", &arena)), "10", "arena Value 10");
+	ASSERT_EQUALS_STRING(serializeValue(stringToValueInArena("f5.3", &arena)), "5.300000", "arena Value 5.3");
+	ASSERT_EQUALS_STRING(serializeValue(stringToValueInArena("sHello World", &arena)), "Hello World", "arena Value Hello World");
+	ASSERT_EQUALS_STRING(serializeValue(stringToValueInArena("bt", &arena)), "true", "arena Value true");
+
+	schema = createSchema(2, names, dt, sizes, 1, keys);
+	TEST_CHECK(createRecord(&record, schema));
+	TEST_CHECK(setAttr(record, schema, 0, stringToValue("i7")));
+	TEST_CHECK(setAttr(record, schema, 1, stringToValue("sab")));
+
+	TEST_CHECK(getAttrInArena(record, schema, 1, &arena, &res));
+	ASSERT_EQUALS_STRING("ab", res->v.stringV, "string attribute in the arena");
+	TEST_CHECK(getAttrInArena(record, schema, 0, &arena, &res));
+	ASSERT_EQUALS_INT(7, res->v.intV, "int attribute in the arena");
+
+	// b = 'ab' AND a < 10
+	MAKE_ATTRREF(l, 1);
+	MAKE_CONS(r, stringToValue("sab"));
+	MAKE_BINOP_EXPR(cmp, l, r, OP_COMP_EQUAL);
+	MAKE_ATTRREF(l, 0);
+	MAKE_CONS(r, stringToValue("i10"));
+	MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+	r = op;
+	MAKE_BINOP_EXPR(op, cmp, r, OP_BOOL_AND);
+
+	// every round allocates as much as the first, which takes several blocks that are reused
+	for(round = 0; round < 100; round++)
+	{
+		resetArena(&arena);
+		for(i = 0; i < 20; i++)
+		{
+			TEST_CHECK(evalExprInArena(record, schema, op, &arena, &res));
+			if (res->dt != DT_BOOL || !res->v.boolV)
+				wrong++;
+		}
+		if (round == 0)
+			blocks = arenaBlocks(&arena);
+	}
+	ASSERT_EQUALS_INT(0, wrong, "b = 'ab' AND a < 10 in every round");
+	ASSERT_TRUE(blocks > 1, "a round fills several blocks");
+	ASSERT_EQUALS_INT(blocks, arenaBlocks(&arena), "blocks reused after a reset");
+
+	freeExpr(op);
+	freeRecord(record);
+	freeArena(&arena);
+	ASSERT_TRUE(arena.first == NULL, "blocks freed");
+	TEST_DONE();
+}
+
+int
+arenaBlocks (Arena *arena)
+{
+	ArenaBlock *block;
+	int count = 0;
+
+	for(block = arena->first; block != NULL; block = block->next)
+		count++;
+	return count;
+}
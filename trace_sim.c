@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dt.h"
+#include "bm_trace.h"
+
+/*
+ * Offline replacement policy simulator.
+ *
+ * Replays a page access trace recorded with startPageTrace() against every
+ * policy in the policies table at a range of pool sizes and prints one CSV
+ * row per (policy, pool size) with the resulting hit ratio.
+ *
+ * usage: trace_sim <trace file> [pool size ...]
+ * Without pool sizes the powers of two up to the number of distinct pages are used.
+ */
+
+typedef struct SimState // one simulated buffer pool
+{
+    int numFrames; // size of the simulated pool
+    int usedFrames; // frames holding a page
+    int *framePage; // page held by each frame
+    int *pageFrame; // frame holding each page, -1 if not resident
+    long long now; // position in the trace
+    long long *lastUse; // last access per frame, used by LRU-2
+    long long *prevUse; // access before the last one per frame, used by LRU-2
+    long long *useCount; // accesses per frame since it was loaded, used by LFU
+    bool *referenced; // reference bit per frame, used by CLOCK
+    int hand; // next frame to look at for FIFO and CLOCK
+    int *prev; // LRU list, most recent at head
+    int *next;
+    int head;
+    int tail;
+
+} SimState;
+
+typedef struct SimPolicy // a replacement policy, add new policies to the policies table below
+{
+    char *name;
+    void (*access)(SimState *s, int frame, bool loaded); // called on every hit and after every load
+    int (*victim)(SimState *s); // picks the frame to replace when the pool is full
+
+} SimPolicy;
+
+/*=====================================================================LRU list helpers==========================================================================*/
+
+static void lruUnlink(SimState *s, int frame){
+    if(s->prev[frame] != -1) s->next[s->prev[frame]] = s->next[frame];
+    else s->head = s->next[frame];
+    if(s->next[frame] != -1) s->prev[s->next[frame]] = s->prev[frame];
+    else s->tail = s->prev[frame];
+}
+
+static void lruPushFront(SimState *s, int frame){
+    s->prev[frame] = -1;
+    s->next[frame] = s->head;
+    if(s->head != -1) s->prev[s->head] = frame;
+    s->head = frame;
+    if(s->tail == -1) s->tail = frame;
+}
+
+/*=====================================================================Policies==================================================================================*/
+
+// FIFO: frames are replaced in load order, hits change nothing
+static void fifoAccess(SimState *s, int frame, bool loaded){ }
+
+static int fifoVictim(SimState *s){
+    int frame = s->hand;
+    s->hand = (s->hand + 1) % s->numFrames;
+    return frame;
+}
+
+// LRU: doubly linked list, the tail is the least recently used frame
+static void lruAccess(SimState *s, int frame, bool loaded){
+    if(!loaded) lruUnlink(s, frame);
+    lruPushFront(s, frame);
+}
+
+static int lruVictim(SimState *s){
+    int frame = s->tail;
+    lruUnlink(s, frame);
+    return frame;
+}
+
+// LFU: fewest accesses since load, ties go to the lowest frame
+static void lfuAccess(SimState *s, int frame, bool loaded){
+    s->useCount[frame] = loaded ? 1 : s->useCount[frame] + 1;
+}
+
+static int lfuVictim(SimState *s){
+    int best = 0;
+    for(int i = 1; i < s->numFrames; i++){
+        if(s->useCount[i] < s->useCount[best]) best = i;
+    }
+    return best;
+}
+
+// CLOCK: second chance with one reference bit per frame
+static void clockAccess(SimState *s, int frame, bool loaded){
+    s->referenced[frame] = TRUE;
+}
+
+static int clockVictim(SimState *s){
+    while(s->referenced[s->hand]){
+        s->referenced[s->hand] = FALSE;
+        s->hand = (s->hand + 1) % s->numFrames;
+    }
+    int frame = s->hand;
+    s->hand = (s->hand + 1) % s->numFrames;
+    return frame;
+}
+
+// LRU-2: replaces the frame whose second most recent access is oldest
+static void lru2Access(SimState *s, int frame, bool loaded){
+    s->prevUse[frame] = loaded ? -1 : s->lastUse[frame];
+    s->lastUse[frame] = s->now;
+}
+
+static int lru2Victim(SimState *s){
+    int best = 0;
+    for(int i = 1; i < s->numFrames; i++){
+        if(s->prevUse[i] < s->prevUse[best] ||
+           (s->prevUse[i] == s->prevUse[best] && s->lastUse[i] < s->lastUse[best])) best = i;
+    }
+    return best;
+}
+
+static SimPolicy policies[] = {
+    { "FIFO", fifoAccess, fifoVictim },
+    { "LRU", lruAccess, lruVictim },
+    { "LFU", lfuAccess, lfuVictim },
+    { "CLOCK", clockAccess, clockVictim },
+    { "LRU-2", lru2Access, lru2Victim },
+};
+
+/*=====================================================================Simulation================================================================================*/
+
+// replays the trace of dense page ids and returns the number of hits
+static long long simulate(SimPolicy *policy, int *pages, long long numAccesses, int numDistinct, int numFrames){
+    SimState s;
+    long long hits = 0;
+
+    s.numFrames = numFrames;
+    s.usedFrames = 0;
+    s.framePage = malloc(sizeof(int) * numFrames);
+    s.pageFrame = malloc(sizeof(int) * numDistinct);
+    s.lastUse = calloc(numFrames, sizeof(long long));
+    s.prevUse = calloc(numFrames, sizeof(long long));
+    s.useCount = calloc(numFrames, sizeof(long long));
+    s.referenced = calloc(numFrames, sizeof(bool));
+    s.prev = malloc(sizeof(int) * numFrames);
+    s.next = malloc(sizeof(int) * numFrames);
+    s.head = s.tail = -1;
+    s.hand = 0;
+    for(int i = 0; i < numDistinct; i++) s.pageFrame[i] = -1;
+
+    for(s.now = 0; s.now < numAccesses; s.now++){
+        int page = pages[s.now];
+        int frame = s.pageFrame[page];
+
+        if(frame != -1){ // hit
+            hits++;
+            policy->access(&s, frame, FALSE);
+            continue;
+        }
+
+        if(s.usedFrames < numFrames) frame = s.usedFrames++; // fill empty frames first
+        else{
+            frame = policy->victim(&s);
+            s.pageFrame[s.framePage[frame]] = -1;
+        }
+        s.framePage[frame] = page;
+        s.pageFrame[page] = frame;
+        policy->access(&s, frame, TRUE);
+    }
+
+    free(s.framePage);
+    free(s.pageFrame);
+    free(s.lastUse);
+    free(s.prevUse);
+    free(s.useCount);
+    free(s.referenced);
+    free(s.prev);
+    free(s.next);
+    return hits;
+}
+
+// maps page numbers to dense ids 0..n-1 with an open addressing table
+static int densePageIds(BM_TraceRecord *records, long long numRecords, int *pages){
+    long long capacity = 1024;
+    while(capacity < numRecords * 2) capacity *= 2;
+
+    int *keys = malloc(sizeof(int) * capacity);
+    int *ids = malloc(sizeof(int) * capacity);
+    bool *used = calloc(capacity, sizeof(bool));
+    int numDistinct = 0;
+
+    for(long long i = 0; i < numRecords; i++){
+        unsigned int key = (unsigned int) records[i].pageNum;
+        long long slot = (key * 2654435761u) & (capacity - 1);
+
+        while(used[slot] && keys[slot] != records[i].pageNum) slot = (slot + 1) & (capacity - 1);
+        if(!used[slot]){
+            used[slot] = TRUE;
+            keys[slot] = records[i].pageNum;
+            ids[slot] = numDistinct++;
+        }
+        pages[i] = ids[slot];
+    }
+
+    free(keys);
+    free(ids);
+    free(used);
+    return numDistinct;
+}
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s <trace file> [pool size ...]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if(file == NULL){
+        perror(argv[1]);
+        return 1;
+    }
+
+    BM_TraceHeader header;
+    if(fread(&header, sizeof(BM_TraceHeader), 1, file) != 1 ||
+       memcmp(header.magic, BM_TRACE_MAGIC, sizeof(header.magic)) != 0){
+        fprintf(stderr, "%s: not a page access trace\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+
+    // load every record, the trace is replayed once per policy and pool size
+    long long numRecords = 0, capacity = 4096, recordedHits = 0;
+    BM_TraceRecord *records = malloc(sizeof(BM_TraceRecord) * capacity);
+    while(fread(&records[numRecords], sizeof(BM_TraceRecord), 1, file) == 1){
+        if(records[numRecords].timeDelta & BM_TRACE_HIT_BIT) recordedHits++;
+        if(++numRecords == capacity){
+            capacity *= 2;
+            records = realloc(records, sizeof(BM_TraceRecord) * capacity);
+        }
+    }
+    fclose(file);
+
+    int *pages = malloc(sizeof(int) * (numRecords + 1));
+    int numDistinct = densePageIds(records, numRecords, pages);
+    free(records);
+
+    // pool sizes from the command line, otherwise powers of two
+    int numSizes = 0;
+    int *sizes = malloc(sizeof(int) * (argc + 32));
+    for(int i = 2; i < argc; i++){
+        if(atoi(argv[i]) > 0) sizes[numSizes++] = atoi(argv[i]);
+    }
+    if(numSizes == 0){
+        for(int size = 1; size < numDistinct; size *= 2) sizes[numSizes++] = size;
+        sizes[numSizes++] = numDistinct > 0 ? numDistinct : 1;
+    }
+
+    printf("# %lld accesses, %d distinct pages, recorded with %d frames: hit ratio %.4f\n",
+           numRecords, numDistinct, header.numFrames,
+           numRecords == 0 ? 0.0 : (double) recordedHits / numRecords);
+    printf("policy,frames,hits,misses,hit_ratio\n");
+
+    for(int p = 0; p < (int)(sizeof(policies) / sizeof(SimPolicy)); p++){
+        for(int i = 0; i < numSizes; i++){
+            long long hits = simulate(&policies[p], pages, numRecords, numDistinct, sizes[i]);
+            printf("%s,%d,%lld,%lld,%.4f\n", policies[p].name, sizes[i], hits, numRecords - hits,
+                   numRecords == 0 ? 0.0 : (double) hits / numRecords);
+        }
+    }
+
+    free(pages);
+    free(sizes);
+    return 0;
+}